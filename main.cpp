@@ -1,15 +1,47 @@
 import Subcommand.Zip;
+import Subcommand.Unzip;
+import Subcommand.Cat;
+import Subcommand.Test;
+import Subcommand.Check;
+import Subcommand.Diff;
+import Subcommand.List;
+import Subcommand.Rm;
+import Subcommand.Compact;
+import Subcommand.Info;
+import Subcommand.Merge;
+import Subcommand.Recompress;
+import Subcommand.ExportGz;
+import Subcommand.Index;
 #include <CLI/CLI.hpp>
+#include <exception>
+#include <print>
 
 int main(const int argc, char *argv[]) {
   CLI::App app("一个压缩工具");
   app.require_subcommand(1);
   Subcommand::zip(app);
+  Subcommand::unzip(app);
+  Subcommand::cat(app);
+  Subcommand::test(app);
+  Subcommand::check(app);
+  Subcommand::diff(app);
+  Subcommand::list(app);
+  Subcommand::rm(app);
+  Subcommand::compact(app);
+  Subcommand::info(app);
+  Subcommand::merge(app);
+  Subcommand::recompress(app);
+  Subcommand::export_gz(app);
+  Subcommand::index(app);
 
   try {
     app.parse(argc, argv);
   } catch (const CLI::ParseError &e) {
     return app.exit(e);
+  } catch (const std::exception &e) {
+    // 工作线程里的异常在线程结束后重新抛出到这里
+    std::println("error: {}", e.what());
+    return 1;
   }
   return 0;
 }
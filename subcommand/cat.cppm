@@ -0,0 +1,44 @@
+module;
+#include <CLI/CLI.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+export module Subcommand.Cat;
+import Utils.Cat;
+
+namespace Subcommand {
+
+export void cat(CLI::App &app) {
+  auto cat_entry =
+      app.add_subcommand("cat", "把压缩包中的一个或多个文件输出到标准输出");
+  struct CatOptions {
+    std::string file;
+    std::vector<std::string> entries;
+    bool glob{false};
+  };
+  auto options = std::make_shared<CatOptions>();
+  namespace fs = std::filesystem;
+  cat_entry->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  cat_entry
+      ->add_option("entry", options->entries,
+                   "压缩包内的文件名,多个文件按压缩包中的顺序依次输出")
+      ->required();
+  cat_entry->add_flag("-g,--glob", options->glob,
+                      "把文件名当作glob模式,输出所有匹配的文件");
+
+  cat_entry->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result =
+        options->entries.size() == 1 && !options->glob
+            ? Utils::cat(zip_path, options->entries.front(), stdout)
+            : Utils::cat_entries(zip_path, options->entries, options->glob,
+                                 stdout);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
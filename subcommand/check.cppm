@@ -0,0 +1,45 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+export module Subcommand.Check;
+import Utils.Check;
+
+namespace Subcommand {
+
+export void check(CLI::App &app) {
+  auto check_dir = app.add_subcommand(
+      "check", "用中央目录的大小和CRC32比对解压后的目录,不解压数据");
+  struct CheckOptions {
+    std::string file;
+    std::string dir;
+    unsigned jobs{std::thread::hardware_concurrency()};
+    size_t memory{64};
+  };
+  auto options = std::make_shared<CheckOptions>();
+  namespace fs = std::filesystem;
+  check_dir->add_option("zip", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  check_dir->add_option("dir", options->dir, "要比对的目录")
+      ->required()
+      ->check(CLI::ExistingDirectory);
+  check_dir->add_option("-j,--jobs", options->jobs, "读取线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+  check_dir
+      ->add_option("--memory", options->memory,
+                   "所有线程读缓冲合计的大小(MiB),默认64")
+      ->check(CLI::PositiveNumber);
+
+  check_dir->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    auto dir_path = fs::weakly_canonical(fs::current_path() / options->dir);
+    const int result = Utils::check(zip_path, dir_path, options->jobs,
+                                    options->memory << 20);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
@@ -0,0 +1,30 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+export module Subcommand.Compact;
+import Utils.Archive;
+
+namespace Subcommand {
+
+export void compact(CLI::App &app) {
+  auto compact_archive =
+      app.add_subcommand("compact", "回收压缩包中已删除或被替换文件留下的空洞");
+  struct CompactOptions {
+    std::string file;
+  };
+  auto options = std::make_shared<CompactOptions>();
+  namespace fs = std::filesystem;
+  compact_archive->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+
+  compact_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result = Utils::compact(zip_path);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
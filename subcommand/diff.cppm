@@ -0,0 +1,44 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+export module Subcommand.Diff;
+import Utils.Diff;
+
+namespace Subcommand {
+
+export void diff(CLI::App &app) {
+  auto diff_archives = app.add_subcommand(
+      "diff", "只读中央目录,比较两个压缩包中新增、删除和改动的文件");
+  struct DiffOptions {
+    std::string from;
+    std::string to;
+    bool deep{false};
+    unsigned jobs{std::thread::hardware_concurrency()};
+  };
+  auto options = std::make_shared<DiffOptions>();
+  namespace fs = std::filesystem;
+  diff_archives->add_option("from", options->from, "旧的压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  diff_archives->add_option("to", options->to, "新的压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  diff_archives->add_flag("--deep", options->deep,
+                          "解压有改动的文件,按4KiB块统计差异");
+  diff_archives
+      ->add_option("-j,--jobs", options->jobs, "--deep的解压线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+
+  diff_archives->callback([options]() {
+    auto from_path = fs::weakly_canonical(fs::current_path() / options->from);
+    auto to_path = fs::weakly_canonical(fs::current_path() / options->to);
+    const int result =
+        Utils::diff(from_path, to_path, options->deep, options->jobs);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
@@ -0,0 +1,37 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+export module Subcommand.ExportGz;
+import Utils.Gzip;
+
+namespace Subcommand {
+
+export void export_gz(CLI::App &app) {
+  auto export_gz = app.add_subcommand(
+      "export-gz", "把deflate压缩的文件原样导出为.gz,不解压不重新压缩");
+  struct ExportGzOptions {
+    std::string file;
+    std::string dir;
+    unsigned jobs{std::thread::hardware_concurrency()};
+  };
+  auto options = std::make_shared<ExportGzOptions>();
+  namespace fs = std::filesystem;
+  export_gz->add_option("zip", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  export_gz->add_option("dir", options->dir, "输出目录")->required();
+  export_gz->add_option("-j,--jobs", options->jobs, "写出线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+
+  export_gz->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    auto dir_path = fs::weakly_canonical(fs::current_path() / options->dir);
+    const int result = Utils::export_gz(zip_path, dir_path, options->jobs);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
@@ -0,0 +1,30 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+export module Subcommand.Index;
+import Utils.Archive;
+
+namespace Subcommand {
+
+export void index(CLI::App &app) {
+  auto index_archive = app.add_subcommand(
+      "index", "在压缩包旁生成.zidx索引,加快之后打开和查找entry");
+  struct IndexOptions {
+    std::string file;
+  };
+  auto options = std::make_shared<IndexOptions>();
+  namespace fs = std::filesystem;
+  index_archive->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+
+  index_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result = Utils::write_index(zip_path);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
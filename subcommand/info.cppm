@@ -0,0 +1,29 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+export module Subcommand.Info;
+import Utils.Archive;
+
+namespace Subcommand {
+
+export void info(CLI::App &app) {
+  auto archive_info = app.add_subcommand("info", "显示压缩包的空间占用和碎片率");
+  struct InfoOptions {
+    std::string file;
+  };
+  auto options = std::make_shared<InfoOptions>();
+  namespace fs = std::filesystem;
+  archive_info->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+
+  archive_info->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result = Utils::info(zip_path);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
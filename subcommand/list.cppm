@@ -0,0 +1,40 @@
+module;
+#include <CLI/CLI.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+export module Subcommand.List;
+import Utils.List;
+
+namespace Subcommand {
+
+export void list(CLI::App &app) {
+  auto list_archive = app.add_subcommand("list", "列出压缩包中的文件");
+  struct ListOptions {
+    std::string file;
+    Utils::ListFormat format{Utils::ListFormat::text};
+  };
+  auto options = std::make_shared<ListOptions>();
+  namespace fs = std::filesystem;
+  list_archive->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  const std::map<std::string, Utils::ListFormat> formats{
+      {"text", Utils::ListFormat::text},
+      {"json", Utils::ListFormat::json},
+      {"ndjson", Utils::ListFormat::ndjson}};
+  list_archive
+      ->add_option("--format", options->format,
+                   "输出格式: text、json或ndjson,默认text")
+      ->transform(CLI::CheckedTransformer(formats, CLI::ignore_case));
+
+  list_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result = Utils::list(zip_path, options->format, stdout);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
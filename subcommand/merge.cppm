@@ -0,0 +1,48 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+export module Subcommand.Merge;
+import Utils.Merge;
+
+namespace Subcommand {
+
+export void merge(CLI::App &app) {
+  auto merge_archives =
+      app.add_subcommand("merge", "合并多个压缩包,直接拷贝压缩数据不重新压缩");
+  struct MergeOptions {
+    std::string output;
+    std::vector<std::string> inputs;
+    Utils::MergeConflict conflict{Utils::MergeConflict::first_wins};
+  };
+  auto options = std::make_shared<MergeOptions>();
+  namespace fs = std::filesystem;
+  merge_archives->add_option("output", options->output, "输出的压缩文件")
+      ->required();
+  merge_archives->add_option("inputs", options->inputs, "要合并的压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  const std::map<std::string, Utils::MergeConflict> conflicts{
+      {"first", Utils::MergeConflict::first_wins},
+      {"last", Utils::MergeConflict::last_wins}};
+  merge_archives
+      ->add_option("--on-conflict", options->conflict,
+                   "同名文件保留first(第一个)或last(最后一个),默认first")
+      ->transform(CLI::CheckedTransformer(conflicts, CLI::ignore_case));
+
+  merge_archives->callback([options]() {
+    std::vector<fs::path> inputs;
+    for (const auto &input : options->inputs) {
+      inputs.push_back(fs::weakly_canonical(fs::current_path() / input));
+    }
+    const int result = Utils::merge(
+        fs::weakly_canonical(fs::current_path() / options->output), inputs,
+        options->conflict);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
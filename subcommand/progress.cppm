@@ -0,0 +1,49 @@
+module;
+#include <cstddef>
+#include <cstdint>
+#include <indicators/progress_bar.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+export module Subcommand.Progress;
+
+namespace Subcommand {
+// 按字节数显示的进度条, 百分比变化时才重绘
+export class ByteProgressBar {
+public:
+  explicit ByteProgressBar(std::string postfix)
+      : bar_{indicators::option::BarWidth{50},
+             indicators::option::Start{"["},
+             indicators::option::Fill{"="},
+             indicators::option::Lead{">"},
+             indicators::option::Remainder{" "},
+             indicators::option::End{"]"},
+             indicators::option::PostfixText{std::move(postfix)},
+             indicators::option::ForegroundColor{indicators::Color::green},
+             indicators::option::ShowPercentage{true},
+             indicators::option::FontStyles{
+                 std::vector{indicators::FontStyle::bold}}} {}
+
+  void operator()(std::uint64_t progress, std::uint64_t total) {
+    auto percent =
+        total == 0 ? size_t{100}
+                   : static_cast<size_t>(static_cast<double>(progress) /
+                                         static_cast<double>(total) * 100.0);
+    if (percent == last_percent_) {
+      return;
+    }
+
+    last_percent_ = percent;
+    if (progress >= total) {
+      bar_.set_option(indicators::option::PostfixText{"完成"});
+      bar_.set_progress(100);
+      return;
+    }
+    bar_.set_progress(percent);
+  }
+
+private:
+  indicators::ProgressBar bar_;
+  size_t last_percent_{static_cast<size_t>(-1)};
+};
+} // namespace Subcommand
@@ -0,0 +1,53 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+export module Subcommand.Recompress;
+import Utils.Recompress;
+
+namespace Subcommand {
+
+export void recompress(CLI::App &app) {
+  auto recompress_archive =
+      app.add_subcommand("recompress", "以新的压缩级别重新压缩整个压缩包");
+  struct RecompressOptions {
+    std::string file;
+    std::string output;
+    int level{9};
+    unsigned jobs{std::thread::hardware_concurrency()};
+    bool force{false};
+    bool keep_deflated{false};
+  };
+  auto options = std::make_shared<RecompressOptions>();
+  namespace fs = std::filesystem;
+  recompress_archive->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  recompress_archive->add_option("-o,--output", options->output, "输出的压缩文件")
+      ->required();
+  recompress_archive
+      ->add_option("-l,--level", options->level, "压缩级别0-9,0为不压缩,默认9")
+      ->check(CLI::Range(0, 9));
+  recompress_archive
+      ->add_option("-j,--jobs", options->jobs, "压缩线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+  auto force = recompress_archive->add_flag(
+      "--force", options->force, "已经是目标压缩方式的文件也重新压缩");
+  recompress_archive
+      ->add_flag("--keep-deflated", options->keep_deflated,
+                 "已经deflate压缩的文件直接拷贝,不重新压缩")
+      ->excludes(force);
+
+  recompress_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    auto output = fs::weakly_canonical(fs::current_path() / options->output);
+    const int result =
+        Utils::recompress(zip_path, output, options->level, options->jobs,
+                          options->force, options->keep_deflated);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
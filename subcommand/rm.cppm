@@ -0,0 +1,38 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+export module Subcommand.Rm;
+import Utils.Archive;
+
+namespace Subcommand {
+
+export void rm(CLI::App &app) {
+  auto remove_entries = app.add_subcommand("rm", "从压缩包中删除文件");
+  struct RmOptions {
+    std::string file;
+    std::vector<std::string> entries;
+    bool tombstone{false};
+  };
+  auto options = std::make_shared<RmOptions>();
+  namespace fs = std::filesystem;
+  remove_entries->add_option("-f,--file", options->file, "压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  remove_entries->add_option("entries", options->entries, "要删除的文件名")
+      ->required();
+  remove_entries->add_flag(
+      "--tombstone", options->tombstone,
+      "只改写中央目录,文件数据留作空洞,之后用compact回收");
+
+  remove_entries->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    const int result =
+        Utils::remove(zip_path, options->entries, options->tombstone);
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
@@ -0,0 +1,43 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+export module Subcommand.Test;
+import Subcommand.Progress;
+import Utils.Verify;
+
+namespace Subcommand {
+
+export void test(CLI::App &app) {
+  auto test_archive =
+      app.add_subcommand("test", "校验压缩包中所有文件的CRC32,不写出文件");
+  struct TestOptions {
+    std::string file;
+    unsigned jobs{std::thread::hardware_concurrency()};
+    size_t max_errors{10};
+  };
+  auto options = std::make_shared<TestOptions>();
+  namespace fs = std::filesystem;
+  test_archive->add_option("-f,--file", options->file, "要校验的压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  test_archive
+      ->add_option("-j,--jobs", options->jobs, "校验线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+  test_archive->add_option("--max-errors", options->max_errors,
+                           "最多列出多少个出错的文件,默认10");
+
+  test_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+
+    ByteProgressBar bar{"校验中"};
+    const int result = Utils::verify(zip_path, options->jobs,
+                                     options->max_errors, std::ref(bar));
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
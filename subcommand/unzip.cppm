@@ -0,0 +1,78 @@
+module;
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <functional>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+export module Subcommand.Unzip;
+import Subcommand.Progress;
+import Utils.Extract;
+
+namespace Subcommand {
+
+export void unzip(CLI::App &app) {
+  auto unzip_archive = app.add_subcommand("unzip", "解压压缩包");
+  struct UnzipOptions {
+    std::string file;
+    std::string output_dir{"."};
+    unsigned jobs{std::thread::hardware_concurrency()};
+    bool skip_unchanged{false};
+    bool check_crc{false};
+    bool dedup{false};
+    bool hardlink{false};
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+  };
+  auto options = std::make_shared<UnzipOptions>();
+  namespace fs = std::filesystem;
+  unzip_archive->add_option("-f,--file", options->file, "要解压的压缩文件")
+      ->required()
+      ->check(CLI::ExistingFile);
+  unzip_archive->add_option("-o,--output", options->output_dir,
+                            "解压到的目录,默认当前目录");
+  unzip_archive
+      ->add_option("-j,--jobs", options->jobs, "解压线程数,默认CPU核数")
+      ->check(CLI::PositiveNumber);
+  auto skip_unchanged =
+      unzip_archive->add_flag("--skip-unchanged", options->skip_unchanged,
+                              "跳过大小和修改时间都未变化的文件");
+  unzip_archive
+      ->add_flag("--check-crc", options->check_crc,
+                 "配合--skip-unchanged,额外比对文件的CRC32")
+      ->needs(skip_unchanged);
+  auto dedup = unzip_archive->add_flag(
+      "--dedup", options->dedup,
+      "内容相同的文件只解压一次,其余用reflink共享,不支持时复制");
+  unzip_archive
+      ->add_flag("--hardlink", options->hardlink,
+                 "配合--dedup,允许用硬链接代替reflink")
+      ->needs(dedup);
+  unzip_archive->add_option("-i,--include", options->include,
+                            "只解压名字匹配的entry,支持*、**、?和[]通配符");
+  unzip_archive->add_option("-x,--exclude", options->exclude,
+                            "跳过名字匹配的entry,优先于--include");
+
+  unzip_archive->callback([options]() {
+    auto zip_path = fs::weakly_canonical(fs::current_path() / options->file);
+    auto output_path =
+        fs::weakly_canonical(fs::current_path() / options->output_dir);
+
+    ByteProgressBar bar{"解压中"};
+    const int result = Utils::extract(
+        zip_path, output_path,
+        {.jobs = options->jobs,
+         .skip_unchanged = options->skip_unchanged,
+         .check_crc = options->check_crc,
+         .dedup = options->dedup,
+         .hardlink = options->hardlink,
+         .include = options->include,
+         .exclude = options->exclude},
+        std::ref(bar));
+    if (result != 0) {
+      throw CLI::RuntimeError(result);
+    }
+  });
+}
+} // namespace Subcommand
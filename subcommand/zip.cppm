@@ -1,10 +1,13 @@
 
 module;
 #include <CLI/CLI.hpp>
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
 #include <indicators/progress_bar.hpp>
 #include <print>
 #include <string>
+#include <vector>
 export module Subcommand.Zip;
 import Utils.Compress;
 import Utils.Utils;
@@ -17,6 +20,10 @@ export void zip(CLI::App &app) {
     std::string name;
     std::string source_dir;
     bool windows_style{false};
+    bool reuse_gz{false};
+    bool exclude_gz{false};
+    std::vector<std::string> store;
+    unsigned align{0};
   };
   auto options = std::make_shared<ZipFolderOptions>();
   namespace fs = std::filesystem;
@@ -27,6 +34,24 @@ export void zip(CLI::App &app) {
       ->required();
   zip_folder->add_flag("-w,--windows-style", options->windows_style,
                        "多一层name目录");
+  const auto reuse_gz = zip_folder->add_flag(
+      "--reuse-gz", options->reuse_gz,
+      "文件旁有不旧于它的 .gz 时直接使用其中已压缩的数据");
+  zip_folder
+      ->add_flag("--exclude-gz", options->exclude_gz,
+                 "不打包旁边有同名源文件的 .gz")
+      ->needs(reuse_gz);
+  const auto store =
+      zip_folder
+          ->add_option("--store", options->store,
+                       "不压缩的文件扩展名,可重复或用逗号分隔,如 .wasm,.sqlite")
+          ->delimiter(',');
+  // 只有不压缩的文件会对齐
+  zip_folder
+      ->add_option("--align", options->align,
+                   "不压缩文件的数据按该字节数对齐(2的幂,最大32768),如 4096")
+      ->check(CLI::Range(0, 32768))
+      ->needs(store);
 
   zip_folder->callback([options]() {
     fs::path output_name = options->name;
@@ -43,6 +68,24 @@ export void zip(CLI::App &app) {
     auto source_path =
         fs::weakly_canonical(fs::current_path() / options->source_dir);
 
+    auto gzip_siblings = Utils::GzipSiblings::ignore;
+    if (options->exclude_gz) {
+      gzip_siblings = Utils::GzipSiblings::reuse_and_exclude;
+    } else if (options->reuse_gz) {
+      gzip_siblings = Utils::GzipSiblings::reuse;
+    }
+
+    Utils::StoredFiles stored{.alignment = options->align};
+    for (auto extension : options->store) {
+      std::ranges::transform(extension, extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+      });
+      if (!extension.starts_with('.')) {
+        extension.insert(0, 1, '.');
+      }
+      stored.extensions.push_back(std::move(extension));
+    }
+
     using namespace indicators;
     ProgressBar bar{option::BarWidth{50},
                     option::Start{"["},
@@ -57,7 +100,8 @@ export void zip(CLI::App &app) {
 
     size_t last_percent = static_cast<size_t>(-1);
     return Utils::compress(
-        zip_path, source_path, archive_root_name, [&](int progress, int total) {
+        zip_path, source_path, archive_root_name, gzip_siblings, stored,
+        [&](int progress, int total) {
           if (total <= 0) {
             return;
           }
@@ -0,0 +1,110 @@
+module;
+#include "zip.h"
+#include <cstdint>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <vector>
+export module Utils.Archive;
+namespace fs = std::filesystem;
+
+namespace Utils {
+// tombstone 时只改写中央目录, 本地记录留作空洞, 之后由 compact 回收
+export int remove(const fs::path &zip_path,
+                  const std::vector<std::string> &entries, bool tombstone) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'd');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+  std::vector<char *> names;
+  names.reserve(entries.size());
+  for (const auto &entry : entries) {
+    names.push_back(const_cast<char *>(entry.c_str()));
+  }
+  const auto n =
+      tombstone ? zip_entries_unlink(zip, names.data(), names.size())
+                : zip_entries_delete(zip, names.data(), names.size());
+  zip_close(zip);
+  if (n < 0) {
+    std::println("delete error: {}", zip_strerror(static_cast<int>(n)));
+    return 1;
+  }
+  std::println("removed {} entries", n);
+  return 0;
+}
+
+// 按文件顺序把仍被引用的本地记录前移, 数据不重新压缩
+export int compact(const fs::path &zip_path) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'd');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+  unsigned long long reclaimed = 0;
+  const int err = zip_compact(zip, &reclaimed);
+  zip_close(zip);
+  if (err < 0) {
+    std::println("compact error: {}", zip_strerror(err));
+    return 1;
+  }
+  std::println("reclaimed {} bytes", reclaimed);
+  return 0;
+}
+
+export int info(const fs::path &zip_path) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+  unsigned long long used = 0;
+  unsigned long long size = 0;
+  const int err = zip_archive_usage(zip, &used, &size);
+  const auto entries = zip_entries_total(zip);
+  zip_close(zip);
+  if (err < 0) {
+    std::println("failed to read local records: {}", zip_strerror(err));
+    return 1;
+  }
+
+  std::error_code ec;
+  const std::uint64_t file_size = fs::file_size(zip_path, ec);
+  const auto dead = size - used;
+  const double fragmentation =
+      size > 0 ? static_cast<double>(dead) / static_cast<double>(size) : 0.0;
+  std::println("entries:           {}", entries);
+  std::println("archive size:      {} bytes", ec ? size : file_size);
+  std::println("local records:     {} bytes", used);
+  std::println("dead space:        {} bytes", dead);
+  if (!ec) {
+    std::println("central directory: {} bytes", file_size - size);
+  }
+  std::println("fragmentation:     {:.1f}%", fragmentation * 100);
+  if (fragmentation >= 0.25) {
+    std::println("run `ziptool compact` to reclaim the dead space");
+  }
+  return 0;
+}
+
+// 在压缩包旁写 .zidx 索引, 之后的 zip_open 直接读入中央目录和名字哈希表;
+// 压缩包改动后索引自动失效
+export int write_index(const fs::path &zip_path) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+  auto index_path = zip_path;
+  index_path += ".zidx";
+  const auto entries = zip_entries_total(zip);
+  const int err = zip_dirindex_save(zip, index_path.string().c_str());
+  zip_close(zip);
+  if (err < 0) {
+    std::println("index error: {}", zip_strerror(err));
+    return 1;
+  }
+  std::println("indexed {} entries: {}", entries, index_path.string());
+  return 0;
+}
+} // namespace Utils
@@ -0,0 +1,208 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||             \
+    defined(__MINGW32__)
+#include <fcntl.h>
+#include <io.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+export module Utils.Cat;
+import Utils.Glob;
+import Utils.Prefetch;
+namespace fs = std::filesystem;
+
+namespace Utils {
+size_t write_out(void *arg, std::uint64_t, const void *data, size_t size) {
+  return std::fwrite(data, 1, size, static_cast<std::FILE *>(arg));
+}
+
+bool copy_range(const fs::path &zip_path, std::uint64_t offset,
+                std::uint64_t size, std::FILE *out) {
+  std::ifstream in(zip_path, std::ios::binary);
+  if (!in.seekg(static_cast<std::streamoff>(offset))) {
+    return false;
+  }
+  std::array<char, 64 * 1024> buffer;
+  while (size > 0) {
+    const auto n = static_cast<std::streamsize>(
+        std::min<std::uint64_t>(size, buffer.size()));
+    if (!in.read(buffer.data(), n) ||
+        std::fwrite(buffer.data(), 1, static_cast<size_t>(n), out) !=
+            static_cast<size_t>(n)) {
+      return false;
+    }
+    size -= static_cast<std::uint64_t>(n);
+  }
+  return true;
+}
+
+// STORED 的数据原样在压缩包里, Linux 上用 sendfile 直接从文件送到输出,
+// 输出是管道时内核走 splice, 不经过用户态缓冲
+bool copy_stored(const fs::path &zip_path, std::uint64_t offset,
+                 std::uint64_t size, std::FILE *out) {
+#if defined(__linux__)
+  std::fflush(out);
+  const int in = ::open(zip_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0) {
+    return false;
+  }
+  auto file_offset = static_cast<off_t>(offset);
+  bool sent_any = false;
+  while (size > 0) {
+    const auto n = ::sendfile(
+        ::fileno(out), in, &file_offset,
+        static_cast<size_t>(std::min<std::uint64_t>(size, 1 << 30)));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    sent_any = true;
+    size -= static_cast<std::uint64_t>(n);
+  }
+  ::close(in);
+  if (size == 0) {
+    return true;
+  }
+  // 输出不支持 sendfile (比如以追加方式打开) 时退回普通读写
+  if (sent_any) {
+    return false;
+  }
+#endif
+  return copy_range(zip_path, offset, size, out);
+}
+
+// 把一个 entry 流式写到 out, 不会整个读进内存
+export int cat(const fs::path &zip_path, const std::string &entry_name,
+               std::FILE *out) {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||             \
+    defined(__MINGW32__)
+  _setmode(_fileno(out), _O_BINARY);
+#endif
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println(stderr, "zip open error");
+    return 1;
+  }
+  if (zip_entry_open(zip, entry_name.c_str()) != 0) {
+    std::println(stderr, "zip entry not found: {}", entry_name);
+    zip_close(zip);
+    return 1;
+  }
+  if (zip_entry_isdir(zip) == 1) {
+    std::println(stderr, "zip entry is a directory: {}", entry_name);
+    zip_close(zip);
+    return 1;
+  }
+
+  bool ok = true;
+  unsigned long long offset = 0;
+  if (zip_entry_rawoffset(zip, &offset) == 0) {
+    ok = copy_stored(zip_path, offset, zip_entry_comp_size(zip), out);
+  } else if (const int err = zip_entry_extract(zip, write_out, out); err < 0) {
+    std::println(stderr, "failed to extract {}: {}", entry_name,
+                 zip_strerror(err));
+    ok = false;
+  }
+  if (std::fflush(out) != 0) {
+    ok = false;
+  }
+  if (!ok) {
+    std::println(stderr, "failed to write {}", entry_name);
+  }
+  zip_entry_close(zip);
+  zip_close(zip);
+  return ok ? 0 : 1;
+}
+
+// 把多个 entry 按数据在压缩包中的顺序依次流式写到 out. 后台线程提前解压
+// 后面的数据, 输出和解压同时进行; glob 时 patterns 是通配符,
+// 否则是完整的名字
+export int cat_entries(const fs::path &zip_path,
+                       const std::vector<std::string> &patterns, bool glob,
+                       std::FILE *out) {
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||             \
+    defined(__MINGW32__)
+  _setmode(_fileno(out), _O_BINARY);
+#endif
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println(stderr, "zip open error");
+    return 1;
+  }
+
+  std::vector<Glob> globs;
+  std::unordered_set<std::string_view> names;
+  for (const auto &pattern : patterns) {
+    if (glob) {
+      globs.emplace_back(pattern);
+    } else {
+      names.insert(pattern);
+    }
+  }
+  std::unordered_set<std::string_view> found;
+  bool ok = true;
+  const auto n = entries_stream(
+      zip, StreamOrder::local_offset, 64 << 20,
+      [&](std::string_view name) {
+        if (glob) {
+          return std::ranges::any_of(
+              globs, [&](const Glob &g) { return g.match(name); });
+        }
+        const auto it = names.find(name);
+        if (it == names.end()) {
+          return false;
+        }
+        found.insert(*it);
+        return true;
+      },
+      [&](const StreamedChunk &chunk) {
+        if (chunk.error < 0) {
+          std::println(stderr, "failed to extract {}: {}", chunk.name,
+                       zip_strerror(chunk.error));
+          ok = false;
+          return true;
+        }
+        if (std::fwrite(chunk.data.data(), 1, chunk.data.size(), out) !=
+            chunk.data.size()) {
+          std::println(stderr, "failed to write {}", chunk.name);
+          ok = false;
+          return false;
+        }
+        return true;
+      });
+  zip_close(zip);
+  if (n < 0) {
+    std::println(stderr, "failed to read zip entries: {}",
+                 zip_strerror(static_cast<int>(n)));
+    return 1;
+  }
+  for (const auto &name : names) {
+    if (!found.contains(name)) {
+      std::println(stderr, "zip entry not found: {}", name);
+      ok = false;
+    }
+  }
+  if (glob && n == 0) {
+    std::println(stderr, "no zip entry matches");
+    ok = false;
+  }
+  return ok && std::fflush(out) == 0 ? 0 : 1;
+}
+} // namespace Utils
@@ -0,0 +1,159 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+export module Utils.Check;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+enum class CheckState : char { same, missing, modified };
+
+struct CheckTask {
+  std::string name;
+  fs::path path;
+  std::uint64_t size;
+  std::uint32_t crc32;
+  CheckState state{CheckState::same};
+};
+
+struct CheckContext {
+  const fs::path &dir;
+  std::vector<CheckTask> tasks{};
+  // 名字到 tasks 下标, 目录为 npos
+  std::unordered_map<std::string, size_t> expected{};
+};
+
+int collect_task(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<CheckContext *>(arg);
+  const auto relative =
+      fs::path(std::string_view{info->name, info->namelen}).lexically_normal();
+  if (relative.empty() || relative.has_root_path() ||
+      *relative.begin() == "..") {
+    return 0;
+  }
+  auto name = relative.generic_string();
+  const auto it = context.expected.try_emplace(name, std::string::npos).first;
+  if (info->isdir) {
+    return 0;
+  }
+  // 同名 entry 与解压结果一致, 以最后一个为准
+  CheckTask task{std::move(name), context.dir / relative, info->uncomp_size,
+                 info->crc32};
+  if (it->second == std::string::npos) {
+    it->second = context.tasks.size();
+    context.tasks.push_back(std::move(task));
+  } else {
+    context.tasks[it->second] = std::move(task);
+  }
+  return 0;
+}
+
+bool crc32_matches(const fs::path &path, std::uint32_t crc32,
+                   std::vector<char> &buffer) {
+  std::FILE *file = std::fopen(path.string().c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  // 已经有自己的缓冲, 不再让 stdio 多拷贝一次
+  std::setvbuf(file, nullptr, _IONBF, 0);
+  unsigned int crc = 0;
+  size_t n;
+  while ((n = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+    crc = zip_crc32(crc, buffer.data(), n);
+  }
+  const bool ok = !std::ferror(file) && crc == crc32;
+  std::fclose(file);
+  return ok;
+}
+
+// 只用中央目录里的大小和 CRC-32 比对目录中的文件, 不解压任何数据.
+// 每个线程一块 memory_budget / jobs 大小 (至少 64 KiB) 的读缓冲
+export int check(const fs::path &zip_path, const fs::path &dir, unsigned jobs,
+                 size_t memory_budget) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+
+  CheckContext context{dir};
+  if (zip_entries_foreach(zip, collect_task, &context) < 0) {
+    std::println("failed to read central directory");
+    zip_close(zip);
+    return 1;
+  }
+  auto &tasks = context.tasks;
+  const auto &expected = context.expected;
+  zip_close(zip);
+
+  jobs = worker_count(jobs, tasks.size());
+  const size_t buffer_size =
+      std::max<size_t>(memory_budget / jobs, 64 * 1024);
+  // 缓冲在线程第一次领到任务时分配
+  std::vector<std::vector<char>> buffers(jobs);
+  run_workers(jobs, tasks.size(), [&](unsigned worker, size_t i) {
+    auto &buffer = buffers[worker];
+    if (buffer.empty()) {
+      buffer.resize(buffer_size);
+    }
+    auto &task = tasks[i];
+    std::error_code ec;
+    const auto size = fs::file_size(task.path, ec);
+    if (ec) {
+      task.state = CheckState::missing;
+    } else if (size != task.size ||
+               !crc32_matches(task.path, task.crc32, buffer)) {
+      task.state = CheckState::modified;
+    }
+  });
+
+  std::vector<std::string> missing;
+  std::vector<std::string> modified;
+  std::vector<std::string> extra;
+  for (const auto &task : tasks) {
+    if (task.state == CheckState::missing) {
+      missing.push_back(task.name);
+    } else if (task.state == CheckState::modified) {
+      modified.push_back(task.name);
+    }
+  }
+  std::error_code ec;
+  for (auto it = fs::recursive_directory_iterator(
+           dir, fs::directory_options::skip_permission_denied, ec);
+       !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    std::error_code type_ec;
+    if (it->is_directory(type_ec)) {
+      continue;
+    }
+    auto name = it->path().lexically_relative(dir).generic_string();
+    if (!expected.contains(name)) {
+      extra.push_back(std::move(name));
+    }
+  }
+  std::ranges::sort(missing);
+  std::ranges::sort(modified);
+  std::ranges::sort(extra);
+
+  for (const auto &name : missing) {
+    std::println("missing: {}", name);
+  }
+  for (const auto &name : modified) {
+    std::println("modified: {}", name);
+  }
+  for (const auto &name : extra) {
+    std::println("extra: {}", name);
+  }
+  std::println("checked {} files: {} missing, {} modified, {} extra",
+               tasks.size(), missing.size(), modified.size(), extra.size());
+  return missing.empty() && modified.empty() && extra.empty() ? 0 : 1;
+}
+} // namespace Utils
@@ -1,8 +1,17 @@
 module;
 #include "zip.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
 #include <concepts>
+#include <cstdint>
+#include <cstdio>
 #include <filesystem>
+#include <optional>
 #include <print>
+#include <string>
+#include <vector>
 export module Utils.Compress;
 namespace fs = std::filesystem;
 
@@ -10,9 +19,207 @@ namespace Utils {
 export template <typename Callback>
 concept ProgressCallback = std::invocable<Callback, int, int>;
 
+// foo.js 旁边已有构建产出的 foo.js.gz 时的处理方式
+export enum class GzipSiblings { ignore, reuse, reuse_and_exclude };
+
+// 按扩展名 (小写, 带点) 选出不压缩的文件, alignment 非 0 时
+// 它们的数据在压缩包中按该字节数对齐, 可以直接 mmap
+export struct StoredFiles {
+  std::vector<std::string> extensions{};
+  unsigned alignment{0};
+};
+
+bool is_stored_file(const fs::path &file_path, const StoredFiles &stored) {
+  if (stored.extensions.empty()) {
+    return false;
+  }
+  auto extension = file_path.extension().string();
+  std::ranges::transform(extension, extension.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return std::ranges::find(stored.extensions, extension) !=
+         stored.extensions.end();
+}
+
+struct GzipMember {
+  std::uint64_t body_offset;
+  std::uint64_t body_size;
+  std::uint32_t crc32;
+};
+
+std::uint32_t read_le32(const unsigned char *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+// 解析 gzip 头和尾部的 CRC-32, ISIZE, 只接受 deflate 压缩
+// 且 ISIZE 与源文件大小一致的 .gz; 尾部描述的是最后一个 member
+std::optional<GzipMember> read_gzip_member(std::FILE *file,
+                                           std::uint64_t gz_size,
+                                           std::uint64_t source_size) {
+  constexpr unsigned char FHCRC = 0x02, FEXTRA = 0x04, FNAME = 0x08,
+                          FCOMMENT = 0x10;
+  std::array<unsigned char, 10> header;
+  if (source_size > 0xFFFFFFFFu || gz_size < header.size() + 8 ||
+      std::fread(header.data(), 1, header.size(), file) != header.size() ||
+      header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 ||
+      (header[3] & 0xE0) != 0) {
+    return std::nullopt;
+  }
+  const auto skip_string = [file] {
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+      if (c == 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  if (header[3] & FEXTRA) {
+    std::array<unsigned char, 2> xlen;
+    if (std::fread(xlen.data(), 1, xlen.size(), file) != xlen.size() ||
+        std::fseek(file, xlen[0] | xlen[1] << 8, SEEK_CUR) != 0) {
+      return std::nullopt;
+    }
+  }
+  if (((header[3] & FNAME) && !skip_string()) ||
+      ((header[3] & FCOMMENT) && !skip_string()) ||
+      ((header[3] & FHCRC) && std::fseek(file, 2, SEEK_CUR) != 0)) {
+    return std::nullopt;
+  }
+  const long body_offset = std::ftell(file);
+  if (body_offset < 0 ||
+      static_cast<std::uint64_t>(body_offset) + 8 >= gz_size) {
+    return std::nullopt;
+  }
+  std::array<unsigned char, 8> trailer;
+  if (std::fseek(file, -8, SEEK_END) != 0 ||
+      std::fread(trailer.data(), 1, trailer.size(), file) != trailer.size() ||
+      read_le32(trailer.data() + 4) != source_size) {
+    return std::nullopt;
+  }
+  return GzipMember{static_cast<std::uint64_t>(body_offset),
+                    gz_size - 8 - static_cast<std::uint64_t>(body_offset),
+                    read_le32(trailer.data())};
+}
+
+std::optional<std::uint32_t> file_crc32(const fs::path &path,
+                                        std::vector<char> &buffer) {
+  std::FILE *file = std::fopen(path.string().c_str(), "rb");
+  if (file == nullptr) {
+    return std::nullopt;
+  }
+  std::uint32_t crc = 0;
+  size_t n;
+  while ((n = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+    crc = zip_crc32(crc, buffer.data(), n);
+  }
+  const bool ok = !std::ferror(file);
+  std::fclose(file);
+  return ok ? std::optional{crc} : std::nullopt;
+}
+
+// 尾部的 CRC-32 和 ISIZE 与源文件一致时, 多 member 的 .gz 只可能是前面的
+// member 都解压为空, 它们的尾部全为 0 并紧接着下一个 gzip 头
+bool has_empty_member(std::FILE *file, const GzipMember &member,
+                      std::vector<char> &buffer) {
+  constexpr std::array<unsigned char, 11> boundary{
+      0, 0, 0, 0, 0, 0, 0, 0, 0x1f, 0x8b, 8};
+  if (std::fseek(file, static_cast<long>(member.body_offset), SEEK_SET) != 0) {
+    return true;
+  }
+  auto remaining = member.body_size;
+  size_t kept = 0;
+  while (remaining > 0) {
+    const auto n = std::fread(
+        buffer.data() + kept, 1,
+        std::min<std::uint64_t>(remaining, buffer.size() - kept), file);
+    if (n == 0) {
+      return true;
+    }
+    remaining -= n;
+    const auto *begin = reinterpret_cast<const unsigned char *>(buffer.data());
+    const auto *end = begin + kept + n;
+    if (std::search(begin, end, boundary.begin(), boundary.end()) != end) {
+      return true;
+    }
+    // 跨块的边界留到下一块里找
+    kept = std::min<size_t>(kept + n, boundary.size() - 1);
+    std::copy(end - kept, end, buffer.data());
+  }
+  return false;
+}
+
+// foo.js.gz 有效, 不比 foo.js 旧且 CRC-32 与 foo.js 一致时, 把它的 deflate
+// 数据原样作为 foo.js 的 entry 数据写入. 返回 1 表示不能复用, 需要正常压缩
+int write_gzip_sibling(zip_t *zip, const fs::path &file_path) {
+  auto gz_path = file_path;
+  gz_path += ".gz";
+  std::error_code ec;
+  if (!fs::is_regular_file(gz_path, ec)) {
+    return 1;
+  }
+  const auto source_time = fs::last_write_time(file_path, ec);
+  if (ec || fs::last_write_time(gz_path, ec) < source_time || ec) {
+    return 1;
+  }
+  const auto source_size = fs::file_size(file_path, ec);
+  if (ec) {
+    return 1;
+  }
+  const auto gz_size = fs::file_size(gz_path, ec);
+  if (ec) {
+    return 1;
+  }
+  std::FILE *file = std::fopen(gz_path.string().c_str(), "rb");
+  if (file == nullptr) {
+    return 1;
+  }
+  std::vector<char> buffer(256 * 1024);
+  // 大小相同的修改也会让 .gz 过期, CRC-32 比重新压缩便宜得多
+  const auto member = read_gzip_member(file, gz_size, source_size);
+  if (!member || file_crc32(file_path, buffer) != member->crc32 ||
+      has_empty_member(file, *member, buffer) ||
+      std::fseek(file, static_cast<long>(member->body_offset), SEEK_SET) !=
+          0) {
+    std::fclose(file);
+    return 1;
+  }
+  zip_entry_set_mtime(
+      zip, std::chrono::system_clock::to_time_t(
+               std::chrono::clock_cast<std::chrono::system_clock>(
+                   source_time)));
+  auto remaining = member->body_size;
+  int err = 0;
+  while (remaining > 0 && err == 0) {
+    const auto n = std::fread(
+        buffer.data(), 1, std::min<std::uint64_t>(remaining, buffer.size()),
+        file);
+    if (n == 0) {
+      err = ZIP_EFREAD;
+      break;
+    }
+    err = zip_entry_rawwrite(zip, buffer.data(), n, 8, source_size,
+                             member->crc32);
+    remaining -= n;
+  }
+  std::fclose(file);
+  return err;
+}
+
+// reuse_and_exclude 时, 旁边有同名源文件的 .gz 不放进压缩包
+bool excluded_gzip_sibling(const fs::path &file_path,
+                           GzipSiblings gzip_siblings) {
+  if (gzip_siblings != GzipSiblings::reuse_and_exclude ||
+      file_path.extension() != ".gz") {
+    return false;
+  }
+  std::error_code ec;
+  return fs::is_regular_file(fs::path(file_path).replace_extension(), ec);
+}
+
 export template <ProgressCallback Callback>
 int compress(const fs::path &zip_path, const fs::path &source_path,
-             const fs::path &archive_root_name, Callback on_progress) {
+             const fs::path &archive_root_name, GzipSiblings gzip_siblings,
+             const StoredFiles &stored, Callback on_progress) {
   const auto zip =
       zip_open(zip_path.string().c_str(), ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
 
@@ -20,11 +227,18 @@ int compress(const fs::path &zip_path, const fs::path &source_path,
     std::println("zip open error");
     return 0;
   }
+  if (zip_set_alignment(zip, stored.alignment) != 0) {
+    std::println("alignment must be a power of two up to 32768: {}",
+                 stored.alignment);
+    zip_close(zip);
+    return 1;
+  }
   int total_files = 0;
   for (const auto &entry : fs::recursive_directory_iterator(
            source_path, fs::directory_options::skip_permission_denied)) {
 
-    if (!entry.is_regular_file()) {
+    if (!entry.is_regular_file() ||
+        excluded_gzip_sibling(entry.path(), gzip_siblings)) {
       continue;
     }
     std::error_code ec;
@@ -49,13 +263,24 @@ int compress(const fs::path &zip_path, const fs::path &source_path,
         std::println("zip file is exist");
         continue;
       }
+      if (excluded_gzip_sibling(file_path, gzip_siblings)) {
+        continue;
+      }
+      const bool store = is_stored_file(file_path, stored);
+      zip_set_level(zip, store ? 0 : ZIP_DEFAULT_COMPRESSION_LEVEL);
       if (zip_entry_open(zip, entry_path.generic_string().c_str()) != 0) {
         std::println("failed to open zip entry: {}",
                      entry_path.generic_string());
         continue;
       }
       zip_entry_set_unix_permissions(zip, 0644, 0);
-      if (zip_entry_fwrite(zip, file_path.string().c_str()) != 0) {
+      int err = store || gzip_siblings == GzipSiblings::ignore
+                    ? 1
+                    : write_gzip_sibling(zip, file_path);
+      if (err > 0) {
+        err = zip_entry_fwrite(zip, file_path.string().c_str());
+      }
+      if (err != 0) {
         std::println("failed to write file: {}", file_path.string());
         zip_entry_close(zip);
         continue;
@@ -0,0 +1,227 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <print>
+#include <string>
+#include <unordered_map>
+#include <vector>
+export module Utils.Diff;
+import Utils.Reader;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+struct DiffEntry {
+  size_t index;
+  std::uint64_t size;
+  std::uint32_t crc32;
+  int method;
+};
+
+struct ChangedEntry {
+  std::string name;
+  DiffEntry from;
+  DiffEntry to;
+  // --deep 时填写, 以 block_size 为单位比较
+  std::uint64_t blocks{0};
+  std::uint64_t differing_blocks{0};
+  std::optional<std::uint64_t> first_difference{};
+  bool failed{false};
+};
+
+// 按固定大小分块计算 CRC-32, 比较两个 entry 时只需保存块校验值
+struct BlockHasher {
+  static constexpr size_t block_size = 4096;
+  std::vector<std::uint32_t> crcs;
+  std::uint32_t crc{0};
+  size_t fill{0};
+
+  void update(const char *data, size_t size) {
+    while (size > 0) {
+      const auto n = std::min(size, block_size - fill);
+      crc = zip_crc32(crc, data, n);
+      fill += n;
+      data += n;
+      size -= n;
+      if (fill == block_size) {
+        crcs.push_back(crc);
+        crc = 0;
+        fill = 0;
+      }
+    }
+  }
+  void finish() {
+    if (fill > 0) {
+      crcs.push_back(crc);
+      crc = 0;
+      fill = 0;
+    }
+  }
+};
+
+size_t hash_chunk(void *arg, std::uint64_t, const void *data, size_t size) {
+  static_cast<BlockHasher *>(arg)->update(static_cast<const char *>(data),
+                                          size);
+  return size;
+}
+
+using EntryMap = std::unordered_map<std::string, DiffEntry>;
+
+int collect_entry(void *arg, const zip_entry_info_t *info) {
+  static_cast<EntryMap *>(arg)->insert_or_assign(
+      std::string{info->name, info->namelen},
+      DiffEntry{info->index, info->uncomp_size, info->crc32, info->method});
+  return 0;
+}
+
+// 只读中央目录, 同名 entry 以最后一个为准, 与解压结果一致
+std::optional<EntryMap> load_entries(zip_t *zip) {
+  EntryMap entries;
+  entries.reserve(
+      static_cast<size_t>(std::max<ssize_t>(zip_entries_total(zip), 0)));
+  if (zip_entries_foreach(zip, collect_entry, &entries) < 0) {
+    return std::nullopt;
+  }
+  return entries;
+}
+
+std::optional<std::vector<std::uint32_t>>
+hash_entry(zip_cursor_t *cursor, size_t index) {
+  BlockHasher hasher;
+  if (zip_cursor_entry_openbyindex(cursor, index) != 0 ||
+      zip_cursor_entry_extract(cursor, hash_chunk, &hasher) < 0) {
+    return std::nullopt;
+  }
+  hasher.finish();
+  return std::move(hasher.crcs);
+}
+
+// 只比较两个压缩包的中央目录, 按名字报告新增, 删除和改动的 entry;
+// deep 时再并行解压有改动的 entry, 按 4 KiB 块统计差异
+export int diff(const fs::path &from_path, const fs::path &to_path, bool deep,
+                unsigned jobs) {
+  const auto from_zip = zip_open(from_path.string().c_str(), 0, 'r');
+  if (from_zip == nullptr) {
+    std::println("zip open error: {}", from_path.string());
+    return 2;
+  }
+  const auto to_zip = zip_open(to_path.string().c_str(), 0, 'r');
+  if (to_zip == nullptr) {
+    std::println("zip open error: {}", to_path.string());
+    zip_close(from_zip);
+    return 2;
+  }
+  const auto from_entries = load_entries(from_zip);
+  const auto to_entries = load_entries(to_zip);
+  if (!from_entries || !to_entries) {
+    std::println("failed to read central directory");
+    zip_close(from_zip);
+    zip_close(to_zip);
+    return 2;
+  }
+
+  std::vector<std::string> added;
+  std::vector<std::string> removed;
+  std::vector<ChangedEntry> changed;
+  for (const auto &[name, from] : *from_entries) {
+    const auto it = to_entries->find(name);
+    if (it == to_entries->end()) {
+      removed.push_back(name);
+    } else if (from.crc32 != it->second.crc32 ||
+               from.size != it->second.size ||
+               from.method != it->second.method) {
+      changed.push_back({.name = name, .from = from, .to = it->second});
+    }
+  }
+  for (const auto &[name, to] : *to_entries) {
+    if (!from_entries->contains(name)) {
+      added.push_back(name);
+    }
+  }
+  std::ranges::sort(added);
+  std::ranges::sort(removed);
+  std::ranges::sort(changed, {}, &ChangedEntry::name);
+
+  if (deep) {
+    std::vector<size_t> content_changed;
+    for (size_t i = 0; i < changed.size(); ++i) {
+      if (changed[i].from.crc32 != changed[i].to.crc32 ||
+          changed[i].from.size != changed[i].to.size) {
+        content_changed.push_back(i);
+      }
+    }
+    jobs = worker_count(jobs, content_changed.size());
+    int errnum = 0;
+    std::vector<CursorPtr> from_cursors;
+    std::vector<CursorPtr> to_cursors;
+    if (!content_changed.empty()) {
+      from_cursors = open_cursors(from_zip, jobs, errnum);
+      if (!from_cursors.empty()) {
+        to_cursors = open_cursors(to_zip, jobs, errnum);
+      }
+      if (to_cursors.empty()) {
+        std::println("zip cursor open error: {}", zip_strerror(errnum));
+        from_cursors.clear();
+        zip_close(from_zip);
+        zip_close(to_zip);
+        return 2;
+      }
+    }
+
+    run_workers(jobs, content_changed.size(), [&](unsigned worker, size_t i) {
+      auto &entry = changed[content_changed[i]];
+      const auto from =
+          hash_entry(from_cursors[worker].get(), entry.from.index);
+      const auto to = hash_entry(to_cursors[worker].get(), entry.to.index);
+      if (!from || !to) {
+        entry.failed = true;
+        return;
+      }
+      entry.blocks = std::max(from->size(), to->size());
+      for (size_t block = 0; block < entry.blocks; ++block) {
+        if (block >= from->size() || block >= to->size() ||
+            (*from)[block] != (*to)[block]) {
+          ++entry.differing_blocks;
+          if (!entry.first_difference) {
+            entry.first_difference = block * BlockHasher::block_size;
+          }
+        }
+      }
+    });
+  }
+
+  for (const auto &name : added) {
+    std::println("+ {} ({} bytes)", name, to_entries->at(name).size);
+  }
+  for (const auto &name : removed) {
+    std::println("- {} ({} bytes)", name, from_entries->at(name).size);
+  }
+  for (const auto &entry : changed) {
+    if (entry.from.crc32 == entry.to.crc32 &&
+        entry.from.size == entry.to.size) {
+      std::println("~ {}: method {} -> {}, content unchanged", entry.name,
+                   entry.from.method, entry.to.method);
+      continue;
+    }
+    std::println("M {}: size {} -> {}, crc32 {:08x} -> {:08x}", entry.name,
+                 entry.from.size, entry.to.size, entry.from.crc32,
+                 entry.to.crc32);
+    if (entry.failed) {
+      std::println("    failed to inflate");
+    } else if (entry.first_difference) {
+      std::println("    {} of {} 4 KiB blocks differ, first at offset {}",
+                   entry.differing_blocks, entry.blocks,
+                   *entry.first_difference);
+    }
+  }
+  std::println("{} added, {} removed, {} changed", added.size(),
+               removed.size(), changed.size());
+
+  zip_close(from_zip);
+  zip_close(to_zip);
+  return added.empty() && removed.empty() && changed.empty() ? 0 : 1;
+}
+} // namespace Utils
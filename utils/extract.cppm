@@ -0,0 +1,459 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+export module Utils.Extract;
+import Utils.Glob;
+import Utils.Reader;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+export template <typename Callback>
+concept ByteProgressCallback =
+    std::invocable<Callback, std::uint64_t, std::uint64_t>;
+
+export struct ExtractOptions {
+  unsigned jobs{1};
+  // 大小和修改时间与中央目录一致的文件不再解压
+  bool skip_unchanged{false};
+  // skip_unchanged 时再比对文件的 CRC-32
+  bool check_crc{false};
+  // 大小和 CRC-32 相同的 entry 比对内容后用 reflink 共享数据块,
+  // 不支持时退回复制文件
+  bool dedup{false};
+  // dedup 时允许直接建立硬链接, 修改其中一个文件会影响所有链接
+  bool hardlink{false};
+  // 为空时解压全部 entry, 匹配 exclude 的 entry 总是跳过
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+};
+
+struct ExtractTask {
+  size_t index;
+  std::uint64_t header_offset;
+  std::uint64_t size;
+  std::uint32_t crc32;
+  long long mtime;
+  // external_attr 高 16 位的 Unix 权限, 不是 Unix 上创建的 entry 为 0
+  std::uint16_t mode;
+  fs::path path;
+  // dedup 时内容可能相同的第一个 entry
+  std::optional<size_t> source;
+};
+
+struct WriteContext {
+  std::FILE *file;
+  std::atomic<std::uint64_t> *done;
+};
+
+struct CompareContext {
+  std::FILE *file;
+  std::vector<char> buffer;
+};
+
+struct IncludeContext {
+  const Glob *glob;
+  std::vector<size_t> *indices;
+};
+
+// 拒绝绝对路径和跳出输出目录的 entry
+std::optional<fs::path> entry_path(const fs::path &output_dir,
+                                   std::string_view name) {
+  auto relative = fs::path(name).lexically_normal();
+  if (relative.empty() || relative.has_root_path() ||
+      *relative.begin() == "..") {
+    return std::nullopt;
+  }
+  return output_dir / relative;
+}
+
+fs::file_time_type to_file_time(long long mtime) {
+  return std::chrono::clock_cast<std::chrono::file_clock>(
+      std::chrono::system_clock::time_point{std::chrono::seconds{mtime}});
+}
+
+bool file_crc32_matches(const fs::path &path, std::uint32_t crc32) {
+  std::FILE *file = std::fopen(path.string().c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::array<char, 64 * 1024> buffer;
+  unsigned int crc = 0;
+  size_t n;
+  while ((n = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+    crc = zip_crc32(crc, buffer.data(), n);
+  }
+  const bool ok = !std::ferror(file) && crc == crc32;
+  std::fclose(file);
+  return ok;
+}
+
+// 目标文件已与 entry 一致时返回 true
+bool unchanged(const ExtractTask &task, bool check_crc) {
+  std::error_code ec;
+  const auto size = fs::file_size(task.path, ec);
+  if (ec || size != task.size) {
+    return false;
+  }
+  const auto mtime = fs::last_write_time(task.path, ec);
+  if (ec || std::chrono::floor<std::chrono::seconds>(mtime) !=
+                to_file_time(task.mtime)) {
+    return false;
+  }
+  return !check_crc || file_crc32_matches(task.path, task.crc32);
+}
+
+size_t write_chunk(void *arg, std::uint64_t, const void *data, size_t size) {
+  auto *context = static_cast<WriteContext *>(arg);
+  const auto written = std::fwrite(data, 1, size, context->file);
+  context->done->fetch_add(written, std::memory_order_relaxed);
+  return written;
+}
+
+int collect_included(void *arg, size_t index, const char *name,
+                     size_t namelen) {
+  auto *context = static_cast<IncludeContext *>(arg);
+  if (context->glob->match({name, namelen})) {
+    context->indices->push_back(index);
+  }
+  return 0;
+}
+
+int collect_mode(void *arg, const zip_entry_info_t *info) {
+  auto &modes = *static_cast<std::vector<std::uint16_t> *>(arg);
+  modes[info->index] = static_cast<std::uint16_t>(info->external_attr >> 16);
+  return 0;
+}
+
+// 与 zip_extract 一样还原权限位, 文件类型位忽略
+void apply_mode(const ExtractTask &task) {
+  if (task.mode != 0) {
+    std::error_code ec;
+    fs::permissions(task.path, static_cast<fs::perms>(task.mode & 07777), ec);
+  }
+}
+
+// 只按中央目录里的名字筛选, 每个 include 模式先按字面前缀做范围查询
+std::vector<size_t> select_entries(zip_t *zip,
+                                   const std::vector<std::string> &include) {
+  std::vector<size_t> indices;
+  if (include.empty()) {
+    const auto total = zip_entries_total(zip);
+    for (ssize_t i = 0; i < total; ++i) {
+      indices.push_back(static_cast<size_t>(i));
+    }
+    return indices;
+  }
+  for (const auto &pattern : include) {
+    const Glob glob{pattern};
+    IncludeContext context{&glob, &indices};
+    zip_entries_prefix(zip, glob.prefix().c_str(), collect_included,
+                       &context);
+  }
+  std::ranges::sort(indices);
+  const auto [first, last] = std::ranges::unique(indices);
+  indices.erase(first, last);
+  return indices;
+}
+
+// 返回 0 让解压提前中止
+size_t compare_chunk(void *arg, std::uint64_t, const void *data, size_t size) {
+  auto *context = static_cast<CompareContext *>(arg);
+  context->buffer.resize(size);
+  if (std::fread(context->buffer.data(), 1, size, context->file) != size ||
+      std::memcmp(context->buffer.data(), data, size) != 0) {
+    return 0;
+  }
+  return size;
+}
+
+bool extract_file(zip_cursor_t *cursor, const ExtractTask &task,
+                  std::atomic<std::uint64_t> &done) {
+  const auto name = task.path.string();
+  if (zip_cursor_entry_openbyindex(cursor, task.index) != 0) {
+    std::println("failed to open zip entry: {}", name);
+    return false;
+  }
+  std::FILE *file = std::fopen(name.c_str(), "wb");
+  if (file == nullptr) {
+    std::println("failed to create file: {}", name);
+    return false;
+  }
+  WriteContext context{file, &done};
+  const int err = zip_cursor_entry_extract(cursor, write_chunk, &context);
+  if (std::fclose(file) != 0 || err < 0) {
+    std::println("failed to extract file: {} ({})", name,
+                 err < 0 ? zip_strerror(err) : "close error");
+    return false;
+  }
+  apply_mode(task);
+  // 保留修改时间, 下次 skip_unchanged 才能比对
+  std::error_code ec;
+  fs::last_write_time(task.path, to_file_time(task.mtime), ec);
+  return true;
+}
+
+// 边解压 entry 边和已写出的文件比对, 不落盘
+bool same_content(zip_cursor_t *cursor, const ExtractTask &task,
+                  const fs::path &source) {
+  if (zip_cursor_entry_openbyindex(cursor, task.index) != 0) {
+    return false;
+  }
+  std::FILE *file = std::fopen(source.string().c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  CompareContext context{file, {}};
+  const int err = zip_cursor_entry_extract(cursor, compare_chunk, &context);
+  std::fclose(file);
+  return err >= 0;
+}
+
+bool clone_file(const fs::path &from, const fs::path &to) {
+#if defined(__linux__)
+  const int src = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+  if (src < 0) {
+    return false;
+  }
+  const int dst = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                         0666);
+  const bool ok = dst >= 0 && ::ioctl(dst, FICLONE, src) == 0;
+  ::close(src);
+  if (dst >= 0) {
+    ::close(dst);
+    if (!ok) {
+      ::unlink(to.c_str());
+    }
+  }
+  return ok;
+#elif defined(__APPLE__)
+  return ::clonefile(from.c_str(), to.c_str(), 0) == 0;
+#else
+  (void)from;
+  (void)to;
+  return false;
+#endif
+}
+
+// 依次尝试硬链接, reflink 和复制
+bool link_file(const ExtractTask &task, const ExtractTask &source,
+               bool hardlink) {
+  std::error_code ec;
+  // 目标可能是上次留下的硬链接, 直接写入会改到源文件
+  fs::remove(task.path, ec);
+  // 修改时间或权限不同时硬链接无法同时保留两者
+  if (hardlink && task.mtime == source.mtime && task.mode == source.mode) {
+    fs::create_hard_link(source.path, task.path, ec);
+    if (!ec) {
+      return true;
+    }
+  }
+  if (!clone_file(source.path, task.path)) {
+    fs::copy_file(source.path, task.path, fs::copy_options::overwrite_existing,
+                  ec);
+    if (ec) {
+      return false;
+    }
+  }
+  apply_mode(task);
+  fs::last_write_time(task.path, to_file_time(task.mtime), ec);
+  return true;
+}
+
+// 先一次性建好目录树, 再按 local header 偏移把文件分给 jobs 个线程解压,
+// 进度按已处理的字节数回调
+export template <ByteProgressCallback Callback>
+int extract(const fs::path &zip_path, const fs::path &output_dir,
+            const ExtractOptions &options, Callback on_progress) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+
+  std::vector<ExtractTask> tasks;
+  std::vector<fs::path> directories{output_dir};
+  std::uint64_t total_bytes = 0;
+  int failed = 0;
+  std::vector<Glob> excludes;
+  for (const auto &pattern : options.exclude) {
+    excludes.emplace_back(pattern);
+  }
+  std::vector<std::uint16_t> modes(
+      static_cast<size_t>(std::max<ssize_t>(zip_entries_total(zip), 0)));
+  if (zip_entries_foreach(zip, collect_mode, &modes) < 0) {
+    std::println("failed to read central directory");
+    zip_close(zip);
+    return 1;
+  }
+  for (const auto i : select_entries(zip, options.include)) {
+    if (zip_entry_openbyindex(zip, i) != 0) {
+      std::println("failed to open zip entry: #{}", i);
+      ++failed;
+      continue;
+    }
+    const std::string_view name = zip_entry_name(zip);
+    if (std::ranges::any_of(excludes, [&](const Glob &glob) {
+          return glob.match(name);
+        })) {
+      zip_entry_close(zip);
+      continue;
+    }
+    const auto path = entry_path(output_dir, name);
+    if (!path) {
+      std::println("skip unsafe zip entry: {}", zip_entry_name(zip));
+    } else if (zip_entry_isdir(zip) == 1) {
+      directories.push_back(*path);
+    } else {
+      directories.push_back(path->parent_path());
+      tasks.push_back({i, zip_entry_header_offset(zip),
+                       zip_entry_size(zip), zip_entry_crc32(zip),
+                       zip_entry_mtime(zip), modes[i], *path, std::nullopt});
+    }
+    zip_entry_close(zip);
+  }
+  // 规范化后同名的 entry 只保留最后一个, 与逐个解压留下的结果一致,
+  // 否则多个线程会同时写同一个文件
+  {
+    std::unordered_set<std::string> seen;
+    std::vector<ExtractTask> unique;
+    unique.reserve(tasks.size());
+    for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+      if (seen.insert(it->path.generic_string()).second) {
+        unique.push_back(std::move(*it));
+      }
+    }
+    std::ranges::reverse(unique);
+    tasks = std::move(unique);
+  }
+  for (const auto &task : tasks) {
+    total_bytes += task.size;
+  }
+
+  std::ranges::sort(directories);
+  const auto [first, last] = std::ranges::unique(directories);
+  directories.erase(first, last);
+  for (const auto &directory : directories) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+      std::println("failed to create directory: {}", directory.string());
+      ++failed;
+    }
+  }
+
+  // 按数据在压缩包中的位置顺序读取
+  std::ranges::sort(tasks, {}, &ExtractTask::header_offset);
+
+  // 第一轮解压各组的第一个文件, 第二轮再处理可能重复的文件
+  std::vector<size_t> unique_tasks;
+  std::vector<size_t> duplicate_tasks;
+  std::map<std::pair<std::uint64_t, std::uint32_t>, size_t> first_seen;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    if (options.dedup && tasks[i].size > 0) {
+      const auto [it, inserted] =
+          first_seen.try_emplace({tasks[i].size, tasks[i].crc32}, i);
+      if (!inserted) {
+        tasks[i].source = it->second;
+        duplicate_tasks.push_back(i);
+        continue;
+      }
+    }
+    unique_tasks.push_back(i);
+  }
+
+  const auto jobs = worker_count(options.jobs, tasks.size());
+  int errnum = 0;
+  auto cursors = open_cursors(zip, jobs, errnum);
+  if (cursors.empty()) {
+    std::println("zip cursor open error: {}", zip_strerror(errnum));
+    zip_close(zip);
+    return 1;
+  }
+
+  std::atomic<std::uint64_t> done{0};
+  std::atomic<int> failed_files{0};
+  std::atomic<size_t> skipped{0};
+  std::atomic<size_t> deduped{0};
+  // 每个文件只由一个线程写入, 用 char 避免 vector<bool> 的位共享
+  std::vector<char> extracted(tasks.size(), 0);
+  const auto run = [&](const std::vector<size_t> &order, auto work) {
+    run_workers(
+        jobs, order.size(),
+        [&](unsigned worker, size_t i) {
+          const auto index = order[i];
+          const auto &task = tasks[index];
+          if (options.skip_unchanged && unchanged(task, options.check_crc)) {
+            done.fetch_add(task.size, std::memory_order_relaxed);
+            ++skipped;
+            extracted[index] = 1;
+            return;
+          }
+          if (work(cursors[worker].get(), task)) {
+            extracted[index] = 1;
+          } else {
+            ++failed_files;
+          }
+        },
+        [&] {
+          on_progress(done.load(std::memory_order_relaxed), total_bytes);
+        });
+  };
+
+  run(unique_tasks, [&](zip_cursor_t *cursor, const ExtractTask &task) {
+    // 上次 dedup 留下的硬链接要先断开再写
+    if (options.dedup) {
+      std::error_code ec;
+      fs::remove(task.path, ec);
+    }
+    return extract_file(cursor, task, done);
+  });
+  run(duplicate_tasks, [&](zip_cursor_t *cursor, const ExtractTask &task) {
+    const auto &source = tasks[*task.source];
+    if (extracted[*task.source] && same_content(cursor, task, source.path) &&
+        link_file(task, source, options.hardlink)) {
+      done.fetch_add(task.size, std::memory_order_relaxed);
+      ++deduped;
+      return true;
+    }
+    std::error_code ec;
+    fs::remove(task.path, ec);
+    return extract_file(cursor, task, done);
+  });
+  on_progress(done.load(), total_bytes);
+  if (skipped.load() > 0) {
+    std::println("skipped {} unchanged files", skipped.load());
+  }
+  if (deduped.load() > 0) {
+    std::println("deduplicated {} files", deduped.load());
+  }
+
+  cursors.clear();
+  zip_close(zip);
+  return failed + failed_files.load() > 0 ? 1 : 0;
+}
+
+} // namespace Utils
@@ -0,0 +1,173 @@
+module;
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+export module Utils.Glob;
+
+namespace Utils {
+// 编译一次, 按 entry 名匹配的 glob:
+// `*` 和 `?` 不跨越 `/`, `**` 匹配任意层级, `[a-z]` / `[!a-z]` 匹配字符集合,
+// `\` 转义下一个字符, 以 `/` 结尾的模式匹配该目录下的所有 entry
+export class Glob {
+public:
+  explicit Glob(std::string_view pattern) : pattern_(pattern) {
+    if (pattern.ends_with('/')) {
+      pattern_ += "**";
+    }
+    compile();
+  }
+
+  // 第一个通配符之前的字面量, 可以在排好序的名字里做范围查询
+  const std::string &prefix() const noexcept { return prefix_; }
+  const std::string &pattern() const noexcept { return pattern_; }
+
+  // 目录 entry 带或不带结尾的 `/` 匹配上都算
+  bool match(std::string_view name) const {
+    return matches(name) || (name.size() > 1 && name.ends_with('/') &&
+                             matches(name.substr(0, name.size() - 1)));
+  }
+
+private:
+  enum class Kind { literal, any, set, star, globstar, directories };
+  struct Token {
+    Kind kind{Kind::literal};
+    char ch{};
+    bool negated{false};
+    // 成对保存的闭区间
+    std::string ranges;
+  };
+
+  bool matches(std::string_view name) const {
+    const auto n = name.size();
+    // states[i] 表示已匹配的 token 能恰好消耗 name 的前 i 个字符
+    std::vector<char> states(n + 1, 0);
+    std::vector<char> next(n + 1, 0);
+    states[0] = 1;
+    for (const auto &token : tokens_) {
+      std::ranges::fill(next, 0);
+      bool reach = false;
+      for (size_t i = 0; i <= n; ++i) {
+        switch (token.kind) {
+        case Kind::literal:
+          if (states[i] && i < n && name[i] == token.ch) {
+            next[i + 1] = 1;
+          }
+          break;
+        case Kind::any:
+          if (states[i] && i < n && name[i] != '/') {
+            next[i + 1] = 1;
+          }
+          break;
+        case Kind::set:
+          if (states[i] && i < n && name[i] != '/' &&
+              in_set(token, name[i])) {
+            next[i + 1] = 1;
+          }
+          break;
+        case Kind::star:
+          reach = states[i] || (reach && name[i - 1] != '/');
+          next[i] = reach;
+          break;
+        case Kind::globstar:
+          reach = reach || states[i];
+          next[i] = reach;
+          break;
+        case Kind::directories:
+          // `**/`: 空串或以 `/` 结尾的任意层级
+          next[i] = states[i] || (reach && name[i - 1] == '/');
+          reach = reach || states[i];
+          break;
+        }
+      }
+      std::swap(states, next);
+      if (std::ranges::find(states, 1) == states.end()) {
+        return false;
+      }
+    }
+    return states[n] != 0;
+  }
+
+  static bool in_set(const Token &token, char c) {
+    bool found = false;
+    for (size_t i = 0; i + 1 < token.ranges.size(); i += 2) {
+      if (token.ranges[i] <= c && c <= token.ranges[i + 1]) {
+        found = true;
+        break;
+      }
+    }
+    return found != token.negated;
+  }
+
+  void compile() {
+    const std::string_view pattern = pattern_;
+    bool literal_prefix = true;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      Token token;
+      token.ch = pattern[i];
+      if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+        token.ch = pattern[++i];
+      } else if (pattern[i] == '?') {
+        token.kind = Kind::any;
+      } else if (pattern[i] == '*') {
+        if (i + 1 < pattern.size() && pattern[i + 1] == '*') {
+          ++i;
+          token.kind = Kind::globstar;
+          if (i + 1 < pattern.size() && pattern[i + 1] == '/') {
+            ++i;
+            token.kind = Kind::directories;
+          }
+        } else {
+          token.kind = Kind::star;
+        }
+      } else if (pattern[i] == '[') {
+        const auto end = parse_set(pattern, i, token);
+        if (end != std::string_view::npos) {
+          token.kind = Kind::set;
+          i = end;
+        }
+      }
+      if (token.kind != Kind::literal) {
+        literal_prefix = false;
+      } else if (literal_prefix) {
+        prefix_ += token.ch;
+      }
+      tokens_.push_back(std::move(token));
+    }
+  }
+
+  // 返回 `]` 的位置, 没有闭合时返回 npos, `[` 按字面量处理
+  static size_t parse_set(std::string_view pattern, size_t open,
+                          Token &token) {
+    size_t i = open + 1;
+    if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^')) {
+      token.negated = true;
+      ++i;
+    }
+    const auto first = i;
+    std::string ranges;
+    for (; i < pattern.size(); ++i) {
+      if (pattern[i] == ']' && i != first) {
+        token.ranges = std::move(ranges);
+        return i;
+      }
+      const char lo = pattern[i];
+      char hi = lo;
+      if (i + 2 < pattern.size() && pattern[i + 1] == '-' &&
+          pattern[i + 2] != ']') {
+        hi = pattern[i + 2];
+        i += 2;
+      }
+      ranges += lo;
+      ranges += hi;
+    }
+    token.negated = false;
+    return std::string_view::npos;
+  }
+
+  std::string pattern_;
+  std::string prefix_;
+  std::vector<Token> tokens_;
+};
+} // namespace Utils
@@ -0,0 +1,184 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <print>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+export module Utils.Gzip;
+import Utils.Reader;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+struct GzipTask {
+  size_t index;
+  fs::path path;
+  std::uint64_t comp_size;
+  bool deflated;
+  bool failed{false};
+};
+
+struct GzipContext {
+  const fs::path &dir;
+  std::vector<GzipTask> tasks{};
+  size_t skipped{0};
+};
+
+int collect_gzip_task(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<GzipContext *>(arg);
+  if (info->isdir) {
+    return 0;
+  }
+  const auto relative =
+      fs::path(std::string_view{info->name, info->namelen}).lexically_normal();
+  if (relative.empty() || relative.has_root_path() ||
+      *relative.begin() == "..") {
+    ++context.skipped;
+    return 0;
+  }
+  auto path = context.dir / relative;
+  path += ".gz";
+  // 未压缩的 entry 也先留着, 它可能覆盖前面的同名 entry
+  context.tasks.push_back(
+      {info->index, std::move(path), info->comp_size, info->method == 8});
+  return 0;
+}
+
+size_t write_gzip_chunk(void *arg, std::uint64_t, const void *data,
+                        size_t size) {
+  return std::fwrite(data, 1, size, static_cast<std::FILE *>(arg));
+}
+
+void store_le32(unsigned char *p, std::uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<unsigned char>(value >> (8 * i));
+  }
+}
+
+// deflate 数据本身就是 gzip 的 member 主体, 只需补上 10 字节头和
+// CRC-32, ISIZE 尾部
+bool write_gzip_file(zip_cursor_t *cursor, const GzipTask &task) {
+  if (zip_cursor_entry_openbyindex(cursor, task.index) != 0) {
+    return false;
+  }
+  std::FILE *file = std::fopen(task.path.string().c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  // 数据按 64 KiB 一块交过来, 不再经过 stdio 缓冲
+  std::setvbuf(file, nullptr, _IONBF, 0);
+  // MTIME 为 0 表示没有时间戳, OS 255 表示未知
+  constexpr std::array<unsigned char, 10> header{0x1f, 0x8b, 8, 0, 0,
+                                                 0,    0,    0, 0, 255};
+  std::array<unsigned char, 8> trailer;
+  store_le32(trailer.data(), zip_cursor_entry_crc32(cursor));
+  store_le32(trailer.data() + 4,
+             static_cast<std::uint32_t>(zip_cursor_entry_size(cursor)));
+  const bool ok =
+      std::fwrite(header.data(), 1, header.size(), file) == header.size() &&
+      zip_cursor_entry_rawextract(cursor, write_gzip_chunk, file) == 0 &&
+      std::fwrite(trailer.data(), 1, trailer.size(), file) == trailer.size();
+  const bool closed = std::fclose(file) == 0;
+  if (!ok || !closed) {
+    std::error_code ec;
+    fs::remove(task.path, ec);
+    return false;
+  }
+  return true;
+}
+
+// 把 deflate 压缩的 entry 原样包装成 dir 下同名的 .gz 文件, 不解压任何数据;
+// 未压缩, 路径越出 dir 和被后面同名 entry 覆盖的 entry 跳过
+export int export_gz(const fs::path &zip_path, const fs::path &dir,
+                     unsigned jobs) {
+  std::unique_ptr<zip_t, ZipClose> zip{
+      zip_open(zip_path.string().c_str(), 0, 'r')};
+  if (!zip) {
+    std::println("zip open error");
+    return 1;
+  }
+
+  GzipContext context{dir};
+  if (zip_entries_foreach(zip.get(), collect_gzip_task, &context) < 0) {
+    std::println("failed to read central directory");
+    return 1;
+  }
+  auto &tasks = context.tasks;
+  // 规范化后同名的 entry 会写同一个 .gz, 与解压一样以最后一个为准
+  {
+    std::unordered_set<std::string> seen;
+    std::vector<GzipTask> unique;
+    unique.reserve(tasks.size());
+    for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+      if (seen.insert(it->path.generic_string()).second && it->deflated) {
+        unique.push_back(std::move(*it));
+      } else {
+        ++context.skipped;
+      }
+    }
+    std::ranges::reverse(unique);
+    tasks = std::move(unique);
+  }
+
+  // 目录先在主线程建好, 工作线程只写文件
+  std::set<fs::path> parents;
+  for (const auto &task : tasks) {
+    parents.insert(task.path.parent_path());
+  }
+  for (const auto &parent : parents) {
+    std::error_code ec;
+    fs::create_directories(parent, ec);
+    if (ec) {
+      std::println("failed to create directory: {}", parent.string());
+      return 1;
+    }
+  }
+
+  jobs = worker_count(jobs, tasks.size());
+  // cursor 必须在单个线程上创建, 之后各线程独立使用
+  std::vector<CursorPtr> cursors;
+  if (!tasks.empty()) {
+    int errnum = 0;
+    cursors = open_cursors(zip.get(), jobs, errnum);
+    if (cursors.empty()) {
+      std::println("zip cursor open error");
+      return 1;
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  run_workers(jobs, tasks.size(), [&](unsigned worker, size_t i) {
+    tasks[i].failed = !write_gzip_file(cursors[worker].get(), tasks[i]);
+  });
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  cursors.clear();
+  zip.reset();
+
+  size_t failed = 0;
+  std::uint64_t total_size = 0;
+  for (const auto &task : tasks) {
+    if (task.failed) {
+      std::println("failed to export: {}", task.path.string());
+      ++failed;
+    } else {
+      total_size += task.comp_size;
+    }
+  }
+  std::println("exported {} files, {:.1f} MiB in {:.2f}s; {} skipped, {} "
+               "failed",
+               tasks.size() - failed,
+               static_cast<double>(total_size) / (1 << 20),
+               elapsed.count(), context.skipped, failed);
+  return failed == 0 ? 0 : 1;
+}
+} // namespace Utils
@@ -0,0 +1,157 @@
+module;
+#include "zip.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <print>
+#include <string>
+#include <string_view>
+export module Utils.List;
+namespace fs = std::filesystem;
+
+namespace Utils {
+export enum class ListFormat { text, json, ndjson };
+
+struct ListContext {
+  ListFormat format;
+  std::FILE *out;
+  std::string buffer{};
+  size_t count{0};
+  std::uint64_t total_size{0};
+  std::uint64_t total_comp_size{0};
+};
+
+void append_json_string(std::string &buffer, std::string_view value) {
+  buffer += '"';
+  for (const char c : value) {
+    switch (c) {
+    case '"':
+      buffer += "\\\"";
+      break;
+    case '\\':
+      buffer += "\\\\";
+      break;
+    case '\n':
+      buffer += "\\n";
+      break;
+    case '\r':
+      buffer += "\\r";
+      break;
+    case '\t':
+      buffer += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        std::format_to(std::back_inserter(buffer), "\\u{:04x}",
+                       static_cast<unsigned>(c));
+      } else {
+        buffer += c;
+      }
+    }
+  }
+  buffer += '"';
+}
+
+// MS-DOS 日期时间原样输出, 不经过时区换算
+void append_dos_time(std::string &buffer, const zip_entry_info_t &info,
+                     char separator) {
+  std::format_to(std::back_inserter(buffer),
+                 "{:04}-{:02}-{:02}{}{:02}:{:02}:{:02}",
+                 (info.dos_date >> 9) + 1980, (info.dos_date >> 5) & 0xF,
+                 info.dos_date & 0x1F, separator, info.dos_time >> 11,
+                 (info.dos_time >> 5) & 0x3F, (info.dos_time & 0x1F) * 2);
+}
+
+std::string_view method_name(int method) {
+  switch (method) {
+  case 0:
+    return "Stored";
+  case 8:
+    return "Deflate";
+  default:
+    return "Unknown";
+  }
+}
+
+void flush(ListContext &context) {
+  std::fwrite(context.buffer.data(), 1, context.buffer.size(), context.out);
+  context.buffer.clear();
+}
+
+int list_entry(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<ListContext *>(arg);
+  auto &buffer = context.buffer;
+  const std::string_view name{info->name, info->namelen};
+  if (context.format == ListFormat::text) {
+    std::format_to(std::back_inserter(buffer), "{:>12} {:>12}  {:<7} ",
+                   info->uncomp_size, info->comp_size,
+                   method_name(info->method));
+    append_dos_time(buffer, *info, ' ');
+    buffer += "  ";
+    buffer += name;
+    buffer += '\n';
+  } else {
+    if (context.format == ListFormat::json) {
+      buffer += context.count == 0 ? "\n  " : ",\n  ";
+    }
+    buffer += "{\"name\":";
+    append_json_string(buffer, name);
+    std::format_to(std::back_inserter(buffer),
+                   ",\"size\":{},\"compressed_size\":{},\"crc32\":{},"
+                   "\"method\":{},\"offset\":{},\"is_dir\":{},\"mtime\":\"",
+                   info->uncomp_size, info->comp_size, info->crc32,
+                   info->method, info->header_offset, info->isdir != 0);
+    append_dos_time(buffer, *info, 'T');
+    buffer += "\"}";
+    if (context.format == ListFormat::ndjson) {
+      buffer += '\n';
+    }
+  }
+  ++context.count;
+  context.total_size += info->uncomp_size;
+  context.total_comp_size += info->comp_size;
+  if (buffer.size() >= 64 * 1024) {
+    flush(context);
+  }
+  return 0;
+}
+
+// 直接遍历中央目录记录, 每个 entry 不做任何分配, 输出攒成 64 KiB 再写.
+// 's' 模式按窗口流式读中央目录, 内存占用与 entry 数无关
+export int list(const fs::path &zip_path, ListFormat format,
+                std::FILE *out) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 's');
+  if (zip == nullptr) {
+    std::println(stderr, "zip open error");
+    return 1;
+  }
+
+  ListContext context{format, out};
+  context.buffer.reserve(128 * 1024);
+  if (format == ListFormat::text) {
+    context.buffer += "        Size   Compressed  Method  Modified             "
+                      "Name\n";
+  } else if (format == ListFormat::json) {
+    context.buffer += '[';
+  }
+  const auto n = zip_entries_foreach(zip, list_entry, &context);
+  if (format == ListFormat::text) {
+    std::format_to(std::back_inserter(context.buffer),
+                   "{:>12} {:>12}  {} entries\n", context.total_size,
+                   context.total_comp_size, context.count);
+  } else if (format == ListFormat::json) {
+    context.buffer += context.count == 0 ? "]\n" : "\n]\n";
+  }
+  flush(context);
+  zip_close(zip);
+
+  if (n < 0) {
+    std::println(stderr, "failed to read central directory: {}",
+                 zip_strerror(static_cast<int>(n)));
+    return 1;
+  }
+  return std::fflush(out) == 0 ? 0 : 1;
+}
+} // namespace Utils
@@ -0,0 +1,116 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <print>
+#include <string>
+#include <unordered_map>
+#include <vector>
+export module Utils.Merge;
+import Utils.Reader;
+namespace fs = std::filesystem;
+
+namespace Utils {
+export enum class MergeConflict { first_wins, last_wins };
+
+struct MergeSource {
+  size_t archive;
+  size_t index;
+  std::uint64_t header_offset;
+  std::uint64_t comp_size;
+};
+
+struct MergeContext {
+  size_t archive;
+  MergeConflict conflict;
+  std::unordered_map<std::string, MergeSource> winners{};
+  size_t duplicates{0};
+};
+
+int collect_merge_entry(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<MergeContext *>(arg);
+  const MergeSource source{context.archive, info->index, info->header_offset,
+                           info->comp_size};
+  auto [it, inserted] =
+      context.winners.try_emplace(std::string{info->name, info->namelen},
+                                  source);
+  if (!inserted) {
+    ++context.duplicates;
+    if (context.conflict == MergeConflict::last_wins) {
+      it->second = source;
+    }
+  }
+  return 0;
+}
+
+// 只拷贝压缩后的字节, 不解压也不重新压缩; 同名 entry 按 conflict 保留一个,
+// 输出顺序为输入顺序, 同一个输入内按数据在文件中的位置顺序读取
+export int merge(const fs::path &output, const std::vector<fs::path> &inputs,
+                 MergeConflict conflict) {
+  std::vector<std::unique_ptr<zip_t, ZipClose>> sources;
+  MergeContext context{0, conflict};
+  for (const auto &input : inputs) {
+    std::error_code ec;
+    if (fs::equivalent(input, output, ec)) {
+      std::println("output must not be one of the inputs: {}",
+                   input.string());
+      return 1;
+    }
+    sources.emplace_back(zip_open(input.string().c_str(), 0, 'r'));
+    if (!sources.back()) {
+      std::println("zip open error: {}", input.string());
+      return 1;
+    }
+    context.archive = sources.size() - 1;
+    if (zip_entries_foreach(sources.back().get(), collect_merge_entry,
+                            &context) < 0) {
+      std::println("failed to read central directory: {}", input.string());
+      return 1;
+    }
+  }
+
+  std::vector<MergeSource> selected;
+  selected.reserve(context.winners.size());
+  std::uint64_t total_bytes = 0;
+  for (const auto &[name, source] : context.winners) {
+    selected.push_back(source);
+    total_bytes += source.comp_size;
+  }
+  std::ranges::sort(selected, [](const MergeSource &l, const MergeSource &r) {
+    return l.archive != r.archive ? l.archive < r.archive
+                                  : l.header_offset < r.header_offset;
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  int errnum = 0;
+  const auto zip = zip_openwitherror(output.string().c_str(), 0, 'w', &errnum);
+  if (zip == nullptr) {
+    std::println("zip open error: {}", zip_strerror(errnum));
+    return 1;
+  }
+  for (const auto &source : selected) {
+    const int err =
+        zip_entry_rawcopy(zip, sources[source.archive].get(), source.index);
+    if (err < 0) {
+      std::println("failed to copy entry #{} of {}: {}", source.index,
+                   inputs[source.archive].string(), zip_strerror(err));
+      zip_close(zip);
+      std::error_code ec;
+      fs::remove(output, ec);
+      return 1;
+    }
+  }
+  zip_close(zip);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::println("merged {} entries from {} archives, {} duplicates skipped, "
+               "{:.1f} MiB in {:.2f}s",
+               selected.size(), inputs.size(), context.duplicates,
+               static_cast<double>(total_bytes) / (1 << 20), elapsed.count());
+  return 0;
+}
+} // namespace Utils
@@ -0,0 +1,269 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+export module Utils.Prefetch;
+import Utils.Reader;
+
+namespace Utils {
+export enum class StreamOrder { central_directory, local_offset };
+
+export struct StreamedChunk {
+  size_t index;
+  std::string_view name;
+  // data 在 entry 解压后数据中的偏移
+  std::uint64_t offset;
+  // 解压后的一段数据, 只在回调期间有效
+  std::span<const std::byte> data;
+  // entry 的最后一块 (可能为空), 此时 CRC-32 已校验
+  bool last;
+  // 解压失败时为 zip 错误码, 此时 last 为 true, data 为空
+  int error;
+};
+
+export template <typename Filter>
+concept StreamFilter = std::predicate<Filter &, std::string_view>;
+
+// 返回 false 停止遍历
+export template <typename Callback>
+concept StreamCallback = std::predicate<Callback &, const StreamedChunk &>;
+
+struct PrefetchTask {
+  size_t index;
+  std::uint64_t header_offset;
+  std::uint64_t size;
+  std::string name;
+};
+
+struct PrefetchBuffer {
+  std::unique_ptr<std::byte[]> data{};
+  size_t capacity{0};
+};
+
+struct PrefetchSlot {
+  size_t task;
+  std::uint64_t offset;
+  PrefetchBuffer buffer;
+  size_t size;
+  bool last;
+  int error;
+};
+
+template <typename Filter> struct PrefetchContext {
+  Filter &filter;
+  std::vector<PrefetchTask> tasks{};
+};
+
+template <typename Filter>
+int collect_prefetch_task(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<PrefetchContext<Filter> *>(arg);
+  const std::string_view name{info->name, info->namelen};
+  if (!info->isdir && context.filter(name)) {
+    context.tasks.push_back(
+        {info->index, info->header_offset, info->uncomp_size,
+         std::string{name}});
+  }
+  return 0;
+}
+
+// 后台线程和调用方之间的分块队列, 已解压还没处理的块合计不超过 memory 字节
+struct PrefetchQueue {
+  static constexpr size_t chunk_size = 1 << 20;
+
+  size_t memory;
+  std::stop_token stop{};
+  std::mutex mutex{};
+  std::condition_variable_any ready_cv{};
+  std::condition_variable_any space_cv{};
+  std::deque<PrefetchSlot> ready{};
+  // 只缓存 chunk_size 大小的缓冲, 小 entry 的缓冲用完就释放
+  std::vector<PrefetchBuffer> free_buffers{};
+  size_t in_flight{0};
+
+  // 等到预算够用时取一块至少 size 字节的缓冲, 停止时返回空缓冲
+  PrefetchBuffer acquire(size_t size) {
+    PrefetchBuffer buffer;
+    {
+      std::unique_lock lock{mutex};
+      if (!space_cv.wait(lock, stop, [&] {
+            return in_flight == 0 || in_flight + size <= memory;
+          })) {
+        return buffer;
+      }
+      in_flight += size;
+      if (size == chunk_size && !free_buffers.empty()) {
+        buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+      }
+    }
+    if (buffer.capacity < size) {
+      // 数据会被完整覆盖, 不需要清零
+      buffer.capacity = size;
+      buffer.data = std::make_unique_for_overwrite<std::byte[]>(size);
+    }
+    return buffer;
+  }
+
+  void release(PrefetchBuffer buffer) {
+    {
+      std::lock_guard lock{mutex};
+      in_flight -= buffer.capacity;
+      if (buffer.capacity == chunk_size) {
+        free_buffers.push_back(std::move(buffer));
+      }
+    }
+    space_cv.notify_one();
+  }
+
+  void push(PrefetchSlot slot) {
+    {
+      std::lock_guard lock{mutex};
+      ready.push_back(std::move(slot));
+    }
+    ready_cv.notify_one();
+  }
+};
+
+// 把 cursor 解压出的数据切成块放进队列
+struct PrefetchWriter {
+  PrefetchQueue &queue;
+  size_t task;
+  std::uint64_t size;
+  std::uint64_t offset{0};
+  PrefetchBuffer buffer{};
+  size_t filled{0};
+
+  void push(bool last, int error) {
+    const auto chunk_offset = offset;
+    offset += filled;
+    queue.push({task, chunk_offset, std::move(buffer), filled, last, error});
+    buffer = {};
+    filled = 0;
+  }
+};
+
+size_t write_prefetch_chunk(void *arg, std::uint64_t, const void *data,
+                            size_t size) {
+  auto &writer = *static_cast<PrefetchWriter *>(arg);
+  const auto *p = static_cast<const std::byte *>(data);
+  for (size_t left = size; left > 0;) {
+    if (writer.buffer.capacity == 0) {
+      // 中央目录里的大小只用来决定缓冲大小, 数据更多时按块继续
+      const auto remaining =
+          writer.size > writer.offset ? writer.size - writer.offset : 0;
+      writer.buffer = writer.queue.acquire(
+          remaining == 0 ? PrefetchQueue::chunk_size
+                         : static_cast<size_t>(std::min<std::uint64_t>(
+                               remaining, PrefetchQueue::chunk_size)));
+      if (writer.buffer.capacity == 0) {
+        return 0;
+      }
+    }
+    const auto n = std::min(left, writer.buffer.capacity - writer.filled);
+    std::memcpy(writer.buffer.data.get() + writer.filled, p, n);
+    writer.filled += n;
+    p += n;
+    left -= n;
+    if (writer.filled == writer.buffer.capacity) {
+      writer.push(false, 0);
+    }
+  }
+  return size;
+}
+
+// 后台线程用一个 cursor 提前读取并解压后面的 entry,
+// 调用方处理当前数据时 I/O 和 inflate 继续进行.
+// entry 按最多 1 MiB 一块交给 on_chunk, 已解压还没处理的块合计不超过
+// memory 字节, 与 entry 大小无关; 目录跳过.
+// 返回最后一块已交给 on_chunk 的 entry 数, 出错时返回 zip 错误码
+export template <StreamFilter Filter, StreamCallback Callback>
+ssize_t entries_stream(zip_t *zip, StreamOrder order, size_t memory,
+                       Filter filter, Callback on_chunk) {
+  PrefetchContext<Filter> context{filter};
+  if (const auto err = zip_entries_foreach(
+          zip, collect_prefetch_task<Filter>, &context);
+      err < 0) {
+    return err;
+  }
+  auto &tasks = context.tasks;
+  if (order == StreamOrder::local_offset) {
+    std::ranges::stable_sort(tasks, {}, &PrefetchTask::header_offset);
+  }
+
+  int errnum = 0;
+  // cursor 必须在单个线程上创建, 之后只由后台线程使用
+  const CursorPtr cursor{zip_cursor_open(zip, &errnum)};
+  if (!cursor) {
+    return errnum;
+  }
+
+  PrefetchQueue queue{memory};
+  std::jthread producer([&](std::stop_token stop) {
+    queue.stop = stop;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      PrefetchWriter writer{queue, i, tasks[i].size};
+      int err = zip_cursor_entry_openbyindex(cursor.get(), tasks[i].index);
+      if (err == 0) {
+        err = zip_cursor_entry_extract(cursor.get(), write_prefetch_chunk,
+                                       &writer);
+      }
+      if (stop.stop_requested()) {
+        return;
+      }
+      if (err < 0) {
+        // 已经交出去的块由调用方处理, 只报告错误
+        if (writer.buffer.capacity > 0) {
+          queue.release(std::move(writer.buffer));
+          writer.buffer = {};
+        }
+        writer.filled = 0;
+      }
+      writer.push(true, err);
+    }
+  });
+
+  size_t visited = 0;
+  while (visited < tasks.size()) {
+    PrefetchSlot slot;
+    {
+      std::unique_lock lock{queue.mutex};
+      queue.ready_cv.wait(lock, [&] { return !queue.ready.empty(); });
+      slot = std::move(queue.ready.front());
+      queue.ready.pop_front();
+    }
+    const auto &task = tasks[slot.task];
+    const StreamedChunk chunk{
+        task.index,
+        task.name,
+        slot.offset,
+        std::span<const std::byte>{slot.buffer.data.get(), slot.size},
+        slot.last,
+        slot.error};
+    const bool next = on_chunk(chunk);
+    if (slot.buffer.capacity > 0) {
+      queue.release(std::move(slot.buffer));
+    }
+    if (slot.last) {
+      ++visited;
+    }
+    if (!next) {
+      break;
+    }
+  }
+  producer.request_stop();
+  return static_cast<ssize_t>(visited);
+}
+} // namespace Utils
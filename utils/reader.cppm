@@ -0,0 +1,115 @@
+module;
+#include "zip.h"
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+export module Utils.Reader;
+
+namespace Utils {
+export struct ZipClose {
+  void operator()(zip_t *zip) const noexcept { zip_close(zip); }
+};
+
+export struct CursorClose {
+  void operator()(zip_cursor_t *cursor) const noexcept {
+    zip_cursor_close(cursor);
+  }
+};
+
+export using CursorPtr = std::unique_ptr<zip_cursor_t, CursorClose>;
+
+// cursor 必须在单个线程上创建, 之后各线程独立使用;
+// 任何一个打开失败时返回空, errnum 为 zip 错误码
+export std::vector<CursorPtr> open_cursors(zip_t *zip, unsigned count,
+                                           int &errnum) {
+  std::vector<CursorPtr> cursors;
+  cursors.reserve(count);
+  for (unsigned i = 0; i < count; ++i) {
+    errnum = 0;
+    cursors.emplace_back(zip_cursor_open(zip, &errnum));
+    if (!cursors.back()) {
+      cursors.clear();
+      break;
+    }
+  }
+  return cursors;
+}
+
+// 以 std::span<const std::byte> 分块读取当前 entry 的输入范围,
+// 数据在读到末尾时校验 CRC-32
+export class EntryReader {
+public:
+  class iterator {
+  public:
+    using value_type = std::span<const std::byte>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    explicit iterator(EntryReader *reader) : reader_(reader) {}
+
+    value_type operator*() const { return reader_->chunk_; }
+    iterator &operator++() {
+      reader_->advance();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(std::default_sentinel_t) const {
+      return reader_ == nullptr || reader_->done_;
+    }
+
+  private:
+    EntryReader *reader_{nullptr};
+  };
+
+  explicit EntryReader(zip_t *zip) {
+    int errnum = 0;
+    reader_.reset(zip_reader_open(zip, &errnum));
+    if (!reader_) {
+      throw std::runtime_error(error_message(errnum));
+    }
+  }
+
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      advance();
+    }
+    return iterator{this};
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  struct Close {
+    void operator()(zip_reader_t *reader) const noexcept {
+      zip_reader_close(reader);
+    }
+  };
+
+  static const char *error_message(int errnum) {
+    const char *message = zip_strerror(errnum);
+    return message != nullptr ? message : "zip reader error";
+  }
+
+  void advance() {
+    const void *chunk = nullptr;
+    const auto n = zip_reader_next(reader_.get(), &chunk);
+    if (n < 0) {
+      done_ = true;
+      throw std::runtime_error(error_message(static_cast<int>(n)));
+    }
+    done_ = n == 0;
+    chunk_ = {static_cast<const std::byte *>(chunk), static_cast<size_t>(n)};
+  }
+
+  std::unique_ptr<zip_reader_t, Close> reader_;
+  std::span<const std::byte> chunk_;
+  bool started_{false};
+  bool done_{false};
+};
+
+static_assert(std::ranges::input_range<EntryReader>);
+} // namespace Utils
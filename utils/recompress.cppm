@@ -0,0 +1,344 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+export module Utils.Recompress;
+import Utils.Reader;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+struct RecompressTask {
+  size_t index;
+  std::string name;
+  std::uint64_t uncomp_size;
+  std::uint32_t crc32;
+  int method;
+  unsigned short dos_date;
+  unsigned short dos_time;
+  unsigned int external_attr;
+  // false 时原样拷贝压缩数据
+  bool recompress;
+};
+
+struct RecompressFree {
+  void operator()(void *p) const noexcept { std::free(p); }
+};
+
+struct RecompressResult {
+  bool ready{false};
+  bool failed{false};
+  // 缓冲分配失败, 也算 failed
+  bool out_of_memory{false};
+  // 数据接近随机, 保持原来的存储方式
+  bool incompressible{false};
+  int method{0};
+  std::vector<char> inflated{};
+  std::unique_ptr<void, RecompressFree> deflated{};
+  size_t deflated_size{0};
+};
+
+struct RecompressContext {
+  int level;
+  bool force;
+  bool keep_deflated;
+  std::vector<RecompressTask> tasks{};
+};
+
+// 压缩包里不记录 deflate 用的压缩级别 (miniz 不写通用标志位的 1-2 位),
+// 只能按压缩方式判断: 未压缩的 entry 在 level 0 时拷贝,
+// deflate 的 entry 只在 keep_deflated 时拷贝
+int collect_recompress_task(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<RecompressContext *>(arg);
+  bool matches = info->isdir;
+  if (!context.force && !matches) {
+    matches = context.level == 0 ? info->method == 0
+                                 : context.keep_deflated && info->method == 8;
+  }
+  context.tasks.push_back({info->index, std::string{info->name, info->namelen},
+                           info->uncomp_size, info->crc32, info->method,
+                           info->dos_date, info->dos_time, info->external_attr,
+                           !matches});
+  return 0;
+}
+
+struct InflateContext {
+  std::vector<char> &buffer;
+  std::uint64_t limit;
+};
+
+// 数据超过中央目录记录的大小时中止, 缓冲不会超过预算里计入的字节数
+size_t append_chunk(void *arg, std::uint64_t, const void *data, size_t size) {
+  auto &context = *static_cast<InflateContext *>(arg);
+  if (size > context.limit - context.buffer.size()) {
+    return 0;
+  }
+  const auto *p = static_cast<const char *>(data);
+  context.buffer.insert(context.buffer.end(), p, p + size);
+  return size;
+}
+
+// 只看开头 64 KiB 的字节分布, 熵接近 8 bit 的数据 deflate 也压不动
+bool looks_incompressible(const std::vector<char> &data) {
+  const size_t n = std::min<size_t>(data.size(), 64 * 1024);
+  if (n < 4096) {
+    return false;
+  }
+  std::array<size_t, 256> counts{};
+  for (size_t i = 0; i < n; ++i) {
+    ++counts[static_cast<unsigned char>(data[i])];
+  }
+  double entropy = 0;
+  for (const auto count : counts) {
+    if (count > 0) {
+      const double p = static_cast<double>(count) / static_cast<double>(n);
+      entropy -= p * std::log2(p);
+    }
+  }
+  return entropy > 7.5;
+}
+
+void recompress_entry(zip_cursor_t *cursor, const RecompressTask &task,
+                      int level, RecompressResult &result) {
+  if (task.uncomp_size > result.inflated.max_size()) {
+    result.failed = true;
+    result.out_of_memory = true;
+    return;
+  }
+  // 大小来自中央目录, 不可信时也不一次预留太多
+  result.inflated.reserve(static_cast<size_t>(
+      std::min<std::uint64_t>(task.uncomp_size, 64 << 20)));
+  InflateContext inflate{result.inflated, task.uncomp_size};
+  if (zip_cursor_entry_openbyindex(cursor, task.index) != 0 ||
+      zip_cursor_entry_extract(cursor, append_chunk, &inflate) < 0) {
+    result.failed = true;
+    return;
+  }
+  if (level > 0 && looks_incompressible(result.inflated)) {
+    if (task.method == 0) {
+      result.incompressible = true;
+      result.inflated = {};
+      return;
+    }
+    level = 0;
+  }
+  if (level > 0) {
+    size_t size = 0;
+    result.deflated.reset(zip_deflate_mem(
+        result.inflated.data(), result.inflated.size(), level, &size));
+    if (!result.deflated) {
+      result.failed = true;
+      return;
+    }
+    if (size < result.inflated.size()) {
+      result.method = 8;
+      result.deflated_size = size;
+      result.inflated = {};
+      return;
+    }
+    result.deflated.reset();
+  }
+  result.method = 0;
+}
+
+long long dos_to_time(unsigned short dos_date, unsigned short dos_time) {
+  std::tm tm{};
+  tm.tm_year = ((dos_date >> 9) & 127) + 80;
+  tm.tm_mon = ((dos_date >> 5) & 15) - 1;
+  tm.tm_mday = dos_date & 31;
+  tm.tm_hour = (dos_time >> 11) & 31;
+  tm.tm_min = (dos_time >> 5) & 63;
+  tm.tm_sec = (dos_time << 1) & 62;
+  tm.tm_isdst = -1;
+  return static_cast<long long>(std::mktime(&tm));
+}
+
+int write_recompressed(zip_t *zip, const RecompressTask &task,
+                       const RecompressResult &result) {
+  int err = zip_entry_open(zip, task.name.c_str());
+  if (err < 0) {
+    return err;
+  }
+  if (const auto mode = task.external_attr >> 16; mode != 0) {
+    zip_entry_set_unix_permissions(zip, mode, 0);
+  }
+  if ((err = zip_entry_set_mtime(zip, dos_to_time(task.dos_date,
+                                                  task.dos_time))) == 0) {
+    err = result.method == 8
+              ? zip_entry_rawwrite(zip, result.deflated.get(),
+                                   result.deflated_size, 8, task.uncomp_size,
+                                   task.crc32)
+              : zip_entry_rawwrite(zip, result.inflated.data(),
+                                   result.inflated.size(), 0,
+                                   task.uncomp_size, task.crc32);
+  }
+  const int close_err = zip_entry_close(zip);
+  return err < 0 ? err : close_err;
+}
+
+// 多线程解压再以 level 重新压缩, 已经是目标压缩方式的 entry 原样拷贝,
+// 输出保持原来的 entry 顺序; 同时在内存中的结果最多 jobs * 4 个,
+// 按中央目录大小合计不超过 jobs * 64 MiB, 更大的 entry 轮到写出时才解压
+export int recompress(const fs::path &zip_path, const fs::path &output,
+                      int level, unsigned jobs, bool force,
+                      bool keep_deflated) {
+  std::error_code ec;
+  if (fs::equivalent(zip_path, output, ec)) {
+    std::println("output must not be the input archive");
+    return 1;
+  }
+  const std::unique_ptr<zip_t, ZipClose> zip{
+      zip_open(zip_path.string().c_str(), 0, 'r')};
+  if (!zip) {
+    std::println("zip open error");
+    return 1;
+  }
+  RecompressContext context{level, force, keep_deflated};
+  if (zip_entries_foreach(zip.get(), collect_recompress_task, &context) < 0) {
+    std::println("failed to read central directory");
+    return 1;
+  }
+  const auto &tasks = context.tasks;
+
+  jobs = worker_count(jobs, tasks.size());
+  int errnum = 0;
+  // cursor 必须在单个线程上创建, 之后各线程独立使用
+  const auto cursors = open_cursors(zip.get(), jobs, errnum);
+  if (cursors.empty()) {
+    std::println("zip cursor open error: {}", zip_strerror(errnum));
+    return 1;
+  }
+  std::unique_ptr<zip_t, ZipClose> out{
+      zip_openwitherror(output.string().c_str(), 0, 'w', &errnum)};
+  if (!out) {
+    std::println("zip open error: {}", zip_strerror(errnum));
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const size_t window = static_cast<size_t>(jobs) * 4;
+  const std::uint64_t memory = static_cast<std::uint64_t>(jobs) * (64 << 20);
+  // 原样拷贝的 entry 不占内存, 超过预算的 entry 独占全部预算
+  const auto cost = [&](size_t i) -> std::uint64_t {
+    return tasks[i].recompress ? std::min(tasks[i].uncomp_size, memory) : 0;
+  };
+  std::vector<RecompressResult> results(tasks.size());
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t written = 0;
+  std::uint64_t in_flight = 0;
+  bool stop = false;
+  size_t recompressed = 0;
+  size_t copied = 0;
+  size_t incompressible = 0;
+  int result = 0;
+  {
+    // 工作线程在后台压缩, 当前线程按原顺序写出
+    std::jthread pool([&] {
+      run_workers(jobs, tasks.size(), [&](unsigned worker, size_t i) {
+        {
+          // 下一个要写出的 entry 总能开始, 否则前面的结果永远写不出去
+          std::unique_lock lock{mutex};
+          cv.wait(lock, [&] {
+            return stop || i == written ||
+                   (i < written + window && in_flight + cost(i) <= memory);
+          });
+          if (stop) {
+            return;
+          }
+          in_flight += cost(i);
+        }
+        if (tasks[i].recompress) {
+          try {
+            recompress_entry(cursors[worker].get(), tasks[i], level,
+                             results[i]);
+          } catch (const std::bad_alloc &) {
+            results[i] = {};
+            results[i].failed = true;
+            results[i].out_of_memory = true;
+          }
+        }
+        {
+          std::lock_guard lock{mutex};
+          results[i].ready = true;
+        }
+        cv.notify_all();
+      });
+    });
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&] { return results[i].ready; });
+      }
+      const auto &task = tasks[i];
+      auto &entry = results[i];
+      int err = 0;
+      if (entry.out_of_memory) {
+        std::println("out of memory recompressing {}", task.name);
+        err = -1;
+      } else if (entry.failed) {
+        std::println("failed to inflate {}", task.name);
+        err = -1;
+      } else if (!task.recompress || entry.incompressible) {
+        err = zip_entry_rawcopy(out.get(), zip.get(), task.index);
+        if (task.recompress) {
+          ++incompressible;
+        } else {
+          ++copied;
+        }
+      } else {
+        err = write_recompressed(out.get(), task, entry);
+        ++recompressed;
+      }
+      if (err < 0) {
+        if (!entry.failed) {
+          std::println("failed to write {}: {}", task.name, zip_strerror(err));
+        }
+        result = 1;
+      }
+      entry = {};
+      {
+        std::lock_guard lock{mutex};
+        ++written;
+        in_flight -= cost(i);
+        stop = result != 0;
+      }
+      cv.notify_all();
+      if (result != 0) {
+        break;
+      }
+    }
+  }
+  // 先写完中央目录再删除或统计输出文件
+  out.reset();
+  if (result != 0) {
+    fs::remove(output, ec);
+    return result;
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::println("{} recompressed, {} copied, {} incompressible; {:.1f} MiB -> "
+               "{:.1f} MiB in {:.2f}s",
+               recompressed, copied, incompressible,
+               static_cast<double>(fs::file_size(zip_path, ec)) / (1 << 20),
+               static_cast<double>(fs::file_size(output, ec)) / (1 << 20),
+               elapsed.count());
+  return 0;
+}
+} // namespace Utils
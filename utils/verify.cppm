@@ -0,0 +1,139 @@
+module;
+#include "zip.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <print>
+#include <string>
+#include <vector>
+export module Utils.Verify;
+import Utils.Reader;
+import Utils.Workers;
+namespace fs = std::filesystem;
+
+namespace Utils {
+export template <typename Callback>
+concept VerifyProgressCallback =
+    std::invocable<Callback, std::uint64_t, std::uint64_t>;
+
+struct VerifyTask {
+  size_t index;
+  std::uint64_t header_offset;
+  std::uint64_t size;
+};
+
+struct VerifyFailure {
+  size_t index;
+  std::string name;
+  std::string reason;
+};
+
+struct VerifyContext {
+  std::vector<VerifyTask> tasks{};
+  std::uint64_t total_bytes{0};
+};
+
+int collect_verify_task(void *arg, const zip_entry_info_t *info) {
+  auto &context = *static_cast<VerifyContext *>(arg);
+  if (!info->isdir) {
+    context.tasks.push_back(
+        {info->index, info->header_offset, info->uncomp_size});
+    context.total_bytes += info->uncomp_size;
+  }
+  return 0;
+}
+
+struct DiscardContext {
+  std::atomic<std::uint64_t> *done;
+};
+
+size_t discard_chunk(void *arg, std::uint64_t, const void *, size_t size) {
+  static_cast<DiscardContext *>(arg)->done->fetch_add(
+      size, std::memory_order_relaxed);
+  return size;
+}
+
+// 解压全部 entry 到空输出, 由 cursor 在读到末尾时校验 CRC-32,
+// 最后打印吞吐量和按压缩包顺序排列的前 max_failures 个失败的 entry
+export template <VerifyProgressCallback Callback>
+int verify(const fs::path &zip_path, unsigned jobs, size_t max_failures,
+           Callback on_progress) {
+  const auto zip = zip_open(zip_path.string().c_str(), 0, 'r');
+  if (zip == nullptr) {
+    std::println("zip open error");
+    return 1;
+  }
+
+  VerifyContext context;
+  if (zip_entries_foreach(zip, collect_verify_task, &context) < 0) {
+    std::println("failed to read central directory");
+    zip_close(zip);
+    return 1;
+  }
+  auto &tasks = context.tasks;
+  const auto total_bytes = context.total_bytes;
+  std::vector<VerifyFailure> failures;
+  // 按数据在压缩包中的位置顺序读取
+  std::ranges::sort(tasks, {}, &VerifyTask::header_offset);
+
+  jobs = worker_count(jobs, tasks.size());
+  int errnum = 0;
+  auto cursors = open_cursors(zip, jobs, errnum);
+  if (cursors.empty()) {
+    std::println("zip cursor open error: {}", zip_strerror(errnum));
+    zip_close(zip);
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<std::uint64_t> done{0};
+  std::mutex failures_mutex;
+  run_workers(
+      jobs, tasks.size(),
+      [&](unsigned worker, size_t i) {
+        const auto cursor = cursors[worker].get();
+        const auto &task = tasks[i];
+        int err = zip_cursor_entry_openbyindex(cursor, task.index);
+        if (err == 0) {
+          DiscardContext discard{&done};
+          err = zip_cursor_entry_extract(cursor, discard_chunk, &discard);
+        }
+        if (err < 0) {
+          const char *name = zip_cursor_entry_name(cursor);
+          std::lock_guard lock{failures_mutex};
+          failures.push_back({task.index,
+                              name ? name : "#" + std::to_string(task.index),
+                              zip_strerror(err)});
+        }
+      },
+      [&] { on_progress(done.load(std::memory_order_relaxed), total_bytes); });
+  on_progress(done.load(), total_bytes);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::println("tested {} files, {:.1f} MiB in {:.2f}s ({:.1f} MiB/s), {} "
+               "errors",
+               tasks.size(), static_cast<double>(done.load()) / (1 << 20),
+               elapsed.count(),
+               elapsed.count() > 0
+                   ? static_cast<double>(done.load()) / (1 << 20) /
+                         elapsed.count()
+                   : 0.0,
+               failures.size());
+  std::ranges::sort(failures, {}, &VerifyFailure::index);
+  for (size_t i = 0; i < failures.size() && i < max_failures; ++i) {
+    std::println("  {}: {}", failures[i].name, failures[i].reason);
+  }
+  if (failures.size() > max_failures) {
+    std::println("  ... and {} more", failures.size() - max_failures);
+  }
+
+  cursors.clear();
+  zip_close(zip);
+  return failures.empty() ? 0 : 1;
+}
+} // namespace Utils
@@ -0,0 +1,67 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+export module Utils.Workers;
+
+namespace Utils {
+struct NoPoll {
+  void operator()() const noexcept {}
+};
+
+// 线程数不超过任务数, 至少 1 个
+export unsigned worker_count(unsigned jobs, size_t tasks) {
+  return std::clamp<unsigned>(
+      jobs, 1, static_cast<unsigned>(std::max<size_t>(tasks, 1)));
+}
+
+// jobs 个线程共同领取 [0, count) 中的序号并调用 work(worker, i),
+// worker 是线程序号, 用来取该线程自己的 cursor;
+// 调用线程等待期间每 100 ms 调用一次 on_poll.
+// work 抛出异常后不再分配新序号, 所有线程结束后重新抛出第一个异常
+export template <std::invocable<unsigned, size_t> Work,
+                 std::invocable<> Poll = NoPoll>
+void run_workers(unsigned jobs, size_t count, Work work, Poll on_poll = {}) {
+  std::atomic<size_t> next{0};
+  std::atomic<unsigned> running{jobs};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(jobs);
+    for (unsigned worker = 0; worker < jobs; ++worker) {
+      workers.emplace_back([&, worker] {
+        try {
+          for (size_t i; (i = next.fetch_add(1)) < count;) {
+            work(worker, i);
+          }
+        } catch (...) {
+          next = count;
+          std::lock_guard lock{error_mutex};
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+        --running;
+      });
+    }
+
+    if constexpr (!std::same_as<Poll, NoPoll>) {
+      using namespace std::chrono_literals;
+      while (running.load() > 0) {
+        on_poll();
+        std::this_thread::sleep_for(100ms);
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+} // namespace Utils
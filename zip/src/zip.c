@@ -8,6 +8,9 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 #define __STDC_WANT_LIB_EXT1__ 1
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // needed for fallocate()
+#endif
 
 #include <errno.h>
 #include <sys/stat.h>
@@ -17,6 +20,7 @@
     defined(__MINGW32__)
 /* Win32, DOS, MSVC, MSVS */
 #include <direct.h>
+#include <io.h>
 
 #define HAS_DEVICE(P)                                                          \
   ((((P)[0] >= 'A' && (P)[0] <= 'Z') || ((P)[0] >= 'a' && (P)[0] <= 'z')) &&   \
@@ -25,10 +29,18 @@
 
 #else
 
+#include <fcntl.h>
 #include <unistd.h> // needed for symlink()
 
 #endif
 
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef __MINGW32__
 #include <sys/types.h>
 #include <unistd.h>
@@ -90,15 +102,57 @@ struct zip_entry_t {
   mz_uint64 header_offset;
   mz_uint16 method;
   mz_zip_writer_add_state state;
-  tdefl_compressor comp;
+  // allocated by the first compressed entry, read-only handlers never need it
+  tdefl_compressor *comp;
   mz_uint32 external_attr;
   time_t m_time;
+  mz_bool raw;
+};
+
+struct zip_seek_point_t {
+  mz_uint64 out_ofs;
+  mz_uint64 comp_ofs;
+  mz_uint32 dict_ofs;
+  tinfl_decompressor inflator;
+  mz_uint8 dict[TINFL_LZ_DICT_SIZE];
+};
+
+struct zip_seek_index_t {
+  struct zip_seek_index_t *next;
+  mz_uint32 index;
+  mz_uint64 header_offset;
+  mz_uint64 comp_size;
+  mz_uint64 uncomp_size;
+  mz_uint32 uncomp_crc32;
+  mz_uint64 span;
+  size_t num_points;
+  size_t capacity;
+  struct zip_seek_point_t *points;
+};
+
+struct zip_name_index_t {
+  mz_uint32 mask;
+  mz_uint32 *slots;  // entry index + 1, 0 marks an empty slot
+  mz_uint32 *sorted; // entry indices ordered byte-wise by name
 };
 
 struct zip_t {
   mz_zip_archive archive;
   mz_uint level;
+  // data of stored entries starts on a multiple of it, 0 disables
+  mz_uint32 alignment;
   struct zip_entry_t entry;
+  struct zip_seek_index_t *seek_index;
+  struct zip_name_index_t name_index;
+  // 's' mode reads the central directory records from the file on demand and
+  // never holds them; archive.m_total_files stays 0 so that miniz sees no
+  // entries
+  mz_bool dir_streamed;
+  mz_uint32 dir_total_files;
+  mz_uint64 dir_size;
+  // scan window of zip_entries_foreach and zip_entries_prefix, allocated on
+  // first use
+  mz_uint8 *dir_window;
 };
 
 enum zip_modify_t {
@@ -111,10 +165,10 @@ struct zip_entry_mark_t {
   ssize_t file_index;
   enum zip_modify_t type;
   mz_uint64 m_local_header_ofs;
-  size_t lf_length;
+  mz_uint64 lf_length;
 };
 
-static const char *const zip_errlist[35] = {
+static const char *const zip_errlist[38] = {
     NULL,
     "not initialized\0",
     "invalid entry name\0",
@@ -150,11 +204,15 @@ static const char *const zip_errlist[35] = {
     "cannot initialize writer from reader\0",
     "invalid argument\0",
     "cannot initialize reader iterator\0",
+    "cannot inflate entry data\0",
+    "invalid index file\0",
+    "crc32 mismatch\0",
 };
 
 const char *zip_strerror(int errnum) {
   errnum = -errnum;
-  if (errnum <= 0 || errnum >= 33) {
+  if (errnum <= 0 ||
+      errnum >= (int)(sizeof(zip_errlist) / sizeof(zip_errlist[0]))) {
     return NULL;
   }
 
@@ -312,696 +370,2383 @@ static int zip_archive_truncate(mz_zip_archive *pzip) {
   return 0;
 }
 
-static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
-                               int (*on_extract)(const char *filename,
-                                                 void *arg),
-                               void *arg) {
-  int err = 0;
-  mz_uint i, n;
-  char path[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
-  char symlink_to[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
-  mz_zip_archive_file_stat info;
-  size_t dirlen = 0, filename_size = MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE;
-  mz_uint32 xattr = 0;
+struct zip_inflate_t {
+  mz_file_read_func read;
+  void *opaque;
+  mz_uint64 data_offset;
+  mz_uint64 comp_size;
+  mz_uint64 uncomp_size;
+  mz_uint64 read_ofs;
+  mz_uint64 out_ofs;
+  tinfl_status status;
+  mz_uint32 dict_ofs;
+  size_t in_ofs;
+  size_t in_avail;
+  tinfl_decompressor inflator;
+  mz_uint8 dict[TINFL_LZ_DICT_SIZE];
+  mz_uint8 in[MZ_ZIP_MAX_IO_BUF_SIZE];
+};
 
-  memset(path, 0, sizeof(path));
-  memset(symlink_to, 0, sizeof(symlink_to));
+struct zip_reader_t {
+  struct zip_inflate_t inflate;
+  mz_uint16 method;
+  mz_uint32 uncomp_crc32;
+  mz_uint32 crc32;
+  const mz_uint8 *pending;
+  size_t pending_size;
+  int err;
+};
 
-  dirlen = strlen(dir);
-  if (dirlen + 1 > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE) {
-    return ZIP_EINVENTNAME;
-  }
+struct zip_cursor_t {
+  struct zip_t *zip;
+  MZ_FILE *pFile;
+  mz_uint64 file_ofs;
+  const mz_uint8 *pMem;
+  mz_uint64 mem_size;
+  ssize_t index;
+  mz_zip_archive_file_stat stat;
+  struct zip_reader_t reader;
+  // scan window of lookups in 's' mode, allocated on first use
+  mz_uint8 *dir_window;
+};
 
-  memset((void *)&info, 0, sizeof(mz_zip_archive_file_stat));
+static const mz_uint8 *zip_central_dir_header(mz_zip_archive *pzip,
+                                              mz_uint index) {
+  if (!pzip->m_pState || index >= pzip->m_total_files) {
+    return NULL;
+  }
+  return &MZ_ZIP_ARRAY_ELEMENT(
+      &pzip->m_pState->m_central_dir, mz_uint8,
+      MZ_ZIP_ARRAY_ELEMENT(&pzip->m_pState->m_central_dir_offsets, mz_uint32,
+                           index));
+}
 
-#if defined(_MSC_VER)
-  strcpy_s(path, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE, dir);
-#else
-  strncpy(path, dir, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE);
-#endif
+static int zip_local_data_offset(mz_file_read_func read, void *opaque,
+                                 mz_uint64 archive_size,
+                                 mz_uint64 header_offset, mz_uint64 comp_size,
+                                 mz_uint64 *data_offset) {
+  mz_uint8 header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
 
-  if (!ISSLASH(path[dirlen - 1])) {
-#if defined(_WIN32) || defined(__WIN32__)
-    path[dirlen] = '\\';
-#else
-    path[dirlen] = '/';
-#endif
-    ++dirlen;
+  if (read(opaque, header_offset, header, sizeof(header)) != sizeof(header)) {
+    return ZIP_EFREAD;
+  }
+  if (MZ_READ_LE32(header) != MZ_ZIP_LOCAL_DIR_HEADER_SIG) {
+    // local header signature mismatch
+    return ZIP_ENOHDR;
   }
 
-  if (filename_size > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen) {
-    filename_size = MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen;
+  *data_offset = header_offset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE +
+                 MZ_READ_LE16(header + MZ_ZIP_LDH_FILENAME_LEN_OFS) +
+                 MZ_READ_LE16(header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
+  if (*data_offset + comp_size > archive_size) {
+    // entry data runs past the end of the archive
+    return ZIP_ENOHDR;
   }
-  // Get and print information about each file in the archive.
-  n = mz_zip_reader_get_num_files(zip_archive);
-  for (i = 0; i < n; ++i) {
-    if (!mz_zip_reader_file_stat(zip_archive, i, &info)) {
-      // Cannot get information about zip archive;
-      err = ZIP_ENOENT;
-      goto out;
-    }
+  return 0;
+}
 
-    if (!zip_name_normalize(info.m_filename, info.m_filename,
-                            strlen(info.m_filename))) {
-      // Cannot normalize file name;
-      err = ZIP_EINVENTNAME;
-      goto out;
-    }
+static void zip_inflate_init(struct zip_inflate_t *inf, mz_file_read_func read,
+                             void *opaque, mz_uint64 data_offset,
+                             mz_uint64 comp_size, mz_uint64 uncomp_size) {
+  inf->read = read;
+  inf->opaque = opaque;
+  inf->data_offset = data_offset;
+  inf->comp_size = comp_size;
+  inf->uncomp_size = uncomp_size;
+  inf->read_ofs = 0;
+  inf->out_ofs = 0;
+  inf->status = TINFL_STATUS_NEEDS_MORE_INPUT;
+  inf->dict_ofs = 0;
+  inf->in_ofs = 0;
+  inf->in_avail = 0;
+  tinfl_init(&inf->inflator);
+}
 
-#if defined(_MSC_VER)
-    strncpy_s(&path[dirlen], filename_size, info.m_filename, filename_size);
-#else
-    strncpy(&path[dirlen], info.m_filename, filename_size);
-#endif
-    err = zip_mkpath(path);
-    if (err < 0) {
-      // Cannot make a path
-      goto out;
-    }
+static void zip_inflate_save(const struct zip_inflate_t *inf,
+                             struct zip_seek_point_t *point) {
+  point->out_ofs = inf->out_ofs;
+  // bytes sitting in the input buffer have not been consumed yet
+  point->comp_ofs = inf->read_ofs - inf->in_avail;
+  point->dict_ofs = inf->dict_ofs;
+  memcpy(&point->inflator, &inf->inflator, sizeof(tinfl_decompressor));
+  memcpy(point->dict, inf->dict, TINFL_LZ_DICT_SIZE);
+}
 
-    if ((((info.m_version_made_by >> 8) == 3) ||
-         ((info.m_version_made_by >> 8) ==
-          19)) // if zip is produced on Unix or macOS (3 and 19 from
-               // section 4.4.2.2 of zip standard)
-        && info.m_external_attr &
-               (0x20 << 24)) { // and has sym link attribute (0x80 is file,
-                               // 0x40 is directory)
-#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
-    defined(__MINGW32__)
-#else
-      if (info.m_uncomp_size > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE ||
-          !mz_zip_reader_extract_to_mem_no_alloc(
-              zip_archive, i, symlink_to, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE, 0,
-              NULL, 0)) {
-        err = ZIP_EMEMNOALLOC;
-        goto out;
-      }
-      symlink_to[info.m_uncomp_size] = '\0';
-      if (symlink(symlink_to, path) != 0) {
-        err = ZIP_ESYMLINK;
-        goto out;
-      }
-#endif
-    } else {
-      if (!mz_zip_reader_is_file_a_directory(zip_archive, i)) {
-        if (!mz_zip_reader_extract_to_file(zip_archive, i, path, 0)) {
-          // Cannot extract zip archive to file
-          err = ZIP_ENOFILE;
-          goto out;
-        }
-      }
+static void zip_inflate_restore(struct zip_inflate_t *inf,
+                                const struct zip_seek_point_t *point) {
+  inf->out_ofs = point->out_ofs;
+  inf->read_ofs = point->comp_ofs;
+  inf->dict_ofs = point->dict_ofs;
+  inf->in_ofs = 0;
+  inf->in_avail = 0;
+  inf->status = TINFL_STATUS_NEEDS_MORE_INPUT;
+  memcpy(&inf->inflator, &point->inflator, sizeof(tinfl_decompressor));
+  memcpy(inf->dict, point->dict, TINFL_LZ_DICT_SIZE);
+}
 
-#if defined(_MSC_VER) || defined(PS4)
-      (void)xattr; // unused
-#else
-      xattr = (info.m_external_attr >> 16) & 0xFFFF;
-      if (xattr > 0 && xattr <= MZ_UINT16_MAX) {
-        if (CHMOD(path, (mode_t)xattr) < 0) {
-          err = ZIP_ENOPERM;
-          goto out;
-        }
-      }
-#endif
+/*
+ * Inflates the next piece of the entry. On success *out points into the
+ * dictionary window and the number of bytes produced is returned, 0 once the
+ * whole entry has been inflated.
+ */
+static ssize_t zip_inflate_next(struct zip_inflate_t *inf,
+                                const mz_uint8 **out) {
+  size_t in_size, out_size;
+  mz_uint8 *cur;
+
+  for (;;) {
+    if (inf->status < TINFL_STATUS_DONE) {
+      return ZIP_EINFLATE;
+    }
+    if (inf->status == TINFL_STATUS_DONE || !inf->comp_size) {
+      return (inf->out_ofs == inf->uncomp_size) ? 0 : ZIP_EINFLATE;
     }
 
-    if (on_extract) {
-      if (on_extract(path, arg) < 0) {
-        goto out;
+    if (!inf->in_avail && inf->read_ofs < inf->comp_size) {
+      size_t n = (size_t)MZ_MIN((mz_uint64)sizeof(inf->in),
+                                inf->comp_size - inf->read_ofs);
+      if (inf->read(inf->opaque, inf->data_offset + inf->read_ofs, inf->in,
+                    n) != n) {
+        inf->status = TINFL_STATUS_FAILED;
+        return ZIP_EFREAD;
       }
+      inf->read_ofs += n;
+      inf->in_ofs = 0;
+      inf->in_avail = n;
     }
-  }
 
-out:
-  // Close the archive, freeing any resources it was using
-  if (!mz_zip_reader_end(zip_archive)) {
-    // Cannot end zip reader
-    err = ZIP_ECLSZIP;
+    in_size = inf->in_avail;
+    out_size = TINFL_LZ_DICT_SIZE - inf->dict_ofs;
+    cur = inf->dict + inf->dict_ofs;
+    inf->status = tinfl_decompress(
+        &inf->inflator, inf->in + inf->in_ofs, &in_size, inf->dict, cur,
+        &out_size,
+        (inf->read_ofs < inf->comp_size) ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+    inf->in_ofs += in_size;
+    inf->in_avail -= in_size;
+    inf->dict_ofs =
+        (mz_uint32)((inf->dict_ofs + out_size) & (TINFL_LZ_DICT_SIZE - 1));
+    inf->out_ofs += out_size;
+
+    if (inf->status < TINFL_STATUS_DONE || inf->out_ofs > inf->uncomp_size) {
+      inf->status = TINFL_STATUS_FAILED;
+      return ZIP_EINFLATE;
+    }
+    if (out_size) {
+      *out = cur;
+      return (ssize_t)out_size;
+    }
   }
-  return err;
 }
 
-static inline void zip_archive_finalize(mz_zip_archive *pzip) {
-  mz_zip_writer_finalize_archive(pzip);
-  zip_archive_truncate(pzip);
+static void zip_seek_index_free(struct zip_seek_index_t *seek_index) {
+  while (seek_index) {
+    struct zip_seek_index_t *next = seek_index->next;
+    CLEANUP(seek_index->points);
+    CLEANUP(seek_index);
+    seek_index = next;
+  }
 }
 
-static ssize_t zip_entry_mark(struct zip_t *zip,
-                              struct zip_entry_mark_t *entry_mark,
-                              const size_t n, char *const entries[],
-                              const size_t len) {
-  size_t i = 0;
-  ssize_t err = 0;
-  if (!zip || !entry_mark || !entries) {
-    return ZIP_ENOINIT;
+static struct zip_seek_index_t *
+zip_seek_index_find(struct zip_seek_index_t *seek_index, mz_uint32 index) {
+  for (; seek_index; seek_index = seek_index->next) {
+    if (seek_index->index == index) {
+      return seek_index;
+    }
   }
+  return NULL;
+}
 
-  mz_zip_archive_file_stat file_stat;
-  mz_uint64 d_pos = UINT64_MAX;
-  for (i = 0; i < n; ++i) {
-    if ((err = zip_entry_openbyindex(zip, i))) {
-      return (ssize_t)err;
+static void zip_seek_index_insert(struct zip_t *zip,
+                                  struct zip_seek_index_t *seek_index) {
+  struct zip_seek_index_t **it = &zip->seek_index;
+  while (*it) {
+    if ((*it)->index == seek_index->index) {
+      struct zip_seek_index_t *stale = *it;
+      *it = stale->next;
+      stale->next = NULL;
+      zip_seek_index_free(stale);
+      continue;
     }
+    it = &(*it)->next;
+  }
+  seek_index->next = zip->seek_index;
+  zip->seek_index = seek_index;
+}
 
-    mz_bool name_matches = MZ_FALSE;
-    {
-      size_t j;
-      for (j = 0; j < len; ++j) {
-        if (strcmp(zip->entry.name, entries[j]) == 0) {
-          name_matches = MZ_TRUE;
-          break;
-        }
-      }
-    }
-    if (name_matches) {
-      entry_mark[i].type = MZ_DELETE;
+static const struct zip_seek_point_t *
+zip_seek_index_lookup(const struct zip_seek_index_t *seek_index,
+                      mz_uint64 offset) {
+  size_t lo = 0, hi;
+  if (!seek_index || !seek_index->num_points) {
+    return NULL;
+  }
+  // last checkpoint at or before offset
+  hi = seek_index->num_points;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (seek_index->points[mid].out_ofs <= offset) {
+      lo = mid + 1;
     } else {
-      entry_mark[i].type = MZ_KEEP;
-    }
-
-    if (!mz_zip_reader_file_stat(&zip->archive, (mz_uint)i, &file_stat)) {
-      return ZIP_ENOENT;
-    }
-
-    zip_entry_close(zip);
-
-    entry_mark[i].m_local_header_ofs = file_stat.m_local_header_ofs;
-    entry_mark[i].file_index = (ssize_t)-1;
-    entry_mark[i].lf_length = 0;
-    if ((entry_mark[i].type) == MZ_DELETE &&
-        (d_pos > entry_mark[i].m_local_header_ofs)) {
-      d_pos = entry_mark[i].m_local_header_ofs;
+      hi = mid;
     }
   }
+  return lo ? &seek_index->points[lo - 1] : NULL;
+}
 
-  for (i = 0; i < n; ++i) {
-    if ((entry_mark[i].m_local_header_ofs > d_pos) &&
-        (entry_mark[i].type != MZ_DELETE)) {
-      entry_mark[i].type = MZ_MOVE;
+static int zip_seek_index_push(struct zip_seek_index_t *seek_index,
+                               const struct zip_inflate_t *inf) {
+  if (seek_index->num_points == seek_index->capacity) {
+    size_t capacity = seek_index->capacity ? seek_index->capacity * 2 : 16;
+    struct zip_seek_point_t *points = (struct zip_seek_point_t *)realloc(
+        seek_index->points, capacity * sizeof(struct zip_seek_point_t));
+    if (!points) {
+      return ZIP_EOOMEM;
     }
+    seek_index->points = points;
+    seek_index->capacity = capacity;
   }
-  return err;
+  zip_inflate_save(inf, &seek_index->points[seek_index->num_points++]);
+  return 0;
 }
 
-static ssize_t zip_entry_markbyindex(struct zip_t *zip,
-                                     struct zip_entry_mark_t *entry_mark,
-                                     const size_t n, size_t entries[],
-                                     const size_t len) {
-  size_t i = 0;
-  ssize_t err = 0;
-  if (!zip || !entry_mark || !entries) {
-    return ZIP_ENOINIT;
+static int zip_seek_index_matches(mz_zip_archive *pzip,
+                                  const struct zip_seek_index_t *seek_index) {
+  mz_zip_archive_file_stat stats;
+  if (!mz_zip_reader_file_stat(pzip, seek_index->index, &stats)) {
+    return 0;
   }
+  return stats.m_local_header_ofs == seek_index->header_offset &&
+         stats.m_comp_size == seek_index->comp_size &&
+         stats.m_uncomp_size == seek_index->uncomp_size &&
+         stats.m_crc32 == seek_index->uncomp_crc32 &&
+         stats.m_method == MZ_DEFLATED;
+}
 
-  mz_zip_archive_file_stat file_stat;
-  mz_uint64 d_pos = UINT64_MAX;
-  for (i = 0; i < n; ++i) {
-    if ((err = zip_entry_openbyindex(zip, i))) {
-      return (ssize_t)err;
-    }
+static mz_uint32 zip_name_hash(const char *name, size_t len) {
+  // FNV-1a over the lower-cased name, case-insensitive lookups share the
+  // bucket with case-sensitive ones
+  mz_uint32 hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < len; ++i) {
+    hash ^= (mz_uint8)MZ_TOLOWER(name[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
 
-    mz_bool matches = MZ_FALSE;
-    {
-      size_t j;
-      for (j = 0; j < len; ++j) {
-        if (i == entries[j]) {
-          matches = MZ_TRUE;
-          break;
-        }
-      }
-    }
-    if (matches) {
-      entry_mark[i].type = MZ_DELETE;
-    } else {
-      entry_mark[i].type = MZ_KEEP;
-    }
+static void zip_name_index_free(struct zip_name_index_t *name_index) {
+  CLEANUP(name_index->slots);
+  CLEANUP(name_index->sorted);
+  name_index->mask = 0;
+}
 
-    if (!mz_zip_reader_file_stat(&zip->archive, (mz_uint)i, &file_stat)) {
-      return ZIP_ENOENT;
-    }
+static mz_uint64 zip_name_index_capacity(mz_uint32 total_files) {
+  mz_uint64 capacity = 16;
+  while (capacity < 2 * (mz_uint64)total_files) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
 
-    zip_entry_close(zip);
+static int zip_name_index_build(mz_zip_archive *pzip,
+                                struct zip_name_index_t *name_index) {
+  mz_uint64 capacity = zip_name_index_capacity(pzip->m_total_files);
+  mz_uint32 i, slot;
 
-    entry_mark[i].m_local_header_ofs = file_stat.m_local_header_ofs;
-    entry_mark[i].file_index = (ssize_t)-1;
-    entry_mark[i].lf_length = 0;
-    if ((entry_mark[i].type) == MZ_DELETE &&
-        (d_pos > entry_mark[i].m_local_header_ofs)) {
-      d_pos = entry_mark[i].m_local_header_ofs;
-    }
+  if (capacity > MZ_UINT32_MAX) {
+    return ZIP_EOOMEM;
   }
 
-  for (i = 0; i < n; ++i) {
-    if ((entry_mark[i].m_local_header_ofs > d_pos) &&
-        (entry_mark[i].type != MZ_DELETE)) {
-      entry_mark[i].type = MZ_MOVE;
-    }
+  name_index->slots = (mz_uint32 *)calloc((size_t)capacity, sizeof(mz_uint32));
+  if (!name_index->slots) {
+    return ZIP_EOOMEM;
   }
-  return err;
-}
-static ssize_t zip_index_next(mz_uint64 *local_header_ofs_array,
-                              ssize_t cur_index) {
-  ssize_t new_index = 0, i;
-  for (i = cur_index - 1; i >= 0; --i) {
-    if (local_header_ofs_array[cur_index] > local_header_ofs_array[i]) {
-      new_index = i + 1;
-      return new_index;
+  name_index->mask = (mz_uint32)(capacity - 1);
+
+  for (i = 0; i < pzip->m_total_files; ++i) {
+    const mz_uint8 *pHeader = zip_central_dir_header(pzip, i);
+    slot = zip_name_hash((const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+                         MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS)) &
+           name_index->mask;
+    // linear probing keeps duplicates in central directory order
+    while (name_index->slots[slot]) {
+      slot = (slot + 1) & name_index->mask;
     }
+    name_index->slots[slot] = i + 1;
   }
-  return new_index;
+  return 0;
 }
 
-static ssize_t zip_sort(mz_uint64 *local_header_ofs_array, ssize_t cur_index) {
-  ssize_t nxt_index = zip_index_next(local_header_ofs_array, cur_index);
-
-  if (nxt_index != cur_index) {
-    mz_uint64 temp = local_header_ofs_array[cur_index];
-    ssize_t i;
-    for (i = cur_index; i > nxt_index; i--) {
-      local_header_ofs_array[i] = local_header_ofs_array[i - 1];
+static ssize_t zip_name_index_find(mz_zip_archive *pzip,
+                                   const struct zip_name_index_t *name_index,
+                                   const char *name, size_t len,
+                                   mz_uint flags) {
+  mz_uint32 slot = zip_name_hash(name, len) & name_index->mask;
+
+  while (name_index->slots[slot]) {
+    mz_uint32 index = name_index->slots[slot] - 1;
+    const mz_uint8 *pHeader = zip_central_dir_header(pzip, index);
+    if (MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS) == len &&
+        mz_zip_string_equal(
+            name, (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+            (mz_uint)len, flags)) {
+      return (ssize_t)index;
     }
-    local_header_ofs_array[nxt_index] = temp;
+    slot = (slot + 1) & name_index->mask;
   }
-  return nxt_index;
+  return -1;
 }
 
-static int zip_index_update(struct zip_entry_mark_t *entry_mark,
-                            ssize_t last_index, ssize_t nxt_index) {
-  ssize_t j;
-  for (j = 0; j < last_index; j++) {
-    if (entry_mark[j].file_index >= nxt_index) {
-      entry_mark[j].file_index += 1;
+// Decodes a whole central directory record, its variable fields included.
+static int zip_central_dir_record_info(const mz_uint8 *pHeader,
+                                       mz_uint32 index,
+                                       struct zip_entry_info_t *info) {
+  const mz_uint8 *pExtra = NULL, *pField = NULL;
+  mz_uint32 extra_len, field_id, field_len;
+
+  info->index = index;
+  info->name = (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
+  info->namelen = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  info->method = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_METHOD_OFS);
+  info->crc32 = MZ_READ_LE32(pHeader + MZ_ZIP_CDH_CRC32_OFS);
+  info->comp_size = MZ_READ_LE32(pHeader + MZ_ZIP_CDH_COMPRESSED_SIZE_OFS);
+  info->uncomp_size = MZ_READ_LE32(pHeader + MZ_ZIP_CDH_DECOMPRESSED_SIZE_OFS);
+  info->header_offset = MZ_READ_LE32(pHeader + MZ_ZIP_CDH_LOCAL_HEADER_OFS);
+  info->external_attr = MZ_READ_LE32(pHeader + MZ_ZIP_CDH_EXTERNAL_ATTR_OFS);
+  info->dos_date = (unsigned short)MZ_READ_LE16(pHeader +
+                                                MZ_ZIP_CDH_FILE_DATE_OFS);
+  info->dos_time = (unsigned short)MZ_READ_LE16(pHeader +
+                                                MZ_ZIP_CDH_FILE_TIME_OFS);
+  info->bit_flag =
+      (unsigned short)MZ_READ_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS);
+  // same rule as mz_zip_reader_is_file_a_directory
+  info->isdir =
+      (info->namelen && info->name[info->namelen - 1] == '/') ||
+      (info->external_attr & MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG) != 0;
+
+  if (info->comp_size != MZ_UINT32_MAX && info->uncomp_size != MZ_UINT32_MAX &&
+      info->header_offset != MZ_UINT32_MAX) {
+    return 0;
+  }
+  // the real values live in the zip64 extended information field, in the
+  // order of the saturated 32-bit fields
+  extra_len = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_EXTRA_LEN_OFS);
+  pExtra = pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE + info->namelen;
+  while (extra_len >= 4) {
+    field_id = MZ_READ_LE16(pExtra);
+    field_len = MZ_READ_LE16(pExtra + 2);
+    if (field_len + 4 > extra_len) {
+      return ZIP_ENOHDR;
+    }
+    if (field_id == MZ_ZIP64_EXTENDED_INFORMATION_FIELD_HEADER_ID) {
+      pField = pExtra + 4;
+      if (info->uncomp_size == MZ_UINT32_MAX && field_len >= 8) {
+        info->uncomp_size = MZ_READ_LE64(pField);
+        pField += 8;
+        field_len -= 8;
+      }
+      if (info->comp_size == MZ_UINT32_MAX && field_len >= 8) {
+        info->comp_size = MZ_READ_LE64(pField);
+        pField += 8;
+        field_len -= 8;
+      }
+      if (info->header_offset == MZ_UINT32_MAX && field_len >= 8) {
+        info->header_offset = MZ_READ_LE64(pField);
+      }
+      break;
     }
+    pExtra += field_len + 4;
+    extra_len -= field_len + 4;
   }
-  entry_mark[nxt_index].file_index = last_index;
   return 0;
 }
 
-static int zip_entry_finalize(struct zip_t *zip,
-                              struct zip_entry_mark_t *entry_mark,
-                              const size_t n) {
-  size_t i = 0;
-  mz_uint64 *local_header_ofs_array = (mz_uint64 *)calloc(n, sizeof(mz_uint64));
-  if (!local_header_ofs_array) {
-    return ZIP_EOOMEM;
+static int zip_central_dir_info(mz_zip_archive *pzip, mz_uint32 index,
+                                struct zip_entry_info_t *info) {
+  const mz_uint8 *pHeader = zip_central_dir_header(pzip, index);
+  if (!pHeader) {
+    return ZIP_ENOHDR;
   }
+  return zip_central_dir_record_info(pHeader, index, info);
+}
 
-  for (i = 0; i < n; ++i) {
-    local_header_ofs_array[i] = entry_mark[i].m_local_header_ofs;
-    ssize_t index = zip_sort(local_header_ofs_array, i);
+static int zip_name_less(mz_zip_archive *pzip, mz_uint32 l_index,
+                         mz_uint32 r_index) {
+  const mz_uint8 *pL = zip_central_dir_header(pzip, l_index);
+  const mz_uint8 *pR = zip_central_dir_header(pzip, r_index);
+  mz_uint l_len = MZ_READ_LE16(pL + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  mz_uint r_len = MZ_READ_LE16(pR + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  int cmp = memcmp(pL + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+                   pR + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE, MZ_MIN(l_len, r_len));
+  if (cmp != 0) {
+    return cmp < 0;
+  }
+  // duplicate names keep their central directory order
+  return l_len != r_len ? l_len < r_len : l_index < r_index;
+}
 
-    if ((size_t)index != i) {
-      zip_index_update(entry_mark, i, index);
+static void zip_name_sift_down(mz_zip_archive *pzip, mz_uint32 *indices,
+                               size_t root, size_t end) {
+  size_t child;
+  while ((child = 2 * root + 1) < end) {
+    if (child + 1 < end &&
+        zip_name_less(pzip, indices[child], indices[child + 1])) {
+      ++child;
+    }
+    if (!zip_name_less(pzip, indices[root], indices[child])) {
+      break;
     }
-    entry_mark[i].file_index = index;
+    MZ_SWAP_UINT32(indices[root], indices[child]);
+    root = child;
   }
+}
 
-  size_t *length = (size_t *)calloc(n, sizeof(size_t));
-  if (!length) {
-    CLEANUP(local_header_ofs_array);
+static int zip_name_index_sort(mz_zip_archive *pzip,
+                               struct zip_name_index_t *name_index) {
+  size_t n = pzip->m_total_files, i;
+
+  // heap sort, the same choice miniz makes to avoid qsort without a context
+  name_index->sorted = (mz_uint32 *)malloc(MZ_MAX(n, 1) * sizeof(mz_uint32));
+  if (!name_index->sorted) {
     return ZIP_EOOMEM;
   }
-  for (i = 0; i < n - 1; i++) {
-    length[i] =
-        (size_t)(local_header_ofs_array[i + 1] - local_header_ofs_array[i]);
+  for (i = 0; i < n; ++i) {
+    name_index->sorted[i] = (mz_uint32)i;
   }
-  length[n - 1] =
-      (size_t)(zip->archive.m_archive_size - local_header_ofs_array[n - 1]);
-
-  for (i = 0; i < n; i++) {
-    entry_mark[i].lf_length = length[entry_mark[i].file_index];
+  for (i = n / 2; i-- > 0;) {
+    zip_name_sift_down(pzip, name_index->sorted, i, n);
+  }
+  for (i = n; i-- > 1;) {
+    MZ_SWAP_UINT32(name_index->sorted[0], name_index->sorted[i]);
+    zip_name_sift_down(pzip, name_index->sorted, 0, i);
   }
-
-  CLEANUP(length);
-  CLEANUP(local_header_ofs_array);
   return 0;
 }
 
-static ssize_t zip_entry_set(struct zip_t *zip,
-                             struct zip_entry_mark_t *entry_mark, size_t n,
-                             char *const entries[], const size_t len) {
-  ssize_t err = 0;
-
-  if ((err = zip_entry_mark(zip, entry_mark, n, entries, len)) < 0) {
-    return err;
-  }
-  if ((err = zip_entry_finalize(zip, entry_mark, n)) < 0) {
-    return err;
-  }
-  return 0;
+// memcmp of the first len bytes of the name against prefix, names shorter
+// than the prefix order before it
+static int zip_name_prefix_compare(mz_zip_archive *pzip, mz_uint32 index,
+                                   const char *prefix, size_t len) {
+  const mz_uint8 *pHeader = zip_central_dir_header(pzip, index);
+  size_t name_len = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  int cmp = memcmp(pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE, prefix,
+                   MZ_MIN(name_len, len));
+  if (cmp == 0 && name_len < len) {
+    return -1;
+  }
+  return cmp;
 }
 
-static ssize_t zip_entry_setbyindex(struct zip_t *zip,
-                                    struct zip_entry_mark_t *entry_mark,
-                                    size_t n, size_t entries[],
-                                    const size_t len) {
-  ssize_t err = 0;
-
-  if ((err = zip_entry_markbyindex(zip, entry_mark, n, entries, len)) < 0) {
-    return err;
+/*
+ * Reads at an absolute file offset without touching the shared file position.
+ */
+static size_t zip_pread(MZ_FILE *fp, mz_uint64 offset, void *buf, size_t n) {
+  mz_uint8 *p = (mz_uint8 *)buf;
+  size_t total = 0;
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+  HANDLE handle = (HANDLE)_get_osfhandle(fileno(fp));
+  while (total < n) {
+    OVERLAPPED overlapped;
+    DWORD got = 0;
+    DWORD chunk = (DWORD)MZ_MIN(n - total, (size_t)0x40000000);
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)(offset + total);
+    overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+    if (!ReadFile(handle, p + total, chunk, &got, &overlapped) || !got) {
+      break;
+    }
+    total += got;
   }
-  if ((err = zip_entry_finalize(zip, entry_mark, n)) < 0) {
-    return err;
+#else
+  int fd = fileno(fp);
+  while (total < n) {
+    ssize_t got = pread(fd, p + total, n - total, (off_t)(offset + total));
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      break;
+    }
+    total += (size_t)got;
   }
-  return 0;
+#endif
+  return total;
 }
 
-static ssize_t zip_mem_move(void *pBuf, size_t bufSize, const mz_uint64 to,
-                            const mz_uint64 from, const size_t length) {
-  uint8_t *dst = NULL, *src = NULL, *end = NULL;
-
-  if (!pBuf) {
-    return ZIP_EINVIDX;
-  }
-
-  end = (uint8_t *)pBuf + bufSize;
+// holds the largest possible record: 46 bytes plus three 16-bit lengths
+#define ZIP_DIR_STREAM_WINDOW (256 * 1024)
 
-  if (to > bufSize) {
-    return ZIP_EINVIDX;
-  }
+/*
+ * Visits the central directory records of an 's' mode archive in order,
+ * reading them through a fixed window instead of keeping the directory in
+ * memory. The window is allocated into *window on first use and owned by
+ * the caller, so repeated scans do not allocate. Uses positional reads only,
+ * so cursors on other threads may scan concurrently. Returns the number of
+ * visited records.
+ */
+static ssize_t zip_dir_stream_foreach(struct zip_t *zip, mz_uint8 **window,
+                                      int (*on_record)(void *arg,
+                                                       mz_uint32 index,
+                                                       const mz_uint8 *pHeader),
+                                      void *arg) {
+  mz_zip_internal_state *pState = zip->archive.m_pState;
+  mz_uint8 *buf = NULL;
+  const mz_uint8 *p = NULL;
+  mz_uint64 read_ofs = 0;
+  size_t len = 0, pos = 0, n, record_size;
+  mz_uint32 index = 0;
 
-  if (from > bufSize) {
-    return ZIP_EINVIDX;
+  if (!*window && !(*window = (mz_uint8 *)malloc(ZIP_DIR_STREAM_WINDOW))) {
+    return ZIP_EOOMEM;
   }
-
-  dst = (uint8_t *)pBuf + to;
-  src = (uint8_t *)pBuf + from;
-
-  if (((dst + length) > end) || ((src + length) > end)) {
-    return ZIP_EINVIDX;
+  buf = *window;
+  while (index < zip->dir_total_files) {
+    if (len - pos >= MZ_ZIP_CENTRAL_DIR_HEADER_SIZE) {
+      p = buf + pos;
+      if (MZ_READ_LE32(p) != MZ_ZIP_CENTRAL_DIR_HEADER_SIG) {
+        return ZIP_ENOHDR;
+      }
+      record_size = MZ_ZIP_CENTRAL_DIR_HEADER_SIZE +
+                    MZ_READ_LE16(p + MZ_ZIP_CDH_FILENAME_LEN_OFS) +
+                    MZ_READ_LE16(p + MZ_ZIP_CDH_EXTRA_LEN_OFS) +
+                    MZ_READ_LE16(p + MZ_ZIP_CDH_COMMENT_LEN_OFS);
+      if (len - pos >= record_size) {
+        pos += record_size;
+        if (on_record(arg, index++, p)) {
+          break;
+        }
+        continue;
+      }
+    }
+    if (read_ofs == zip->dir_size) {
+      // the last record runs past the end of the central directory
+      return ZIP_ENOHDR;
+    }
+    // keep the partial record and refill the rest of the window
+    memmove(buf, buf + pos, len - pos);
+    len -= pos;
+    pos = 0;
+    n = (size_t)MZ_MIN((mz_uint64)(ZIP_DIR_STREAM_WINDOW - len),
+                       zip->dir_size - read_ofs);
+    if (zip_pread(pState->m_pFile,
+                  pState->m_file_archive_start_ofs +
+                      zip->archive.m_central_directory_file_ofs + read_ofs,
+                  buf + len, n) != n) {
+      return ZIP_EFREAD;
+    }
+    read_ofs += n;
+    len += n;
   }
-
-  memmove(dst, src, length);
-  return length;
+  return (ssize_t)index;
 }
 
-static ssize_t zip_file_move(MZ_FILE *m_pFile, const mz_uint64 to,
-                             const mz_uint64 from, const size_t length,
-                             mz_uint8 *move_buf, const size_t capacity_size) {
-  if (length > capacity_size) {
-    return ZIP_ECAPSIZE;
-  }
-  if (MZ_FSEEK64(m_pFile, from, SEEK_SET)) {
-    return ZIP_EFSEEK;
-  }
-  if (fread(move_buf, 1, length, m_pFile) != length) {
-    return ZIP_EFREAD;
+// Locates the end of central directory records the same way miniz does, but
+// only keeps the location of the directory.
+static int zip_dir_stream_locate(struct zip_t *zip) {
+  mz_zip_archive *pzip = &(zip->archive);
+  mz_uint8 eocd[MZ_ZIP_END_OF_CENTRAL_DIR_HEADER_SIZE];
+  mz_uint8 locator[MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE];
+  mz_uint8 eocd64[MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE];
+  mz_uint64 total_files, entries_on_disk, cdir_ofs, archive_ofs, eocd64_ofs;
+  mz_int64 eocd_ofs = 0;
+
+  if (!mz_zip_reader_locate_header_sig(
+          pzip, MZ_ZIP_END_OF_CENTRAL_DIR_HEADER_SIG,
+          MZ_ZIP_END_OF_CENTRAL_DIR_HEADER_SIZE, &eocd_ofs) ||
+      pzip->m_pRead(pzip->m_pIO_opaque, (mz_uint64)eocd_ofs, eocd,
+                    sizeof(eocd)) != sizeof(eocd)) {
+    return ZIP_ENOHDR;
   }
-  if (MZ_FSEEK64(m_pFile, to, SEEK_SET)) {
-    return ZIP_EFSEEK;
+  total_files = MZ_READ_LE16(eocd + MZ_ZIP_ECDH_CDIR_TOTAL_ENTRIES_OFS);
+  entries_on_disk =
+      MZ_READ_LE16(eocd + MZ_ZIP_ECDH_CDIR_NUM_ENTRIES_ON_DISK_OFS);
+  zip->dir_size = MZ_READ_LE32(eocd + MZ_ZIP_ECDH_CDIR_SIZE_OFS);
+  cdir_ofs = MZ_READ_LE32(eocd + MZ_ZIP_ECDH_CDIR_OFS_OFS);
+
+  if ((mz_uint64)eocd_ofs >= MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE +
+                                 MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE &&
+      pzip->m_pRead(pzip->m_pIO_opaque,
+                    (mz_uint64)eocd_ofs -
+                        MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE,
+                    locator, sizeof(locator)) == sizeof(locator) &&
+      MZ_READ_LE32(locator + MZ_ZIP64_ECDL_SIG_OFS) ==
+          MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIG) {
+    pzip->m_pState->m_zip64 = MZ_TRUE;
+    eocd64_ofs = (mz_uint64)eocd_ofs -
+                 MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE -
+                 MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE;
+    if (!mz_zip_reader_eocd64_valid(pzip, eocd64_ofs, eocd64)) {
+      eocd64_ofs =
+          MZ_READ_LE64(locator + MZ_ZIP64_ECDL_REL_OFS_TO_ZIP64_ECDR_OFS);
+      if (eocd64_ofs > pzip->m_archive_size -
+                           MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE ||
+          !mz_zip_reader_eocd64_valid(pzip, eocd64_ofs, eocd64)) {
+        return ZIP_ENOHDR;
+      }
+    }
+    total_files =
+        MZ_READ_LE64(eocd64 + MZ_ZIP64_ECDH_CDIR_TOTAL_ENTRIES_OFS);
+    entries_on_disk =
+        MZ_READ_LE64(eocd64 + MZ_ZIP64_ECDH_CDIR_NUM_ENTRIES_ON_DISK_OFS);
+    zip->dir_size = MZ_READ_LE64(eocd64 + MZ_ZIP64_ECDH_CDIR_SIZE_OFS);
+    cdir_ofs = MZ_READ_LE64(eocd64 + MZ_ZIP64_ECDH_CDIR_OFS_OFS);
+  }
+
+  // unlike the in-memory directory, its size is not limited to 4 GiB
+  if (total_files > MZ_UINT32_MAX || total_files != entries_on_disk ||
+      zip->dir_size < total_files * MZ_ZIP_CENTRAL_DIR_HEADER_SIZE ||
+      cdir_ofs + zip->dir_size > (mz_uint64)eocd_ofs) {
+    return ZIP_ENOHDR;
   }
-  if (fwrite(move_buf, 1, length, m_pFile) != length) {
-    return ZIP_EFWRITE;
+  // data in front of the archive, e.g. a self-extractor stub
+  archive_ofs = (mz_uint64)eocd_ofs - (cdir_ofs + zip->dir_size);
+  if (pzip->m_pState->m_zip64) {
+    if (archive_ofs < MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE +
+                          MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE) {
+      return ZIP_ENOHDR;
+    }
+    archive_ofs -= MZ_ZIP64_END_OF_CENTRAL_DIR_HEADER_SIZE +
+                   MZ_ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE;
   }
-  return (ssize_t)length;
+  pzip->m_pState->m_file_archive_start_ofs = archive_ofs;
+  pzip->m_archive_size -= archive_ofs;
+  pzip->m_central_directory_file_ofs = cdir_ofs;
+  zip->dir_total_files = (mz_uint32)total_files;
+  return 0;
 }
 
-static ssize_t zip_files_move(struct zip_t *zip, mz_uint64 writen_num,
-                              mz_uint64 read_num, size_t length) {
-  ssize_t n = 0;
-  const size_t page_size = 1 << 12; // 4K
-  mz_zip_internal_state *pState = zip->archive.m_pState;
+static int zip_dir_stream_open(struct zip_t *zip, const char *zipname) {
+  mz_zip_archive *pzip = &(zip->archive);
+  MZ_FILE *pFile = NULL;
+  mz_int64 file_size;
+  int err;
 
-  mz_uint8 *move_buf = (mz_uint8 *)calloc(1, page_size);
-  if (!move_buf) {
-    return ZIP_EOOMEM;
+  if (!(pFile = MZ_FOPEN(zipname, "rb"))) {
+    return ZIP_EOPNFILE;
   }
+  if (MZ_FSEEK64(pFile, 0, SEEK_END) ||
+      (file_size = MZ_FTELL64(pFile)) < MZ_ZIP_END_OF_CENTRAL_DIR_HEADER_SIZE) {
+    MZ_FCLOSE(pFile);
+    return ZIP_ERINIT;
+  }
+  if (!mz_zip_reader_init_internal(
+          pzip, zip->level | MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY)) {
+    MZ_FCLOSE(pFile);
+    return ZIP_ERINIT;
+  }
+  pzip->m_zip_type = MZ_ZIP_TYPE_FILE;
+  pzip->m_pRead = mz_zip_file_read_func;
+  pzip->m_pIO_opaque = pzip;
+  pzip->m_archive_size = (mz_uint64)file_size;
+  pzip->m_pState->m_pFile = pFile;
+
+  if ((err = zip_dir_stream_locate(zip)) < 0) {
+    // closes the archive file as well
+    mz_zip_reader_end(pzip);
+    mz_zip_zero_struct(pzip);
+    return err;
+  }
+  zip->dir_streamed = MZ_TRUE;
+  return 0;
+}
 
-  ssize_t moved_length = 0;
-  ssize_t move_count = 0;
-  while ((mz_int64)length > 0) {
-    move_count = (length >= page_size) ? page_size : length;
-
-    if (pState->m_pFile) {
-      n = zip_file_move(pState->m_pFile, writen_num, read_num, move_count,
-                        move_buf, page_size);
-    } else if (pState->m_pMem) {
-      n = zip_mem_move(pState->m_pMem, pState->m_mem_size, writen_num, read_num,
-                       move_count);
-    } else {
-      CLEANUP(move_buf);
-      return ZIP_ENOFILE;
+static size_t zip_cursor_read_func(void *opaque, mz_uint64 file_ofs, void *pBuf,
+                                   size_t n) {
+  struct zip_cursor_t *cursor = (struct zip_cursor_t *)opaque;
+  if (cursor->pMem) {
+    if (file_ofs >= cursor->mem_size) {
+      return 0;
     }
+    n = (size_t)MZ_MIN((mz_uint64)n, cursor->mem_size - file_ofs);
+    memcpy(pBuf, cursor->pMem + file_ofs, n);
+    return n;
+  }
+  return zip_pread(cursor->pFile, cursor->file_ofs + file_ofs, pBuf, n);
+}
 
-    if (n < 0) {
-      moved_length = n;
-      goto cleanup;
-    }
+static int zip_reader_supported(mz_uint16 bit_flag, mz_uint16 method) {
+  return !(bit_flag & (MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_IS_ENCRYPTED |
+                       MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_USES_STRONG_ENCRYPTION |
+                       MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_COMPRESSED_PATCH_FLAG)) &&
+         (method == 0 || method == MZ_DEFLATED);
+}
 
-    if (n != move_count) {
-      goto cleanup;
-    }
+static void zip_reader_init(struct zip_reader_t *reader, mz_file_read_func read,
+                            void *opaque, mz_uint64 data_offset,
+                            mz_uint64 comp_size, mz_uint64 uncomp_size,
+                            mz_uint16 method, mz_uint32 uncomp_crc32) {
+  zip_inflate_init(&reader->inflate, read, opaque, data_offset, comp_size,
+                   uncomp_size);
+  reader->method = method;
+  reader->uncomp_crc32 = uncomp_crc32;
+  reader->crc32 = MZ_CRC32_INIT;
+  reader->pending = NULL;
+  reader->pending_size = 0;
+  reader->err = 0;
+}
 
-    writen_num += move_count;
-    read_num += move_count;
-    length -= move_count;
-    moved_length += move_count;
-  }
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+#else
+struct zip_dir_cache_t {
+  size_t depth;
+  // fds[k] is the directory made of the first k components of name
+  int fds[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE / 2 + 2];
+  size_t ends[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE / 2 + 2];
+  char name[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
+};
 
-cleanup:
-  CLEANUP(move_buf);
-  return moved_length;
+static int zip_dir_cache_init(struct zip_dir_cache_t *cache, const char *dir) {
+  cache->depth = 0;
+  cache->ends[0] = 0;
+  cache->fds[0] = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  return (cache->fds[0] < 0) ? ZIP_EMKDIR : 0;
 }
 
-static int zip_central_dir_move(mz_zip_internal_state *pState, int begin,
-                                int end, int entry_num) {
-  if (begin == entry_num) {
-    return 0;
+static void zip_dir_cache_pop(struct zip_dir_cache_t *cache, size_t depth) {
+  while (cache->depth > depth) {
+    close(cache->fds[cache->depth--]);
   }
+}
 
-  size_t l_size = 0;
-  size_t r_size = 0;
-  mz_uint32 d_size = 0;
-  mz_uint8 *next = NULL;
-  mz_uint8 *deleted = &MZ_ZIP_ARRAY_ELEMENT(
-      &pState->m_central_dir, mz_uint8,
-      MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, begin));
-  l_size = (size_t)(deleted - (mz_uint8 *)(pState->m_central_dir.m_p));
-  if (end == entry_num) {
-    r_size = 0;
-  } else {
-    next = &MZ_ZIP_ARRAY_ELEMENT(
-        &pState->m_central_dir, mz_uint8,
-        MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, end));
-    r_size = pState->m_central_dir.m_size -
-             (mz_uint32)(next - (mz_uint8 *)(pState->m_central_dir.m_p));
-    d_size = (mz_uint32)(next - deleted);
+static void zip_dir_cache_free(struct zip_dir_cache_t *cache) {
+  zip_dir_cache_pop(cache, 0);
+  if (cache->fds[0] >= 0) {
+    close(cache->fds[0]);
   }
+}
 
-  if (next && l_size == 0) {
-    memmove(pState->m_central_dir.m_p, next, r_size);
-    pState->m_central_dir.m_p = MZ_REALLOC(pState->m_central_dir.m_p, r_size);
-    {
-      int i;
-      for (i = end; i < entry_num; i++) {
-        MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, i) -=
-            d_size;
-      }
-    }
+// depth of the cached directories shared with dir[0, len)
+static size_t zip_dir_cache_match(const struct zip_dir_cache_t *cache,
+                                  const char *dir, size_t len) {
+  size_t k = cache->depth;
+  while (k > 0 && !(cache->ends[k] <= len &&
+                    (cache->ends[k] == len || dir[cache->ends[k]] == '/') &&
+                    !memcmp(cache->name, dir, cache->ends[k]))) {
+    --k;
   }
+  return k;
+}
 
-  if (next && l_size * r_size != 0) {
-    memmove(deleted, next, r_size);
-    {
-      int i;
-      for (i = end; i < entry_num; i++) {
-        MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, i) -=
-            d_size;
-      }
-    }
-  }
+/*
+ * Returns the fd of the directory dir[0, len) relative to the extraction root,
+ * creating what is missing. Directories shared with the previous call are
+ * reused without any syscall.
+ */
+static int zip_dir_cache_enter(struct zip_dir_cache_t *cache, const char *dir,
+                               size_t len) {
+  size_t k = zip_dir_cache_match(cache, dir, len), pos, end;
 
-  pState->m_central_dir.m_size = l_size + r_size;
-  return 0;
-}
+  zip_dir_cache_pop(cache, k);
 
-static int zip_central_dir_delete(mz_zip_internal_state *pState,
-                                  int *deleted_entry_index_array,
-                                  int entry_num) {
-  int i = 0;
-  int begin = 0;
-  int end = 0;
-  int d_num = 0;
-  while (i < entry_num) {
-    while ((i < entry_num) && (!deleted_entry_index_array[i])) {
-      i++;
+  for (pos = cache->ends[k]; pos < len; pos = end) {
+    int fd;
+    while (pos < len && dir[pos] == '/') {
+      cache->name[pos] = '/';
+      ++pos;
+    }
+    if (pos == len) {
+      break;
+    }
+    for (end = pos; end < len && dir[end] != '/'; ++end) {
+      cache->name[end] = dir[end];
     }
-    begin = i;
+    cache->name[end] = '\0';
 
-    while ((i < entry_num) && (deleted_entry_index_array[i])) {
-      i++;
+    if (mkdirat(cache->fds[cache->depth], &cache->name[pos], 0755) != 0 &&
+        errno != EEXIST) {
+      return ZIP_EMKDIR;
+    }
+    fd = openat(cache->fds[cache->depth], &cache->name[pos],
+                O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+      return ZIP_EMKDIR;
     }
-    end = i;
-    zip_central_dir_move(pState, begin, end, entry_num);
+    cache->fds[++cache->depth] = fd;
+    cache->ends[cache->depth] = end;
   }
+  return cache->fds[cache->depth];
+}
 
-  i = 0;
-  while (i < entry_num) {
-    while ((i < entry_num) && (!deleted_entry_index_array[i])) {
-      i++;
+static size_t zip_fd_write_func(void *opaque, mz_uint64 file_ofs,
+                                const void *pBuf, size_t n) {
+  int fd = *(int *)opaque;
+  const mz_uint8 *p = (const mz_uint8 *)pBuf;
+  size_t total = 0;
+  (void)file_ofs; // data arrives in order
+  while (total < n) {
+    ssize_t written = write(fd, p + total, n - total);
+    if (written < 0 && errno == EINTR) {
+      continue;
     }
-    begin = i;
-    if (begin == entry_num) {
+    if (written <= 0) {
       break;
     }
-    while ((i < entry_num) && (deleted_entry_index_array[i])) {
-      i++;
-    }
-    end = i;
-    int k = 0, j;
-    for (j = end; j < entry_num; j++) {
-      MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32,
-                           begin + k) =
-          (mz_uint32)MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets,
-                                          mz_uint32, j);
-      k++;
-    }
-    d_num += end - begin;
+    total += (size_t)written;
   }
-
-  pState->m_central_dir_offsets.m_size =
-      sizeof(mz_uint32) * (entry_num - d_num);
-  return 0;
+  return total;
 }
 
-static ssize_t zip_entries_delete_mark(struct zip_t *zip,
-                                       struct zip_entry_mark_t *entry_mark,
-                                       int entry_num) {
-  mz_uint64 writen_num = 0;
-  mz_uint64 read_num = 0;
-  size_t deleted_length = 0;
-  size_t move_length = 0;
-  int i = 0;
-  size_t deleted_entry_num = 0;
-  ssize_t n = 0;
+static int zip_entry_is_symlink(const mz_zip_archive_file_stat *info) {
+  // produced on Unix or macOS, see zip_archive_extract
+  return (((info->m_version_made_by >> 8) == 3) ||
+          ((info->m_version_made_by >> 8) == 19)) &&
+         (info->m_external_attr & (0x20 << 24));
+}
 
-  mz_bool *deleted_entry_flag_array =
-      (mz_bool *)calloc(entry_num, sizeof(mz_bool));
-  if (deleted_entry_flag_array == NULL) {
-    return ZIP_EOOMEM;
+// turns backslashes into '/' and returns the length of the directory part
+static size_t zip_entry_path_split(char *name, size_t *len) {
+  size_t dirlen = 0;
+  for (*len = 0; name[*len]; ++*len) {
+    if (name[*len] == '\\') {
+      name[*len] = '/';
+    }
+    if (name[*len] == '/') {
+      dirlen = *len;
+    }
   }
+  return dirlen;
+}
 
-  mz_zip_internal_state *pState = zip->archive.m_pState;
-  zip->archive.m_zip_mode = MZ_ZIP_MODE_WRITING;
+/*
+ * Extracts one entry relative to the cached directory fds: openat/mkdirat
+ * instead of path walks, a single fd for preallocation, data, permissions and
+ * times.
+ */
+static int zip_archive_extract_at(mz_zip_archive *zip_archive, mz_uint i,
+                                  const mz_zip_archive_file_stat *info,
+                                  struct zip_dir_cache_t *cache, char *name) {
+  char symlink_to[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
+  mz_uint32 xattr = (info->m_external_attr >> 16) & 0xFFFF;
+  size_t len = 0, dirlen = zip_entry_path_split(name, &len);
+  int dirfd, fd, err = 0;
 
-  if (pState->m_pFile) {
-    if (MZ_FSEEK64(pState->m_pFile, 0, SEEK_SET)) {
-      CLEANUP(deleted_entry_flag_array);
-      return ZIP_ENOENT;
+  if (mz_zip_reader_is_file_a_directory(zip_archive, i)) {
+    while (len > 0 && name[len - 1] == '/') {
+      --len;
     }
+    dirfd = zip_dir_cache_enter(cache, name, len);
+    if (dirfd < 0) {
+      return dirfd;
+    }
+    if (xattr > 0 && fchmod(dirfd, (mode_t)xattr) < 0) {
+      return ZIP_ENOPERM;
+    }
+    return 0;
   }
 
-  while (i < entry_num) {
-    while ((i < entry_num) && (entry_mark[i].type == MZ_KEEP)) {
-      writen_num += entry_mark[i].lf_length;
-      read_num = writen_num;
-      i++;
-    }
+  dirfd = zip_dir_cache_enter(cache, name, dirlen);
+  if (dirfd < 0) {
+    return dirfd;
+  }
+  if (dirlen || name[0] == '/') {
+    ++dirlen;
+  }
 
-    while ((i < entry_num) && (entry_mark[i].type == MZ_DELETE)) {
-      deleted_entry_flag_array[i] = MZ_TRUE;
-      read_num += entry_mark[i].lf_length;
-      deleted_length += entry_mark[i].lf_length;
-      i++;
-      deleted_entry_num++;
+  if (zip_entry_is_symlink(info)) {
+    if (info->m_uncomp_size > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE ||
+        !mz_zip_reader_extract_to_mem_no_alloc(zip_archive, i, symlink_to,
+                                               MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE,
+                                               0, NULL, 0)) {
+      return ZIP_EMEMNOALLOC;
     }
-
-    while ((i < entry_num) && (entry_mark[i].type == MZ_MOVE)) {
-      move_length += entry_mark[i].lf_length;
-      mz_uint8 *p = &MZ_ZIP_ARRAY_ELEMENT(
-          &pState->m_central_dir, mz_uint8,
-          MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, i));
-      if (!p) {
-        CLEANUP(deleted_entry_flag_array);
-        return ZIP_ENOENT;
-      }
-      mz_uint32 offset = MZ_READ_LE32(p + MZ_ZIP_CDH_LOCAL_HEADER_OFS);
-      offset -= (mz_uint32)deleted_length;
-      MZ_WRITE_LE32(p + MZ_ZIP_CDH_LOCAL_HEADER_OFS, offset);
-      i++;
+    symlink_to[info->m_uncomp_size] = '\0';
+    if (symlinkat(symlink_to, dirfd, &name[dirlen]) != 0) {
+      return ZIP_ESYMLINK;
     }
+    return 0;
+  }
 
-    n = zip_files_move(zip, writen_num, read_num, move_length);
-    if (n != (ssize_t)move_length) {
-      CLEANUP(deleted_entry_flag_array);
-      return n;
-    }
-    writen_num += move_length;
-    read_num += move_length;
+  fd = openat(dirfd, &name[dirlen], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              0666);
+  if (fd < 0) {
+    // Cannot extract zip archive to file
+    return ZIP_ENOFILE;
   }
 
-  zip->archive.m_archive_size -= (mz_uint64)deleted_length;
-  zip->archive.m_total_files =
-      (mz_uint32)entry_num - (mz_uint32)deleted_entry_num;
+#if defined(__linux__)
+  if (info->m_uncomp_size > 0) {
+    // best effort, not every filesystem supports it
+    (void)fallocate(fd, 0, 0, (off_t)info->m_uncomp_size);
+  }
+#endif
 
-  zip_central_dir_delete(pState, deleted_entry_flag_array, entry_num);
-  CLEANUP(deleted_entry_flag_array);
+  if (!mz_zip_reader_extract_to_callback(zip_archive, i, zip_fd_write_func,
+                                         &fd, 0)) {
+    err = ZIP_ENOFILE;
+  }
+  if (!err && xattr > 0 && fchmod(fd, (mode_t)xattr) < 0) {
+    err = ZIP_ENOPERM;
+  }
+#ifndef MINIZ_NO_TIME
+  if (!err) {
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = info->m_time;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    (void)futimens(fd, times);
+  }
+#endif
+  if (close(fd) != 0 && !err) {
+    err = ZIP_ENOFILE;
+  }
+  return err;
+}
+#endif
+
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+#define ZIP_URING_BATCH 64
+#define ZIP_URING_SMALL_FILE (32 * 1024)
+
+struct zip_uring_item_t {
+  int dirfd; // owned by the directory cache, kept open until the flush
+  int fd;
+  mz_uint32 xattr;
+  time_t m_time;
+  size_t size;
+  size_t base;
+  char path[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
+};
+
+struct zip_uring_t {
+  int fd;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_size, cq_ring_size, sqes_size;
+  size_t count;
+  int broken;
+  int res[ZIP_URING_BATCH];
+  struct zip_uring_item_t items[ZIP_URING_BATCH];
+  mz_uint8 data[ZIP_URING_BATCH][ZIP_URING_SMALL_FILE];
+};
 
-  return (ssize_t)deleted_entry_num;
+static void zip_uring_close(struct zip_uring_t *ring) {
+  if (!ring) {
+    return;
+  }
+  if (ring->sqes) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ring && ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  if (ring->sq_ring) {
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+  }
+  CLEANUP(ring);
 }
 
-struct zip_t *zip_open(const char *zipname, int level, char mode) {
-  int errnum = 0;
-  return zip_openwitherror(zipname, level, mode, &errnum);
+static int zip_uring_supported(int fd) {
+  static const int ops[] = {IORING_OP_OPENAT, IORING_OP_WRITE,
+                            IORING_OP_CLOSE};
+  struct io_uring_probe *probe = NULL;
+  size_t i;
+  int supported = 1;
+
+  probe = (struct io_uring_probe *)calloc(
+      1, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+  if (!probe) {
+    return 0;
+  }
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) <
+      0) {
+    supported = 0;
+  }
+  for (i = 0; supported && i < sizeof(ops) / sizeof(ops[0]); ++i) {
+    supported = ops[i] <= probe->last_op &&
+                (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+  }
+  CLEANUP(probe);
+  return supported;
 }
 
-struct zip_t *zip_openwitherror(const char *zipname, int level, char mode,
-                                int *errnum) {
-  struct zip_t *zip = NULL;
-  *errnum = 0;
+/*
+ * Sets up a ring for batched extraction. Returns NULL when the kernel does not
+ * support io_uring or the needed opcodes (or it is blocked), or when
+ * ZIP_NO_IO_URING is set in the environment; the caller then stays on the
+ * synchronous path.
+ */
+static struct zip_uring_t *zip_uring_open(void) {
+  struct io_uring_params params;
+  struct zip_uring_t *ring = NULL;
+  mz_uint8 *sq, *cq;
 
-  if (!zipname || strlen(zipname) < 1) {
-    // zip_t archive name is empty or NULL
-    *errnum = ZIP_EINVZIPNAME;
-    goto cleanup;
+  if (getenv("ZIP_NO_IO_URING")) {
+    // forces the synchronous path, e.g. to compare both in tests
+    return NULL;
   }
 
-  if (level < 0)
-    level = MZ_DEFAULT_LEVEL;
-  if ((level & 0xF) > MZ_UBER_COMPRESSION) {
-    // Wrong compression level
-    *errnum = ZIP_EINVLVL;
-    goto cleanup;
+  ring = (struct zip_uring_t *)calloc(1, sizeof(struct zip_uring_t));
+  if (!ring) {
+    return NULL;
   }
 
-  zip = (struct zip_t *)calloc((size_t)1, sizeof(struct zip_t));
-  if (!zip) {
-    // out of memory
-    *errnum = ZIP_EOOMEM;
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int)syscall(__NR_io_uring_setup, ZIP_URING_BATCH, &params);
+  if (ring->fd < 0 || !zip_uring_supported(ring->fd)) {
     goto cleanup;
   }
 
-  zip->level = (mz_uint)level;
-  zip->entry.index = -1;
-  switch (mode) {
-  case 'w':
-    // Create a new archive.
-    if (!mz_zip_writer_init_file_v2(&(zip->archive), zipname, 0,
-                                    MZ_ZIP_FLAG_WRITE_ZIP64)) {
-      // Cannot initialize zip_archive writer
-      *errnum = ZIP_EWINIT;
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->sq_ring_size = ring->cq_ring_size =
+        MZ_MAX(ring->sq_ring_size, ring->cq_ring_size);
+  }
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) {
+    ring->sq_ring = NULL;
+    goto cleanup;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring =
+        mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED) {
+      ring->cq_ring = NULL;
       goto cleanup;
     }
-    break;
+  }
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes =
+      (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring->fd,
+                                  IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    goto cleanup;
+  }
 
-  case 'r':
-    if (!mz_zip_reader_init_file_v2(
-            &(zip->archive), zipname,
-            zip->level | MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY, 0, 0)) {
-      // An archive file does not exist or cannot initialize
-      // zip_archive reader
-      *errnum = ZIP_ERINIT;
-      goto cleanup;
-    }
-    break;
+  sq = (mz_uint8 *)ring->sq_ring;
+  cq = (mz_uint8 *)ring->cq_ring;
+  ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  return ring;
 
-  case 'a':
-  case 'd': {
-    MZ_FILE *fp = MZ_FOPEN(zipname, "r+b");
-    if (!fp) {
-      *errnum = ZIP_EOPNFILE;
-      goto cleanup;
-    }
-    if (!mz_zip_reader_init_cfile(
+cleanup:
+  zip_uring_close(ring);
+  return NULL;
+}
+
+static struct io_uring_sqe *zip_uring_sqe(struct zip_uring_t *ring,
+                                          unsigned n) {
+  unsigned tail = *ring->sq_tail + n;
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ring->sq_array[index] = index;
+  return sqe;
+}
+
+// no completion was reaped for the sqe, the operation may still be running
+#define ZIP_URING_PENDING INT_MIN
+
+/*
+ * Submits the n prepared sqes and reaps all n completions, the result of each
+ * one lands in ring->res[user_data]. If the kernel stops taking sqes, the
+ * ones it never consumed are withdrawn with -ECANCELED and only the submitted
+ * ones are waited for. A ring that still has completions in flight when this
+ * fails is marked broken and must not be used again.
+ */
+static int zip_uring_run(struct zip_uring_t *ring, unsigned n) {
+  unsigned done = 0, i;
+  int err = 0;
+
+  for (i = 0; i < n; ++i) {
+    unsigned index = ring->sq_array[(*ring->sq_tail + i) & *ring->sq_mask];
+    ring->res[ring->sqes[index].user_data] = ZIP_URING_PENDING;
+  }
+  __atomic_store_n(ring->sq_tail, *ring->sq_tail + n, __ATOMIC_RELEASE);
+  while (done < n) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+      unsigned sq_head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+      unsigned pending = *ring->sq_tail - sq_head;
+      if (syscall(__NR_io_uring_enter, ring->fd, pending, n - done,
+                  IORING_ENTER_GETEVENTS, NULL, 0) >= 0 ||
+          errno == EINTR) {
+        continue;
+      }
+      if (err || !pending) {
+        // the submitted operations cannot be waited for
+        ring->broken = 1;
+        return ZIP_EFWRITE;
+      }
+      err = ZIP_EFWRITE;
+      for (i = sq_head; i != *ring->sq_tail; ++i) {
+        unsigned index = ring->sq_array[i & *ring->sq_mask];
+        ring->res[ring->sqes[index].user_data] = -ECANCELED;
+      }
+      __atomic_store_n(ring->sq_tail, sq_head, __ATOMIC_RELEASE);
+      n -= pending;
+      continue;
+    }
+    for (; head != tail; ++head, ++done) {
+      const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+      ring->res[cqe->user_data] = cqe->res;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  }
+  return err;
+}
+
+/*
+ * Creates, writes and closes the queued files with one io_uring_enter per
+ * stage for the whole batch. There is no fchmod or futimens opcode, those
+ * two stay synchronous between the write and close stages. item->fd stays
+ * set while the file is open, so a failing stage only closes what is still
+ * open.
+ */
+static int zip_uring_flush(struct zip_uring_t *ring,
+                           int (*on_extract)(const char *filename, void *arg),
+                           void *arg, int *aborted) {
+  unsigned i, n;
+  int err = 0;
+
+  for (i = 0; i < ring->count; ++i) {
+    struct io_uring_sqe *sqe = zip_uring_sqe(ring, i);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = ring->items[i].dirfd;
+    sqe->addr = (mz_uint64)(uintptr_t)&ring->items[i].path[ring->items[i].base];
+    sqe->len = 0666;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    sqe->user_data = i;
+  }
+  err = zip_uring_run(ring, (unsigned)ring->count);
+  for (i = 0; i < ring->count; ++i) {
+    // a pending open may still create a file, its fd is lost with the ring
+    ring->items[i].fd = ring->res[i] >= 0 ? ring->res[i] : -1;
+    if (ring->items[i].fd < 0 && !err) {
+      // Cannot extract zip archive to file
+      err = ZIP_ENOFILE;
+    }
+  }
+
+  for (i = 0, n = 0; !err && i < ring->count; ++i) {
+    if (ring->items[i].size) {
+      struct io_uring_sqe *sqe = zip_uring_sqe(ring, n++);
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = ring->items[i].fd;
+      sqe->addr = (mz_uint64)(uintptr_t)ring->data[i];
+      sqe->len = (mz_uint32)ring->items[i].size;
+      sqe->user_data = i;
+    }
+  }
+  if (!err && n) {
+    err = zip_uring_run(ring, n);
+    for (i = 0; !err && i < ring->count; ++i) {
+      if (ring->items[i].size &&
+          ring->res[i] != (int)ring->items[i].size) {
+        err = ZIP_ENOFILE;
+      }
+    }
+  }
+  if (ring->broken) {
+    // no close can go through the ring any more, a write still running keeps
+    // its own reference to the file
+    for (i = 0; i < ring->count; ++i) {
+      if (ring->items[i].fd >= 0) {
+        close(ring->items[i].fd);
+        ring->items[i].fd = -1;
+      }
+    }
+    ring->count = 0;
+    return err;
+  }
+
+  for (i = 0, n = 0; i < ring->count; ++i) {
+    struct zip_uring_item_t *item = &ring->items[i];
+    struct io_uring_sqe *sqe;
+    if (item->fd < 0) {
+      continue;
+    }
+    if (!err && item->xattr > 0 && fchmod(item->fd, (mode_t)item->xattr) < 0) {
+      err = ZIP_ENOPERM;
+    }
+#ifndef MINIZ_NO_TIME
+    if (!err) {
+      struct timespec times[2];
+      times[0].tv_sec = times[1].tv_sec = item->m_time;
+      times[0].tv_nsec = times[1].tv_nsec = 0;
+      (void)futimens(item->fd, times);
+    }
+#endif
+    sqe = zip_uring_sqe(ring, n++);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = item->fd;
+    sqe->user_data = i;
+  }
+  if (n && zip_uring_run(ring, n) < 0 && !err) {
+    err = ZIP_ENOFILE;
+  }
+  for (i = 0; i < ring->count; ++i) {
+    struct zip_uring_item_t *item = &ring->items[i];
+    if (item->fd < 0) {
+      continue;
+    }
+    // only closes the kernel never took are redone, a reaped close released
+    // the fd even when it failed
+    if (ring->res[i] == -ECANCELED) {
+      close(item->fd);
+    }
+    item->fd = -1;
+  }
+
+  for (i = 0; !err && !*aborted && on_extract && i < ring->count; ++i) {
+    if (on_extract(ring->items[i].path, arg) < 0) {
+      *aborted = 1;
+    }
+  }
+  ring->count = 0;
+  return err;
+}
+
+/*
+ * Queues small regular files inflated in memory, everything else is flushed
+ * first and extracted synchronously. on_extract runs for a queued file when
+ * its batch is flushed.
+ */
+static int zip_uring_extract(struct zip_uring_t *ring,
+                             mz_zip_archive *zip_archive, mz_uint i,
+                             const mz_zip_archive_file_stat *info,
+                             struct zip_dir_cache_t *cache, char *path,
+                             size_t pathlen,
+                             int (*on_extract)(const char *filename, void *arg),
+                             void *arg, int *aborted) {
+  char *name = &path[pathlen];
+  size_t len = 0, dirlen = zip_entry_path_split(name, &len), enter_len = dirlen;
+  int is_dir = mz_zip_reader_is_file_a_directory(zip_archive, i);
+  int queue = !is_dir && !zip_entry_is_symlink(info) && info->m_is_supported &&
+              info->m_uncomp_size <= ZIP_URING_SMALL_FILE;
+  struct zip_uring_item_t *item;
+  int dirfd, err = 0;
+
+  if (is_dir) {
+    for (enter_len = len; enter_len > 0 && name[enter_len - 1] == '/';
+         --enter_len) {
+    }
+  }
+  // the batch still refers to the directory fds the cache is about to close
+  if (ring->count &&
+      (!(is_dir || queue) ||
+       zip_dir_cache_match(cache, name, enter_len) < cache->depth)) {
+    err = zip_uring_flush(ring, on_extract, arg, aborted);
+    if (err < 0 || *aborted) {
+      return err;
+    }
+  }
+
+  if (!queue) {
+    err = zip_archive_extract_at(zip_archive, i, info, cache, name);
+    if (!err && on_extract && on_extract(path, arg) < 0) {
+      *aborted = 1;
+    }
+    return err;
+  }
+
+  dirfd = zip_dir_cache_enter(cache, name, dirlen);
+  if (dirfd < 0) {
+    return dirfd;
+  }
+
+  item = &ring->items[ring->count];
+  if (info->m_uncomp_size &&
+      !mz_zip_reader_extract_to_mem_no_alloc(zip_archive, i,
+                                             ring->data[ring->count],
+                                             ZIP_URING_SMALL_FILE, 0, NULL, 0)) {
+    // Cannot extract zip archive to file
+    return ZIP_ENOFILE;
+  }
+  item->dirfd = dirfd;
+  item->fd = -1;
+  item->xattr = (info->m_external_attr >> 16) & 0xFFFF;
+#ifndef MINIZ_NO_TIME
+  item->m_time = info->m_time;
+#endif
+  item->size = (size_t)info->m_uncomp_size;
+  item->base = pathlen + ((dirlen || name[0] == '/') ? dirlen + 1 : 0);
+  memcpy(item->path, path, pathlen + len + 1);
+
+  if (++ring->count == ZIP_URING_BATCH) {
+    return zip_uring_flush(ring, on_extract, arg, aborted);
+  }
+  return 0;
+}
+#endif
+
+static int zip_archive_extract(mz_zip_archive *zip_archive, const char *dir,
+                               int (*on_extract)(const char *filename,
+                                                 void *arg),
+                               void *arg) {
+  int err = 0;
+  mz_uint i, n;
+  char path[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE + 1];
+  mz_zip_archive_file_stat info;
+  size_t dirlen = 0, filename_size = MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE;
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+  mz_uint32 xattr = 0;
+#else
+  struct zip_dir_cache_t cache;
+  cache.depth = 0;
+  cache.fds[0] = -1;
+#endif
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+  int aborted = 0;
+  struct zip_uring_t *ring = NULL;
+#endif
+
+  memset(path, 0, sizeof(path));
+
+  dirlen = strlen(dir);
+  if (dirlen + 1 > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE) {
+    return ZIP_EINVENTNAME;
+  }
+
+  memset((void *)&info, 0, sizeof(mz_zip_archive_file_stat));
+
+#if defined(_MSC_VER)
+  strcpy_s(path, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE, dir);
+#else
+  strncpy(path, dir, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE);
+#endif
+
+  if (!ISSLASH(path[dirlen - 1])) {
+#if defined(_WIN32) || defined(__WIN32__)
+    path[dirlen] = '\\';
+#else
+    path[dirlen] = '/';
+#endif
+    ++dirlen;
+  }
+
+  if (filename_size > MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen) {
+    filename_size = MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - dirlen;
+  }
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+#else
+  // create the output directory once, entries are created relative to it
+  err = zip_mkpath(path);
+  if (err < 0) {
+    goto out;
+  }
+  err = zip_dir_cache_init(&cache, dir);
+  if (err < 0) {
+    goto out;
+  }
+#endif
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+  // NULL without kernel support, entries are then extracted one by one
+  ring = zip_uring_open();
+#endif
+
+  // Get and print information about each file in the archive.
+  n = mz_zip_reader_get_num_files(zip_archive);
+  for (i = 0; i < n; ++i) {
+    if (!mz_zip_reader_file_stat(zip_archive, i, &info)) {
+      // Cannot get information about zip archive;
+      err = ZIP_ENOENT;
+      goto out;
+    }
+
+    if (!zip_name_normalize(info.m_filename, info.m_filename,
+                            strlen(info.m_filename))) {
+      // Cannot normalize file name;
+      err = ZIP_EINVENTNAME;
+      goto out;
+    }
+
+#if defined(_MSC_VER)
+    strncpy_s(&path[dirlen], filename_size, info.m_filename, filename_size);
+#else
+    strncpy(&path[dirlen], info.m_filename, filename_size);
+#endif
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+    err = zip_mkpath(path);
+    if (err < 0) {
+      // Cannot make a path
+      goto out;
+    }
+
+    if ((((info.m_version_made_by >> 8) == 3) ||
+         ((info.m_version_made_by >> 8) ==
+          19)) // if zip is produced on Unix or macOS (3 and 19 from
+               // section 4.4.2.2 of zip standard)
+        && info.m_external_attr &
+               (0x20 << 24)) { // and has sym link attribute (0x80 is file,
+                               // 0x40 is directory)
+      // symlinks are not restored on Windows
+    } else {
+      if (!mz_zip_reader_is_file_a_directory(zip_archive, i)) {
+        if (!mz_zip_reader_extract_to_file(zip_archive, i, path, 0)) {
+          // Cannot extract zip archive to file
+          err = ZIP_ENOFILE;
+          goto out;
+        }
+      }
+
+#if defined(_MSC_VER) || defined(PS4)
+      (void)xattr; // unused
+#else
+      xattr = (info.m_external_attr >> 16) & 0xFFFF;
+      if (xattr > 0 && xattr <= MZ_UINT16_MAX) {
+        if (CHMOD(path, (mode_t)xattr) < 0) {
+          err = ZIP_ENOPERM;
+          goto out;
+        }
+      }
+#endif
+    }
+#else
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+    if (ring) {
+      err = zip_uring_extract(ring, zip_archive, i, &info, &cache, path, dirlen,
+                              on_extract, arg, &aborted);
+      if (err < 0 || aborted) {
+        goto out;
+      }
+      continue;
+    }
+#endif
+    err = zip_archive_extract_at(zip_archive, i, &info, &cache, &path[dirlen]);
+    if (err < 0) {
+      goto out;
+    }
+#endif
+
+    if (on_extract) {
+      if (on_extract(path, arg) < 0) {
+        goto out;
+      }
+    }
+  }
+
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+  if (ring) {
+    err = zip_uring_flush(ring, on_extract, arg, &aborted);
+  }
+#endif
+
+out:
+#if defined(ZIP_ENABLE_IO_URING) && defined(__linux__)
+  zip_uring_close(ring);
+#endif
+#if defined(_WIN32) || defined(__WIN32__) || defined(_MSC_VER) ||              \
+    defined(__MINGW32__)
+#else
+  zip_dir_cache_free(&cache);
+#endif
+  // Close the archive, freeing any resources it was using
+  if (!mz_zip_reader_end(zip_archive)) {
+    // Cannot end zip reader
+    err = ZIP_ECLSZIP;
+  }
+  return err;
+}
+
+static inline void zip_archive_finalize(mz_zip_archive *pzip) {
+  mz_zip_writer_finalize_archive(pzip);
+  zip_archive_truncate(pzip);
+}
+
+static int zip_entry_mark_offsets(struct zip_t *zip,
+                                  struct zip_entry_mark_t *entry_mark,
+                                  const size_t n) {
+  struct zip_entry_info_t info;
+  size_t i;
+  int err;
+  // read the central directory records in place, no entry is opened
+  for (i = 0; i < n; ++i) {
+    if ((err = zip_central_dir_info(&zip->archive, (mz_uint32)i, &info)) < 0) {
+      return err;
+    }
+    entry_mark[i].type = MZ_KEEP;
+    entry_mark[i].m_local_header_ofs = info.header_offset;
+    entry_mark[i].file_index = (ssize_t)-1;
+    entry_mark[i].lf_length = 0;
+  }
+  return 0;
+}
+
+static ssize_t zip_entry_mark(struct zip_t *zip,
+                              struct zip_entry_mark_t *entry_mark,
+                              const size_t n, char *const entries[],
+                              const size_t len) {
+  struct zip_name_index_t name_index;
+  size_t j;
+  int err;
+  if (!zip || !entry_mark || !entries) {
+    return ZIP_ENOINIT;
+  }
+
+  if ((err = zip_entry_mark_offsets(zip, entry_mark, n)) < 0) {
+    return err;
+  }
+
+  // one hash lookup per requested name instead of comparing every entry
+  // with every name
+  memset(&name_index, 0, sizeof(name_index));
+  if ((err = zip_name_index_build(&zip->archive, &name_index)) < 0) {
+    return err;
+  }
+  for (j = 0; j < len; ++j) {
+    size_t name_len;
+    mz_uint32 slot;
+    if (!entries[j]) {
+      continue;
+    }
+    name_len = strlen(entries[j]);
+    slot = zip_name_hash(entries[j], name_len) & name_index.mask;
+    // every entry carrying the name is deleted, not only the first one
+    while (name_index.slots[slot]) {
+      mz_uint32 index = name_index.slots[slot] - 1;
+      const mz_uint8 *pHeader = zip_central_dir_header(&zip->archive, index);
+      if (MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS) == name_len &&
+          memcmp(entries[j], pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+                 name_len) == 0) {
+        entry_mark[index].type = MZ_DELETE;
+      }
+      slot = (slot + 1) & name_index.mask;
+    }
+  }
+  zip_name_index_free(&name_index);
+  return 0;
+}
+
+static ssize_t zip_entry_markbyindex(struct zip_t *zip,
+                                     struct zip_entry_mark_t *entry_mark,
+                                     const size_t n, size_t entries[],
+                                     const size_t len) {
+  size_t j;
+  int err;
+  if (!zip || !entry_mark || !entries) {
+    return ZIP_ENOINIT;
+  }
+
+  if ((err = zip_entry_mark_offsets(zip, entry_mark, n)) < 0) {
+    return err;
+  }
+  // indexes past the end are ignored
+  for (j = 0; j < len; ++j) {
+    if (entries[j] < n) {
+      entry_mark[entries[j]].type = MZ_DELETE;
+    }
+  }
+  return 0;
+}
+
+struct zip_entry_order_t {
+  mz_uint64 m_local_header_ofs;
+  mz_uint64 length;
+  size_t index;
+};
+
+static int zip_entry_order_compare(const void *l, const void *r) {
+  const struct zip_entry_order_t *pL = (const struct zip_entry_order_t *)l;
+  const struct zip_entry_order_t *pR = (const struct zip_entry_order_t *)r;
+  if (pL->m_local_header_ofs != pR->m_local_header_ofs) {
+    return pL->m_local_header_ofs < pR->m_local_header_ofs ? -1 : 1;
+  }
+  return pL->index < pR->index ? -1 : (pL->index > pR->index);
+}
+
+static int zip_entry_finalize(struct zip_t *zip,
+                              struct zip_entry_mark_t *entry_mark,
+                              const size_t n) {
+  size_t i;
+  mz_bool deleted = MZ_FALSE;
+  struct zip_entry_order_t *order = NULL;
+
+  if (n == 0) {
+    return 0;
+  }
+  order = (struct zip_entry_order_t *)malloc(n * sizeof(*order));
+  if (!order) {
+    return ZIP_EOOMEM;
+  }
+  for (i = 0; i < n; ++i) {
+    order[i].m_local_header_ofs = entry_mark[i].m_local_header_ofs;
+    order[i].index = i;
+  }
+  qsort(order, n, sizeof(*order), zip_entry_order_compare);
+
+  // file_index becomes the position in local header order, the length of an
+  // entry runs up to the next local header (or the central directory)
+  for (i = 0; i < n; ++i) {
+    struct zip_entry_mark_t *mark = &entry_mark[order[i].index];
+    mark->file_index = (ssize_t)i;
+    mark->lf_length = (i + 1 < n ? order[i + 1].m_local_header_ofs
+                                 : zip->archive.m_archive_size) -
+                      order[i].m_local_header_ofs;
+    if (mark->type == MZ_DELETE) {
+      deleted = MZ_TRUE;
+    } else if (deleted) {
+      mark->type = MZ_MOVE;
+    }
+  }
+
+  CLEANUP(order);
+  return 0;
+}
+
+static ssize_t zip_entry_set(struct zip_t *zip,
+                             struct zip_entry_mark_t *entry_mark, size_t n,
+                             char *const entries[], const size_t len) {
+  ssize_t err = 0;
+
+  if ((err = zip_entry_mark(zip, entry_mark, n, entries, len)) < 0) {
+    return err;
+  }
+  if ((err = zip_entry_finalize(zip, entry_mark, n)) < 0) {
+    return err;
+  }
+  return 0;
+}
+
+static ssize_t zip_entry_setbyindex(struct zip_t *zip,
+                                    struct zip_entry_mark_t *entry_mark,
+                                    size_t n, size_t entries[],
+                                    const size_t len) {
+  ssize_t err = 0;
+
+  if ((err = zip_entry_markbyindex(zip, entry_mark, n, entries, len)) < 0) {
+    return err;
+  }
+  if ((err = zip_entry_finalize(zip, entry_mark, n)) < 0) {
+    return err;
+  }
+  return 0;
+}
+
+static ssize_t zip_mem_move(void *pBuf, size_t bufSize, const mz_uint64 to,
+                            const mz_uint64 from, const size_t length) {
+  uint8_t *dst = NULL, *src = NULL, *end = NULL;
+
+  if (!pBuf) {
+    return ZIP_EINVIDX;
+  }
+
+  end = (uint8_t *)pBuf + bufSize;
+
+  if (to > bufSize) {
+    return ZIP_EINVIDX;
+  }
+
+  if (from > bufSize) {
+    return ZIP_EINVIDX;
+  }
+
+  dst = (uint8_t *)pBuf + to;
+  src = (uint8_t *)pBuf + from;
+
+  if (((dst + length) > end) || ((src + length) > end)) {
+    return ZIP_EINVIDX;
+  }
+
+  memmove(dst, src, length);
+  return length;
+}
+
+#define ZIP_MOVE_BUFFER_SIZE ((size_t)1 << 20) // 1M
+
+static int zip_file_move(MZ_FILE *m_pFile, mz_uint64 to, mz_uint64 from,
+                         mz_uint64 length) {
+  mz_uint8 *move_buf = NULL;
+  size_t move_count;
+  int err = 0;
+
+  // stdio may still buffer data of the file
+  if (fflush(m_pFile)) {
+    return ZIP_EFWRITE;
+  }
+#if defined(__linux__)
+  // the kernel copies (or reflinks) the data without a round trip through
+  // user space; ranges of one call must not overlap, so only worth it for
+  // large holes
+  if (from - to >= ZIP_MOVE_BUFFER_SIZE) {
+    int fd = fileno(m_pFile);
+    while (length > 0) {
+      loff_t off_in = (loff_t)from, off_out = (loff_t)to;
+      ssize_t n = copy_file_range(
+          fd, &off_in, fd, &off_out,
+          (size_t)MZ_MIN(length, MZ_MIN(from - to, (mz_uint64)1 << 30)), 0);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        // not supported here, copy the rest through the buffer
+        break;
+      }
+      to += (mz_uint64)n;
+      from += (mz_uint64)n;
+      length -= (mz_uint64)n;
+    }
+    if (length == 0) {
+      // drop whatever stdio read ahead before the copy
+      return MZ_FSEEK64(m_pFile, 0, SEEK_SET) ? ZIP_EFSEEK : 0;
+    }
+  }
+#endif
+
+  move_buf = (mz_uint8 *)malloc(
+      (size_t)MZ_MIN(length, (mz_uint64)ZIP_MOVE_BUFFER_SIZE));
+  if (!move_buf) {
+    return ZIP_EOOMEM;
+  }
+  // moving towards the front of the file, so copying front to back never
+  // overwrites data that has not been read yet
+  while (length > 0) {
+    move_count = (size_t)MZ_MIN(length, (mz_uint64)ZIP_MOVE_BUFFER_SIZE);
+    if (MZ_FSEEK64(m_pFile, from, SEEK_SET)) {
+      err = ZIP_EFSEEK;
+      break;
+    }
+    if (fread(move_buf, 1, move_count, m_pFile) != move_count) {
+      err = ZIP_EFREAD;
+      break;
+    }
+    if (MZ_FSEEK64(m_pFile, to, SEEK_SET)) {
+      err = ZIP_EFSEEK;
+      break;
+    }
+    if (fwrite(move_buf, 1, move_count, m_pFile) != move_count) {
+      err = ZIP_EFWRITE;
+      break;
+    }
+    to += move_count;
+    from += move_count;
+    length -= move_count;
+  }
+  CLEANUP(move_buf);
+  return err;
+}
+
+static int zip_files_move(struct zip_t *zip, mz_uint64 writen_num,
+                          mz_uint64 read_num, mz_uint64 length) {
+  ssize_t n = 0;
+  mz_zip_internal_state *pState = zip->archive.m_pState;
+
+  if (pState->m_pFile) {
+    return zip_file_move(pState->m_pFile,
+                         pState->m_file_archive_start_ofs + writen_num,
+                         pState->m_file_archive_start_ofs + read_num, length);
+  }
+  if (pState->m_pMem) {
+    if (length > pState->m_mem_size) {
+      return ZIP_EINVIDX;
+    }
+    n = zip_mem_move(pState->m_pMem, pState->m_mem_size, writen_num, read_num,
+                     (size_t)length);
+    return n < 0 ? (int)n : 0;
+  }
+  return ZIP_ENOFILE;
+}
+
+static int zip_central_dir_set_offset(mz_uint8 *pHeader, mz_uint64 offset) {
+  const mz_uint8 *pExtra = NULL;
+  mz_uint32 extra_len, field_id, field_len, skip = 0;
+
+  if (MZ_READ_LE32(pHeader + MZ_ZIP_CDH_LOCAL_HEADER_OFS) != MZ_UINT32_MAX) {
+    // offsets only shrink, the new one still fits
+    MZ_WRITE_LE32(pHeader + MZ_ZIP_CDH_LOCAL_HEADER_OFS, offset);
+    return 0;
+  }
+  // the offset lives in the zip64 extended information field, behind the
+  // sizes that are saturated as well
+  if (MZ_READ_LE32(pHeader + MZ_ZIP_CDH_DECOMPRESSED_SIZE_OFS) ==
+      MZ_UINT32_MAX) {
+    skip += 8;
+  }
+  if (MZ_READ_LE32(pHeader + MZ_ZIP_CDH_COMPRESSED_SIZE_OFS) == MZ_UINT32_MAX) {
+    skip += 8;
+  }
+  extra_len = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_EXTRA_LEN_OFS);
+  pExtra = pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE +
+           MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  while (extra_len >= 4) {
+    field_id = MZ_READ_LE16(pExtra);
+    field_len = MZ_READ_LE16(pExtra + 2);
+    if (field_len + 4 > extra_len) {
+      break;
+    }
+    if (field_id == MZ_ZIP64_EXTENDED_INFORMATION_FIELD_HEADER_ID) {
+      if (field_len < skip + 8) {
+        break;
+      }
+      MZ_WRITE_LE64(pExtra + 4 + skip, offset);
+      return 0;
+    }
+    pExtra += field_len + 4;
+    extra_len -= field_len + 4;
+  }
+  return ZIP_ENOHDR;
+}
+
+static int zip_central_dir_delete(mz_zip_internal_state *pState,
+                                  const mz_bool *deleted_entry_flag_array,
+                                  size_t entry_num) {
+  mz_uint8 *central_dir = (mz_uint8 *)pState->m_central_dir.m_p;
+  mz_uint32 *offsets = (mz_uint32 *)pState->m_central_dir_offsets.m_p;
+  size_t i, kept = 0, write_ofs = 0;
+
+  // compact the kept records in a single pass
+  for (i = 0; i < entry_num; ++i) {
+    size_t begin = offsets[i];
+    size_t end =
+        i + 1 < entry_num ? offsets[i + 1] : pState->m_central_dir.m_size;
+    if (deleted_entry_flag_array[i]) {
+      continue;
+    }
+    if (write_ofs != begin) {
+      memmove(central_dir + write_ofs, central_dir + begin, end - begin);
+    }
+    offsets[kept++] = (mz_uint32)write_ofs;
+    write_ofs += end - begin;
+  }
+
+  pState->m_central_dir.m_size = write_ofs;
+  pState->m_central_dir_offsets.m_size = kept;
+  return 0;
+}
+
+static ssize_t zip_entries_delete_mark(struct zip_t *zip,
+                                       struct zip_entry_mark_t *entry_mark,
+                                       size_t entry_num) {
+  mz_uint64 read_num = 0;
+  mz_uint64 deleted_length = 0;
+  mz_uint64 move_length = 0;
+  size_t i = 0;
+  size_t deleted_entry_num = 0;
+  ssize_t err = 0;
+  size_t *order = NULL;
+  mz_bool *deleted_entry_flag_array = NULL;
+  mz_zip_internal_state *pState = zip->archive.m_pState;
+
+  if (entry_num == 0) {
+    return 0;
+  }
+  deleted_entry_flag_array = (mz_bool *)calloc(entry_num, sizeof(mz_bool));
+  order = (size_t *)malloc(entry_num * sizeof(size_t));
+  if (!deleted_entry_flag_array || !order) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+  for (i = 0; i < entry_num; ++i) {
+    order[entry_mark[i].file_index] = i;
+  }
+
+  zip->archive.m_zip_mode = MZ_ZIP_MODE_WRITING;
+
+  // walk the entries in file order; a run of kept entries behind a hole is
+  // moved with one call
+  i = 0;
+  while (i < entry_num) {
+    struct zip_entry_mark_t *mark = &entry_mark[order[i]];
+    if (mark->type == MZ_KEEP) {
+      i++;
+      continue;
+    }
+    if (mark->type == MZ_DELETE) {
+      deleted_entry_flag_array[order[i]] = MZ_TRUE;
+      deleted_length += mark->lf_length;
+      deleted_entry_num++;
+      i++;
+      continue;
+    }
+
+    read_num = mark->m_local_header_ofs;
+    move_length = 0;
+    while (i < entry_num && entry_mark[order[i]].type == MZ_MOVE) {
+      mark = &entry_mark[order[i]];
+      err = zip_central_dir_set_offset(
+          &MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir, mz_uint8,
+                                MZ_ZIP_ARRAY_ELEMENT(
+                                    &pState->m_central_dir_offsets, mz_uint32,
+                                    order[i])),
+          mark->m_local_header_ofs - deleted_length);
+      if (err < 0) {
+        goto cleanup;
+      }
+      move_length += mark->lf_length;
+      i++;
+    }
+    err = zip_files_move(zip, read_num - deleted_length, read_num, move_length);
+    if (err < 0) {
+      goto cleanup;
+    }
+  }
+
+  zip->archive.m_archive_size -= deleted_length;
+  zip->archive.m_total_files = (mz_uint32)(entry_num - deleted_entry_num);
+
+  zip_central_dir_delete(pState, deleted_entry_flag_array, entry_num);
+  // entry indexes have shifted
+  zip_name_index_free(&zip->name_index);
+  err = (ssize_t)deleted_entry_num;
+
+cleanup:
+  CLEANUP(order);
+  CLEANUP(deleted_entry_flag_array);
+  return err;
+}
+
+static int zip_local_record_length(mz_zip_archive *pzip, mz_uint32 index,
+                                   mz_uint64 archive_size,
+                                   mz_uint64 *length) {
+  const mz_uint8 *pHeader = zip_central_dir_header(pzip, index);
+  struct zip_entry_info_t info;
+  mz_uint8 footer[MZ_ZIP_DATA_DESCRIPTER_SIZE64];
+  mz_uint64 data_offset, end;
+  size_t n, sig = 0;
+  int err;
+
+  if ((err = zip_central_dir_info(pzip, index, &info)) < 0) {
+    return err;
+  }
+  if ((err = zip_local_data_offset(pzip->m_pRead, pzip->m_pIO_opaque,
+                                   archive_size, info.header_offset,
+                                   info.comp_size, &data_offset)) < 0) {
+    return err;
+  }
+  end = data_offset + info.comp_size;
+  if (MZ_READ_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS) &
+      MZ_ZIP_LDH_BIT_FLAG_HAS_LOCATOR) {
+    // the data descriptor signature is optional and the sizes are 4 or 8
+    // bytes wide, tell them apart by the values they must carry
+    n = pzip->m_pRead(pzip->m_pIO_opaque, end, footer,
+                      (size_t)MZ_MIN((mz_uint64)sizeof(footer),
+                                     archive_size - end));
+    if (n >= 4 && MZ_READ_LE32(footer) == MZ_ZIP_DATA_DESCRIPTOR_ID) {
+      sig = 4;
+    }
+    if (n >= sig + 20 && MZ_READ_LE32(footer + sig) == info.crc32 &&
+        MZ_READ_LE64(footer + sig + 4) == info.comp_size &&
+        MZ_READ_LE64(footer + sig + 12) == info.uncomp_size) {
+      end += sig + 20;
+    } else if (n >= sig + 12) {
+      end += sig + 12;
+    }
+  }
+  *length = end - info.header_offset;
+  return 0;
+}
+
+static int zip_entries_unlink_mark(struct zip_t *zip,
+                                   const struct zip_entry_mark_t *entry_mark,
+                                   size_t entry_num) {
+  size_t i, deleted_entry_num = 0;
+  mz_bool *deleted_entry_flag_array =
+      (mz_bool *)calloc(entry_num ? entry_num : 1, sizeof(mz_bool));
+  if (!deleted_entry_flag_array) {
+    return ZIP_EOOMEM;
+  }
+  for (i = 0; i < entry_num; ++i) {
+    if (entry_mark[i].type == MZ_DELETE) {
+      deleted_entry_flag_array[i] = MZ_TRUE;
+      deleted_entry_num++;
+    }
+  }
+  // the local records become dead space, zip_compact reclaims it
+  zip_central_dir_delete(zip->archive.m_pState, deleted_entry_flag_array,
+                         entry_num);
+  zip->archive.m_total_files = (mz_uint32)(entry_num - deleted_entry_num);
+  zip_name_index_free(&zip->name_index);
+  CLEANUP(deleted_entry_flag_array);
+  return (int)deleted_entry_num;
+}
+
+static int zip_file_write_le(MZ_FILE *fp, mz_uint64 value, size_t n) {
+  mz_uint8 bytes[8];
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    bytes[i] = (mz_uint8)(value >> (8 * i));
+  }
+  return fwrite(bytes, 1, n, fp) == n ? 0 : ZIP_EFWRITE;
+}
+
+static int zip_file_read_le(MZ_FILE *fp, mz_uint64 *value, size_t n) {
+  mz_uint8 bytes[8];
+  size_t i;
+  if (fread(bytes, 1, n, fp) != n) {
+    return ZIP_EINVIDXFILE;
+  }
+  *value = 0;
+  for (i = 0; i < n; ++i) {
+    *value |= (mz_uint64)bytes[i] << (8 * i);
+  }
+  return 0;
+}
+
+#define ZIP_DIR_INDEX_MAGIC 0x5844495a // "ZIDX"
+#define ZIP_DIR_INDEX_VERSION 1
+#define ZIP_DIR_INDEX_SUFFIX ".zidx"
+#define ZIP_DIR_INDEX_ZIP64 0x1
+#define ZIP_DIR_INDEX_ZIP64_FIELDS 0x2
+
+static int zip_file_read_le32_array(MZ_FILE *fp, mz_uint32 *values, size_t n) {
+  size_t i;
+  if (fread(values, sizeof(mz_uint32), n, fp) != n) {
+    return ZIP_EINVIDXFILE;
+  }
+  for (i = 0; i < n; ++i) {
+    values[i] = MZ_READ_LE32((const mz_uint8 *)&values[i]);
+  }
+  return 0;
+}
+
+static int zip_dir_index_read(MZ_FILE *fp, mz_zip_archive *pzip,
+                              struct zip_name_index_t *name_index,
+                              const char *zipname, mz_uint flags) {
+  mz_zip_internal_state *pState = NULL;
+  mz_uint64 magic = 0, version = 0, file_size = 0, start_ofs = 0,
+            cdir_ofs = 0, cdir_size = 0, cdir_crc32 = 0, total_files = 0,
+            capacity = 0, index_flags = 0, reserved = 0;
+  mz_uint32 *offsets = NULL;
+  mz_uint8 *seen = NULL;
+  MZ_FILE *pFile = NULL;
+  mz_uint64 i, used = 0;
+  int err = 0;
+
+  if ((err = zip_file_read_le(fp, &magic, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &version, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &file_size, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &start_ofs, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &cdir_ofs, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &cdir_size, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &cdir_crc32, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &total_files, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &capacity, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &index_flags, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &reserved, 4)) < 0) {
+    return err;
+  }
+  if (magic != ZIP_DIR_INDEX_MAGIC || version != ZIP_DIR_INDEX_VERSION ||
+      !total_files ||
+      capacity != zip_name_index_capacity((mz_uint32)total_files) ||
+      cdir_size < total_files * MZ_ZIP_CENTRAL_DIR_HEADER_SIZE ||
+      start_ofs + cdir_ofs + cdir_size > file_size) {
+    return ZIP_EINVIDXFILE;
+  }
+
+  if (!(pFile = MZ_FOPEN(zipname, "rb"))) {
+    return ZIP_EOPNFILE;
+  }
+  // a stale index is detected by the archive size and the central directory
+  // CRC-32, which is all that has to be read from the archive
+  if (MZ_FSEEK64(pFile, 0, SEEK_END) ||
+      (mz_uint64)MZ_FTELL64(pFile) != file_size) {
+    MZ_FCLOSE(pFile);
+    return ZIP_EINVIDXFILE;
+  }
+  if (!mz_zip_reader_init_internal(pzip, flags)) {
+    MZ_FCLOSE(pFile);
+    return ZIP_ERINIT;
+  }
+  pState = pzip->m_pState;
+  pzip->m_zip_type = MZ_ZIP_TYPE_FILE;
+  pzip->m_pRead = mz_zip_file_read_func;
+  pzip->m_pIO_opaque = pzip;
+  pState->m_pFile = pFile;
+  pState->m_file_archive_start_ofs = start_ofs;
+  pState->m_zip64 = (index_flags & ZIP_DIR_INDEX_ZIP64) ? MZ_TRUE : MZ_FALSE;
+  pState->m_zip64_has_extended_info_fields =
+      (index_flags & ZIP_DIR_INDEX_ZIP64_FIELDS) ? MZ_TRUE : MZ_FALSE;
+  pzip->m_archive_size = file_size - start_ofs;
+  pzip->m_central_directory_file_ofs = cdir_ofs;
+
+  if (!mz_zip_array_resize(pzip, &pState->m_central_dir, (size_t)cdir_size,
+                           MZ_FALSE) ||
+      !mz_zip_array_resize(pzip, &pState->m_central_dir_offsets,
+                           (size_t)total_files, MZ_FALSE)) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+  if (pzip->m_pRead(pzip->m_pIO_opaque, cdir_ofs, pState->m_central_dir.m_p,
+                    (size_t)cdir_size) != cdir_size) {
+    err = ZIP_EFREAD;
+    goto cleanup;
+  }
+  if (zip_crc32(0, pState->m_central_dir.m_p, (size_t)cdir_size) !=
+      cdir_crc32) {
+    err = ZIP_EINVIDXFILE;
+    goto cleanup;
+  }
+
+  // records are not parsed again, only kept inside the central directory
+  offsets = (mz_uint32 *)pState->m_central_dir_offsets.m_p;
+  if ((err = zip_file_read_le32_array(fp, offsets, (size_t)total_files)) < 0) {
+    goto cleanup;
+  }
+  // the CRC-32 only vouches for the central directory, every offset must
+  // still land on a record that fits inside it
+  for (i = 0; i < total_files; ++i) {
+    const mz_uint8 *pHeader = NULL;
+    if (offsets[i] > cdir_size - MZ_ZIP_CENTRAL_DIR_HEADER_SIZE) {
+      err = ZIP_EINVIDXFILE;
+      goto cleanup;
+    }
+    pHeader = (const mz_uint8 *)pState->m_central_dir.m_p + offsets[i];
+    if (MZ_READ_LE32(pHeader) != MZ_ZIP_CENTRAL_DIR_HEADER_SIG ||
+        (mz_uint64)MZ_ZIP_CENTRAL_DIR_HEADER_SIZE +
+                MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS) +
+                MZ_READ_LE16(pHeader + MZ_ZIP_CDH_EXTRA_LEN_OFS) +
+                MZ_READ_LE16(pHeader + MZ_ZIP_CDH_COMMENT_LEN_OFS) >
+            cdir_size - offsets[i]) {
+      err = ZIP_EINVIDXFILE;
+      goto cleanup;
+    }
+  }
+
+  name_index->slots =
+      (mz_uint32 *)malloc((size_t)capacity * sizeof(mz_uint32));
+  if (!name_index->slots) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+  name_index->mask = (mz_uint32)(capacity - 1);
+  if ((err = zip_file_read_le32_array(fp, name_index->slots,
+                                      (size_t)capacity)) < 0) {
+    goto cleanup;
+  }
+  // each entry must sit in exactly one slot; the rest stay empty, which
+  // also ends every probe sequence
+  seen = (mz_uint8 *)calloc((size_t)total_files, sizeof(mz_uint8));
+  if (!seen) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+  for (i = 0; i < capacity; ++i) {
+    mz_uint32 slot = name_index->slots[i];
+    if (!slot) {
+      continue;
+    }
+    if (slot > total_files || seen[slot - 1]) {
+      err = ZIP_EINVIDXFILE;
+      goto cleanup;
+    }
+    seen[slot - 1] = 1;
+    ++used;
+  }
+  if (used != total_files) {
+    err = ZIP_EINVIDXFILE;
+    goto cleanup;
+  }
+  CLEANUP(seen);
+  pzip->m_total_files = (mz_uint32)total_files;
+  return 0;
+
+cleanup:
+  CLEANUP(seen);
+  zip_name_index_free(name_index);
+  // closes the archive file as well
+  mz_zip_reader_end(pzip);
+  mz_zip_zero_struct(pzip);
+  return err;
+}
+
+// Opens the archive through its .zidx sidecar, skipping the parsing of the
+// central directory records and the building of the name index.
+static int zip_dir_index_open(struct zip_t *zip, const char *zipname) {
+  size_t len = strlen(zipname);
+  char *filename = NULL;
+  MZ_FILE *fp = NULL;
+  int err;
+
+  filename = (char *)malloc(len + sizeof(ZIP_DIR_INDEX_SUFFIX));
+  if (!filename) {
+    return ZIP_EOOMEM;
+  }
+  memcpy(filename, zipname, len);
+  memcpy(filename + len, ZIP_DIR_INDEX_SUFFIX, sizeof(ZIP_DIR_INDEX_SUFFIX));
+  fp = MZ_FOPEN(filename, "rb");
+  CLEANUP(filename);
+  if (!fp) {
+    return ZIP_EOPNFILE;
+  }
+  err = zip_dir_index_read(fp, &zip->archive, &zip->name_index, zipname,
+                           zip->level |
+                               MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY);
+  fclose(fp);
+  return err;
+}
+
+int zip_dirindex_save(struct zip_t *zip, const char *filename) {
+  mz_zip_archive *pzip = NULL;
+  mz_zip_internal_state *pState = NULL;
+  MZ_FILE *fp = NULL;
+  mz_uint32 i, flags = 0;
+  int err = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!filename) {
+    return ZIP_EINVAL;
+  }
+  pzip = &(zip->archive);
+  pState = pzip->m_pState;
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING || !pState ||
+      !pState->m_pFile) {
+    // only archives opened from a file can be reopened through the index
+    return ZIP_EINVMODE;
+  }
+  if (!pzip->m_total_files ||
+      pState->m_central_dir.m_size > MZ_UINT32_MAX) {
+    return ZIP_EINVAL;
+  }
+  if (!zip->name_index.slots &&
+      (err = zip_name_index_build(pzip, &zip->name_index)) < 0) {
+    return err;
+  }
+
+  if (!(fp = MZ_FOPEN(filename, "wb"))) {
+    return ZIP_EOPNFILE;
+  }
+  if (pState->m_zip64) {
+    flags |= ZIP_DIR_INDEX_ZIP64;
+  }
+  if (pState->m_zip64_has_extended_info_fields) {
+    flags |= ZIP_DIR_INDEX_ZIP64_FIELDS;
+  }
+  if ((err = zip_file_write_le(fp, ZIP_DIR_INDEX_MAGIC, 4)) < 0 ||
+      (err = zip_file_write_le(fp, ZIP_DIR_INDEX_VERSION, 4)) < 0 ||
+      (err = zip_file_write_le(fp,
+                               pState->m_file_archive_start_ofs +
+                                   pzip->m_archive_size,
+                               8)) < 0 ||
+      (err = zip_file_write_le(fp, pState->m_file_archive_start_ofs, 8)) < 0 ||
+      (err = zip_file_write_le(fp, pzip->m_central_directory_file_ofs, 8)) <
+          0 ||
+      (err = zip_file_write_le(fp, pState->m_central_dir.m_size, 4)) < 0 ||
+      (err = zip_file_write_le(
+           fp,
+           zip_crc32(0, pState->m_central_dir.m_p,
+                     pState->m_central_dir.m_size),
+           4)) < 0 ||
+      (err = zip_file_write_le(fp, pzip->m_total_files, 4)) < 0 ||
+      (err = zip_file_write_le(fp, (mz_uint64)zip->name_index.mask + 1, 4)) <
+          0 ||
+      (err = zip_file_write_le(fp, flags, 4)) < 0 ||
+      (err = zip_file_write_le(fp, 0, 4)) < 0) {
+    goto cleanup;
+  }
+  for (i = 0; i < pzip->m_total_files; ++i) {
+    if ((err = zip_file_write_le(
+             fp,
+             MZ_ZIP_ARRAY_ELEMENT(&pState->m_central_dir_offsets, mz_uint32, i),
+             4)) < 0) {
+      goto cleanup;
+    }
+  }
+  for (i = 0; i <= zip->name_index.mask; ++i) {
+    if ((err = zip_file_write_le(fp, zip->name_index.slots[i], 4)) < 0) {
+      goto cleanup;
+    }
+  }
+
+cleanup:
+  if (fclose(fp) != 0 && !err) {
+    err = ZIP_EFWRITE;
+  }
+  return err;
+}
+
+struct zip_t *zip_open(const char *zipname, int level, char mode) {
+  int errnum = 0;
+  return zip_openwitherror(zipname, level, mode, &errnum);
+}
+
+struct zip_t *zip_openwitherror(const char *zipname, int level, char mode,
+                                int *errnum) {
+  struct zip_t *zip = NULL;
+  *errnum = 0;
+
+  if (!zipname || strlen(zipname) < 1) {
+    // zip_t archive name is empty or NULL
+    *errnum = ZIP_EINVZIPNAME;
+    goto cleanup;
+  }
+
+  if (level < 0)
+    level = MZ_DEFAULT_LEVEL;
+  if ((level & 0xF) > MZ_UBER_COMPRESSION) {
+    // Wrong compression level
+    *errnum = ZIP_EINVLVL;
+    goto cleanup;
+  }
+
+  zip = (struct zip_t *)calloc((size_t)1, sizeof(struct zip_t));
+  if (!zip) {
+    // out of memory
+    *errnum = ZIP_EOOMEM;
+    goto cleanup;
+  }
+
+  zip->level = (mz_uint)level;
+  zip->entry.index = -1;
+  switch (mode) {
+  case 'w':
+    // Create a new archive.
+    if (!mz_zip_writer_init_file_v2(&(zip->archive), zipname, 0,
+                                    MZ_ZIP_FLAG_WRITE_ZIP64)) {
+      // Cannot initialize zip_archive writer
+      *errnum = ZIP_EWINIT;
+      goto cleanup;
+    }
+    break;
+
+  case 'r':
+    if (zip_dir_index_open(zip, zipname) == 0) {
+      break;
+    }
+    if (!mz_zip_reader_init_file_v2(
+            &(zip->archive), zipname,
+            zip->level | MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY, 0, 0)) {
+      // An archive file does not exist or cannot initialize
+      // zip_archive reader
+      *errnum = ZIP_ERINIT;
+      goto cleanup;
+    }
+    break;
+
+  case 's':
+    if ((*errnum = zip_dir_stream_open(zip, zipname)) < 0) {
+      goto cleanup;
+    }
+    break;
+
+  case 'a':
+  case 'd': {
+    MZ_FILE *fp = MZ_FOPEN(zipname, "r+b");
+    if (!fp) {
+      *errnum = ZIP_EOPNFILE;
+      goto cleanup;
+    }
+    if (!mz_zip_reader_init_cfile(
             &(zip->archive), fp, 0,
             zip->level | MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY)) {
       // An archive file does not exist or cannot initialize zip_archive
@@ -1010,356 +2755,1923 @@ struct zip_t *zip_openwitherror(const char *zipname, int level, char mode,
       fclose(fp);
       goto cleanup;
     }
-    if (!mz_zip_writer_init_from_reader_v2(&(zip->archive), zipname, 0)) {
-      *errnum = ZIP_EWRINIT;
-      fclose(fp);
-      mz_zip_reader_end(&(zip->archive));
-      goto cleanup;
+    if (!mz_zip_writer_init_from_reader_v2(&(zip->archive), zipname, 0)) {
+      *errnum = ZIP_EWRINIT;
+      fclose(fp);
+      mz_zip_reader_end(&(zip->archive));
+      goto cleanup;
+    }
+    // The file pointer is now owned by the archive object.
+    zip->archive.m_zip_type = MZ_ZIP_TYPE_FILE;
+  } break;
+
+  default:
+    *errnum = ZIP_EINVMODE;
+    goto cleanup;
+  }
+
+  return zip;
+
+cleanup:
+  CLEANUP(zip);
+  return NULL;
+}
+
+void zip_close(struct zip_t *zip) {
+  if (zip) {
+    mz_zip_archive *pZip = &(zip->archive);
+    // Always finalize, even if adding failed for some reason, so we have a
+    // valid central directory.
+    if (pZip->m_zip_mode == MZ_ZIP_MODE_WRITING) {
+      mz_zip_writer_finalize_archive(pZip);
+    }
+
+    if (pZip->m_zip_mode == MZ_ZIP_MODE_WRITING ||
+        pZip->m_zip_mode == MZ_ZIP_MODE_WRITING_HAS_BEEN_FINALIZED) {
+      zip_archive_truncate(pZip);
+      mz_zip_writer_end(pZip);
+    }
+    if (pZip->m_zip_mode == MZ_ZIP_MODE_READING) {
+      mz_zip_reader_end(pZip);
+    }
+
+    zip_seek_index_free(zip->seek_index);
+    zip_name_index_free(&zip->name_index);
+    CLEANUP(zip->entry.comp);
+    CLEANUP(zip->dir_window);
+    CLEANUP(zip);
+  }
+}
+
+int zip_is64(struct zip_t *zip) {
+  if (!zip || !zip->archive.m_pState) {
+    // zip_t handler or zip state is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  return (int)zip->archive.m_pState->m_zip64;
+}
+
+int zip_offset(struct zip_t *zip, uint64_t *offset) {
+  if (!zip || !zip->archive.m_pState) {
+    // zip_t handler or zip state is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  *offset = mz_zip_get_archive_file_start_offset(&zip->archive);
+  return 0;
+}
+
+#define ZIP_ALIGNMENT_EXTRA_ID 0xd935 // zipalign extra field
+#define ZIP_ALIGNMENT_EXTRA_SIZE 6
+#define ZIP_ALIGNMENT_MAX 32768
+
+int zip_set_alignment(struct zip_t *zip, unsigned int alignment) {
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (alignment > ZIP_ALIGNMENT_MAX || (alignment & (alignment - 1))) {
+    // the padding has to fit in a local extra field
+    return ZIP_EINVAL;
+  }
+  if (zip->archive.m_zip_mode != MZ_ZIP_MODE_WRITING) {
+    return ZIP_EINVMODE;
+  }
+  zip->alignment = (alignment > 1) ? (mz_uint32)alignment : 0;
+  return 0;
+}
+
+int zip_set_level(struct zip_t *zip, int level) {
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (level < 0) {
+    level = MZ_DEFAULT_LEVEL;
+  }
+  if (level > MZ_UBER_COMPRESSION) {
+    // Wrong compression level
+    return ZIP_EINVLVL;
+  }
+  if (zip->archive.m_zip_mode != MZ_ZIP_MODE_WRITING || zip->entry.name) {
+    // the level of an open entry is fixed until it is closed
+    return ZIP_EINVMODE;
+  }
+  zip->level = (zip->level & ~(mz_uint)0xF) | (mz_uint)level;
+  return 0;
+}
+
+static int _zip_entry_open(struct zip_t *zip, const char *entryname,
+                           int case_sensitive) {
+  size_t entrylen = 0;
+  mz_zip_archive *pzip = NULL;
+  mz_uint num_alignment_padding_bytes, level;
+  mz_zip_archive_file_stat stats;
+  int err = 0;
+  mz_uint16 dos_time = 0, dos_date = 0;
+  mz_uint32 extra_size = 0, padding_size = 0;
+  mz_uint8 extra_data[MZ_ZIP64_MAX_CENTRAL_EXTRA_FIELD_SIZE];
+  mz_uint8 padding[ZIP_ALIGNMENT_EXTRA_SIZE];
+  mz_uint64 local_dir_header_ofs = 0;
+
+  if (!zip) {
+    return ZIP_ENOINIT;
+  }
+  if (zip->dir_streamed) {
+    // 's' mode keeps no central directory, entries are read through cursors
+    return ZIP_EINVMODE;
+  }
+
+  local_dir_header_ofs = zip->archive.m_archive_size;
+
+  if (!entryname) {
+    return ZIP_EINVENTNAME;
+  }
+
+  entrylen = strlen(entryname);
+  if (entrylen == 0) {
+    return ZIP_EINVENTNAME;
+  }
+
+  if (zip->entry.name) {
+    CLEANUP(zip->entry.name);
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode == MZ_ZIP_MODE_READING) {
+    zip->entry.name = zip_strclone(entryname, entrylen);
+    if (!zip->entry.name) {
+      // Cannot parse zip entry name
+      return ZIP_EINVENTNAME;
+    }
+
+    if (zip->name_index.slots) {
+      // built by a cursor or loaded from the .zidx sidecar
+      zip->entry.index = zip_name_index_find(
+          pzip, &zip->name_index, zip->entry.name, entrylen,
+          case_sensitive ? MZ_ZIP_FLAG_CASE_SENSITIVE : 0);
+    } else {
+      zip->entry.index = (ssize_t)mz_zip_reader_locate_file(
+          pzip, zip->entry.name, NULL,
+          case_sensitive ? MZ_ZIP_FLAG_CASE_SENSITIVE : 0);
+    }
+    if (zip->entry.index < (ssize_t)0) {
+      err = ZIP_ENOENT;
+      goto cleanup;
+    }
+
+    if (!mz_zip_reader_file_stat(pzip, (mz_uint)zip->entry.index, &stats)) {
+      err = ZIP_ENOENT;
+      goto cleanup;
+    }
+
+    zip->entry.comp_size = stats.m_comp_size;
+    zip->entry.uncomp_size = stats.m_uncomp_size;
+    zip->entry.uncomp_crc32 = stats.m_crc32;
+    zip->entry.dir_offset = stats.m_central_dir_ofs;
+    zip->entry.header_offset = stats.m_local_header_ofs;
+    zip->entry.method = stats.m_method;
+    zip->entry.external_attr = stats.m_external_attr;
+#ifndef MINIZ_NO_TIME
+    zip->entry.m_time = stats.m_time;
+#endif
+
+    return 0;
+  }
+
+  /*
+    .ZIP File Format Specification Version: 6.3.3
+
+    4.4.17.1 The name of the file, with optional relative path.
+    The path stored MUST not contain a drive or
+    device letter, or a leading slash.  All slashes
+    MUST be forward slashes '/' as opposed to
+    backwards slashes '\' for compatibility with Amiga
+    and UNIX file systems etc.  If input came from standard
+    input, there is no file name field.
+  */
+  zip->entry.name = zip_strrpl(entryname, entrylen, '\\', '/');
+  if (!zip->entry.name) {
+    // Cannot parse zip entry name
+    return ZIP_EINVENTNAME;
+  }
+
+  level = zip->level & 0xF;
+
+  zip->entry.index = (ssize_t)zip->archive.m_total_files;
+  zip->entry.comp_size = 0;
+  zip->entry.uncomp_size = 0;
+  zip->entry.uncomp_crc32 = MZ_CRC32_INIT;
+  zip->entry.dir_offset = zip->archive.m_archive_size;
+  zip->entry.header_offset = zip->archive.m_archive_size;
+  memset(zip->entry.header, 0, MZ_ZIP_LOCAL_DIR_HEADER_SIZE * sizeof(mz_uint8));
+  zip->entry.method = level ? MZ_DEFLATED : 0;
+  zip->entry.raw = MZ_FALSE;
+
+  // UNIX or APPLE
+#if MZ_PLATFORM == 3 || MZ_PLATFORM == 19
+  // regular file with rw-r--r-- permissions
+  zip->entry.external_attr = (mz_uint32)(0100644) << 16;
+#else
+  zip->entry.external_attr = 0;
+#endif
+
+  num_alignment_padding_bytes =
+      mz_zip_writer_compute_padding_needed_for_file_alignment(pzip);
+
+  if (!pzip->m_pState || (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING)) {
+    // Invalid zip mode
+    err = ZIP_EINVMODE;
+    goto cleanup;
+  }
+  if (zip->level & MZ_ZIP_FLAG_COMPRESSED_DATA) {
+    // Invalid zip compression level
+    err = ZIP_EINVLVL;
+    goto cleanup;
+  }
+
+  if (!mz_zip_writer_write_zeros(pzip, zip->entry.dir_offset,
+                                 num_alignment_padding_bytes)) {
+    // Cannot memset zip entry header
+    err = ZIP_EMEMSET;
+    goto cleanup;
+  }
+  local_dir_header_ofs += num_alignment_padding_bytes;
+
+  zip->entry.m_time = time(NULL);
+#ifndef MINIZ_NO_TIME
+  mz_zip_time_t_to_dos_time(zip->entry.m_time, &dos_time, &dos_date);
+#endif
+
+  // ZIP64 header with NULL sizes (sizes will be in the data descriptor, just
+  // after file data)
+  extra_size = mz_zip_writer_create_zip64_extra_data(
+      extra_data, NULL, NULL,
+      (local_dir_header_ofs >= MZ_UINT32_MAX) ? &local_dir_header_ofs : NULL);
+
+  if (zip->alignment && !level && !ISSLASH(zip->entry.name[entrylen - 1])) {
+    // like zipalign, pad the local extra field so that stored data starts on
+    // an alignment boundary and the archive has no gaps between records
+    mz_uint64 data_ofs = local_dir_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE +
+                         entrylen + extra_size;
+    padding_size = (mz_uint32)((zip->alignment -
+                                (data_ofs & (zip->alignment - 1))) &
+                               (zip->alignment - 1));
+    while (padding_size && padding_size < ZIP_ALIGNMENT_EXTRA_SIZE) {
+      padding_size += zip->alignment;
+    }
+  }
+
+  if (!mz_zip_writer_create_local_dir_header(
+          pzip, zip->entry.header, (mz_uint16)entrylen,
+          (mz_uint16)(extra_size + padding_size), 0, 0, 0, zip->entry.method,
+          MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8 |
+              MZ_ZIP_LDH_BIT_FLAG_HAS_LOCATOR,
+          dos_time, dos_date)) {
+    // Cannot create zip entry header
+    err = ZIP_EMEMSET;
+    goto cleanup;
+  }
+
+  zip->entry.header_offset =
+      zip->entry.dir_offset + num_alignment_padding_bytes;
+
+  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.header_offset,
+                     zip->entry.header,
+                     sizeof(zip->entry.header)) != sizeof(zip->entry.header)) {
+    // Cannot write zip entry header
+    err = ZIP_EMEMSET;
+    goto cleanup;
+  }
+
+  if (pzip->m_file_offset_alignment) {
+    MZ_ASSERT(
+        (zip->entry.header_offset & (pzip->m_file_offset_alignment - 1)) == 0);
+  }
+  zip->entry.dir_offset +=
+      num_alignment_padding_bytes + sizeof(zip->entry.header);
+
+  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, zip->entry.name,
+                     entrylen) != entrylen) {
+    // Cannot write data to zip entry
+    err = ZIP_EWRTENT;
+    goto cleanup;
+  }
+
+  zip->entry.dir_offset += entrylen;
+
+  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, extra_data,
+                     extra_size) != extra_size) {
+    // Cannot write ZIP64 data to zip entry
+    err = ZIP_EWRTENT;
+    goto cleanup;
+  }
+  zip->entry.dir_offset += extra_size;
+
+  if (padding_size) {
+    MZ_WRITE_LE16(padding, ZIP_ALIGNMENT_EXTRA_ID);
+    MZ_WRITE_LE16(padding + 2, padding_size - 4);
+    MZ_WRITE_LE16(padding + 4, zip->alignment);
+    if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, padding,
+                       sizeof(padding)) != sizeof(padding) ||
+        !mz_zip_writer_write_zeros(pzip,
+                                   zip->entry.dir_offset + sizeof(padding),
+                                   padding_size - sizeof(padding))) {
+      // Cannot write alignment padding to zip entry
+      err = ZIP_EWRTENT;
+      goto cleanup;
+    }
+    zip->entry.dir_offset += padding_size;
+  }
+
+  if (level) {
+    zip->entry.state.m_pZip = pzip;
+    zip->entry.state.m_cur_archive_file_ofs = zip->entry.dir_offset;
+    zip->entry.state.m_comp_size = 0;
+
+    if (!zip->entry.comp &&
+        !(zip->entry.comp =
+              (tdefl_compressor *)malloc(sizeof(tdefl_compressor)))) {
+      err = ZIP_EOOMEM;
+      goto cleanup;
+    }
+    if (tdefl_init(zip->entry.comp, mz_zip_writer_add_put_buf_callback,
+                   &(zip->entry.state),
+                   (int)tdefl_create_comp_flags_from_zip_params(
+                       (int)level, -15, MZ_DEFAULT_STRATEGY)) !=
+        TDEFL_STATUS_OKAY) {
+      // Cannot initialize the zip compressor
+      err = ZIP_ETDEFLINIT;
+      goto cleanup;
+    }
+  }
+
+  return 0;
+
+cleanup:
+  CLEANUP(zip->entry.name);
+  return err;
+}
+
+int zip_entry_open(struct zip_t *zip, const char *entryname) {
+  return _zip_entry_open(zip, entryname, 0);
+}
+
+int zip_entry_opencasesensitive(struct zip_t *zip, const char *entryname) {
+  return _zip_entry_open(zip, entryname, 1);
+}
+
+int zip_entry_openbyindex(struct zip_t *zip, size_t index) {
+  mz_zip_archive *pZip = NULL;
+  mz_zip_archive_file_stat stats;
+  mz_uint namelen;
+  const mz_uint8 *pHeader;
+  const char *pFilename;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  pZip = &(zip->archive);
+  if (pZip->m_zip_mode != MZ_ZIP_MODE_READING || zip->dir_streamed) {
+    // open by index requires readonly mode
+    return ZIP_EINVMODE;
+  }
+
+  if (index >= (size_t)pZip->m_total_files) {
+    // index out of range
+    return ZIP_EINVIDX;
+  }
+
+  if (!(pHeader = &MZ_ZIP_ARRAY_ELEMENT(
+            &pZip->m_pState->m_central_dir, mz_uint8,
+            MZ_ZIP_ARRAY_ELEMENT(&pZip->m_pState->m_central_dir_offsets,
+                                 mz_uint32, (mz_uint)index)))) {
+    // cannot find header in central directory
+    return ZIP_ENOHDR;
+  }
+
+  namelen = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
+  pFilename = (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
+
+  if (zip->entry.name) {
+    CLEANUP(zip->entry.name);
+  }
+
+  zip->entry.name = zip_strclone(pFilename, namelen);
+  if (!zip->entry.name) {
+    // local entry name is NULL
+    return ZIP_EINVENTNAME;
+  }
+
+  if (!mz_zip_reader_file_stat(pZip, (mz_uint)index, &stats)) {
+    return ZIP_ENOENT;
+  }
+
+  zip->entry.index = (ssize_t)index;
+  zip->entry.comp_size = stats.m_comp_size;
+  zip->entry.uncomp_size = stats.m_uncomp_size;
+  zip->entry.uncomp_crc32 = stats.m_crc32;
+  zip->entry.dir_offset = stats.m_central_dir_ofs;
+  zip->entry.header_offset = stats.m_local_header_ofs;
+  zip->entry.method = stats.m_method;
+  zip->entry.external_attr = stats.m_external_attr;
+#ifndef MINIZ_NO_TIME
+  zip->entry.m_time = stats.m_time;
+#endif
+
+  return 0;
+}
+
+int zip_entry_close(struct zip_t *zip) {
+  mz_zip_archive *pzip = NULL;
+  mz_uint level;
+  tdefl_status done;
+  mz_uint16 entrylen;
+  mz_uint16 dos_time = 0, dos_date = 0;
+  int err = 0;
+  mz_uint8 *pExtra_data = NULL;
+  mz_uint32 extra_size = 0;
+  mz_uint8 extra_data[MZ_ZIP64_MAX_CENTRAL_EXTRA_FIELD_SIZE];
+  mz_uint8 local_dir_footer[MZ_ZIP_DATA_DESCRIPTER_SIZE64];
+  mz_uint32 local_dir_footer_size = MZ_ZIP_DATA_DESCRIPTER_SIZE64;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    err = ZIP_ENOINIT;
+    goto cleanup;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode == MZ_ZIP_MODE_READING) {
+    goto cleanup;
+  }
+
+  level = zip->level & 0xF;
+  if (level && !zip->entry.raw) {
+    done = tdefl_compress_buffer(zip->entry.comp, "", 0, TDEFL_FINISH);
+    if (done != TDEFL_STATUS_DONE && done != TDEFL_STATUS_OKAY) {
+      // Cannot flush compressed buffer
+      err = ZIP_ETDEFLBUF;
+      goto cleanup;
+    }
+    zip->entry.comp_size = zip->entry.state.m_comp_size;
+    zip->entry.dir_offset = zip->entry.state.m_cur_archive_file_ofs;
+    zip->entry.method = MZ_DEFLATED;
+  }
+
+  entrylen = (mz_uint16)strlen(zip->entry.name);
+#ifndef MINIZ_NO_TIME
+  mz_zip_time_t_to_dos_time(zip->entry.m_time, &dos_time, &dos_date);
+#endif
+
+  MZ_WRITE_LE32(local_dir_footer + 0, MZ_ZIP_DATA_DESCRIPTOR_ID);
+  MZ_WRITE_LE32(local_dir_footer + 4, zip->entry.uncomp_crc32);
+  MZ_WRITE_LE64(local_dir_footer + 8, zip->entry.comp_size);
+  MZ_WRITE_LE64(local_dir_footer + 16, zip->entry.uncomp_size);
+
+  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset,
+                     local_dir_footer,
+                     local_dir_footer_size) != local_dir_footer_size) {
+    // Cannot write zip entry header
+    err = ZIP_EWRTHDR;
+    goto cleanup;
+  }
+  zip->entry.dir_offset += local_dir_footer_size;
+
+  pExtra_data = extra_data;
+  extra_size = mz_zip_writer_create_zip64_extra_data(
+      extra_data,
+      (zip->entry.uncomp_size >= MZ_UINT32_MAX) ? &zip->entry.uncomp_size
+                                                : NULL,
+      (zip->entry.comp_size >= MZ_UINT32_MAX) ? &zip->entry.comp_size : NULL,
+      (zip->entry.header_offset >= MZ_UINT32_MAX) ? &zip->entry.header_offset
+                                                  : NULL);
+
+  if ((entrylen) && ISSLASH(zip->entry.name[entrylen - 1]) &&
+      !zip->entry.uncomp_size) {
+    /* Set DOS Subdirectory attribute bit. */
+    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+  }
+
+  if (!mz_zip_writer_add_to_central_dir(
+          pzip, zip->entry.name, entrylen, pExtra_data, (mz_uint16)extra_size,
+          "", 0, zip->entry.uncomp_size, zip->entry.comp_size,
+          zip->entry.uncomp_crc32, zip->entry.method,
+          MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8 |
+              MZ_ZIP_LDH_BIT_FLAG_HAS_LOCATOR,
+          dos_time, dos_date, zip->entry.header_offset,
+          zip->entry.external_attr, NULL, 0)) {
+    // Cannot write to zip central dir
+    err = ZIP_EWRTDIR;
+    goto cleanup;
+  }
+
+  pzip->m_total_files++;
+  pzip->m_archive_size = zip->entry.dir_offset;
+
+cleanup:
+  if (zip) {
+    zip->entry.m_time = 0;
+    zip->entry.index = -1;
+    zip->entry.raw = MZ_FALSE;
+    CLEANUP(zip->entry.name);
+  }
+  return err;
+}
+
+const char *zip_entry_name(struct zip_t *zip) {
+  if (!zip) {
+    // zip_t handler is not initialized
+    return NULL;
+  }
+  return zip->entry.name;
+}
+
+ssize_t zip_entry_index(struct zip_t *zip) {
+  if (!zip) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  return zip->entry.index;
+}
+
+int zip_entry_isdir(struct zip_t *zip) {
+  mz_uint16 entrylen;
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  if (zip->entry.index < (ssize_t)0) {
+    // zip entry is not opened
+    return ZIP_EINVIDX;
+  }
+
+  entrylen = (mz_uint16)strlen(zip->entry.name);
+  return ISSLASH(zip->entry.name[entrylen - 1]);
+}
+
+unsigned long long zip_entry_size(struct zip_t *zip) {
+  return zip_entry_uncomp_size(zip);
+}
+
+unsigned long long zip_entry_uncomp_size(struct zip_t *zip) {
+  return zip ? zip->entry.uncomp_size : 0;
+}
+
+unsigned long long zip_entry_comp_size(struct zip_t *zip) {
+  return zip ? zip->entry.comp_size : 0;
+}
+
+unsigned int zip_entry_crc32(struct zip_t *zip) {
+  return zip ? zip->entry.uncomp_crc32 : 0;
+}
+
+int zip_entry_method(struct zip_t *zip) {
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (zip->entry.index < (ssize_t)0) {
+    return ZIP_ENOENT;
+  }
+  return (int)zip->entry.method;
+}
+
+long long zip_entry_mtime(struct zip_t *zip) {
+  return zip ? (long long)zip->entry.m_time : 0;
+}
+
+// Slicing-by-8 tables of the reflected CRC-32 polynomial 0xEDB88320:
+// table[0] is the byte-wise table, table[k][i] advances table[k - 1][i] by
+// one more zero byte. Constant, so every thread can share them.
+static const mz_uint32 zip_crc32_table[8][256] = {
+    {
+        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+        0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+        0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+        0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+        0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+        0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+        0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+        0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+        0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+        0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+        0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+        0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+        0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+        0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+        0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+        0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+        0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+        0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+        0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+        0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+        0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+        0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+        0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+        0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+        0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+        0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+        0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+        0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+        0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+        0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+        0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+        0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+        0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+        0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+        0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+        0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+        0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+        0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+        0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+        0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+        0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+        0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+        0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+    },
+    {
+        0x00000000, 0x191b3141, 0x32366282, 0x2b2d53c3, 0x646cc504, 0x7d77f445,
+        0x565aa786, 0x4f4196c7, 0xc8d98a08, 0xd1c2bb49, 0xfaefe88a, 0xe3f4d9cb,
+        0xacb54f0c, 0xb5ae7e4d, 0x9e832d8e, 0x87981ccf, 0x4ac21251, 0x53d92310,
+        0x78f470d3, 0x61ef4192, 0x2eaed755, 0x37b5e614, 0x1c98b5d7, 0x05838496,
+        0x821b9859, 0x9b00a918, 0xb02dfadb, 0xa936cb9a, 0xe6775d5d, 0xff6c6c1c,
+        0xd4413fdf, 0xcd5a0e9e, 0x958424a2, 0x8c9f15e3, 0xa7b24620, 0xbea97761,
+        0xf1e8e1a6, 0xe8f3d0e7, 0xc3de8324, 0xdac5b265, 0x5d5daeaa, 0x44469feb,
+        0x6f6bcc28, 0x7670fd69, 0x39316bae, 0x202a5aef, 0x0b07092c, 0x121c386d,
+        0xdf4636f3, 0xc65d07b2, 0xed705471, 0xf46b6530, 0xbb2af3f7, 0xa231c2b6,
+        0x891c9175, 0x9007a034, 0x179fbcfb, 0x0e848dba, 0x25a9de79, 0x3cb2ef38,
+        0x73f379ff, 0x6ae848be, 0x41c51b7d, 0x58de2a3c, 0xf0794f05, 0xe9627e44,
+        0xc24f2d87, 0xdb541cc6, 0x94158a01, 0x8d0ebb40, 0xa623e883, 0xbf38d9c2,
+        0x38a0c50d, 0x21bbf44c, 0x0a96a78f, 0x138d96ce, 0x5ccc0009, 0x45d73148,
+        0x6efa628b, 0x77e153ca, 0xbabb5d54, 0xa3a06c15, 0x888d3fd6, 0x91960e97,
+        0xded79850, 0xc7cca911, 0xece1fad2, 0xf5facb93, 0x7262d75c, 0x6b79e61d,
+        0x4054b5de, 0x594f849f, 0x160e1258, 0x0f152319, 0x243870da, 0x3d23419b,
+        0x65fd6ba7, 0x7ce65ae6, 0x57cb0925, 0x4ed03864, 0x0191aea3, 0x188a9fe2,
+        0x33a7cc21, 0x2abcfd60, 0xad24e1af, 0xb43fd0ee, 0x9f12832d, 0x8609b26c,
+        0xc94824ab, 0xd05315ea, 0xfb7e4629, 0xe2657768, 0x2f3f79f6, 0x362448b7,
+        0x1d091b74, 0x04122a35, 0x4b53bcf2, 0x52488db3, 0x7965de70, 0x607eef31,
+        0xe7e6f3fe, 0xfefdc2bf, 0xd5d0917c, 0xcccba03d, 0x838a36fa, 0x9a9107bb,
+        0xb1bc5478, 0xa8a76539, 0x3b83984b, 0x2298a90a, 0x09b5fac9, 0x10aecb88,
+        0x5fef5d4f, 0x46f46c0e, 0x6dd93fcd, 0x74c20e8c, 0xf35a1243, 0xea412302,
+        0xc16c70c1, 0xd8774180, 0x9736d747, 0x8e2de606, 0xa500b5c5, 0xbc1b8484,
+        0x71418a1a, 0x685abb5b, 0x4377e898, 0x5a6cd9d9, 0x152d4f1e, 0x0c367e5f,
+        0x271b2d9c, 0x3e001cdd, 0xb9980012, 0xa0833153, 0x8bae6290, 0x92b553d1,
+        0xddf4c516, 0xc4eff457, 0xefc2a794, 0xf6d996d5, 0xae07bce9, 0xb71c8da8,
+        0x9c31de6b, 0x852aef2a, 0xca6b79ed, 0xd37048ac, 0xf85d1b6f, 0xe1462a2e,
+        0x66de36e1, 0x7fc507a0, 0x54e85463, 0x4df36522, 0x02b2f3e5, 0x1ba9c2a4,
+        0x30849167, 0x299fa026, 0xe4c5aeb8, 0xfdde9ff9, 0xd6f3cc3a, 0xcfe8fd7b,
+        0x80a96bbc, 0x99b25afd, 0xb29f093e, 0xab84387f, 0x2c1c24b0, 0x350715f1,
+        0x1e2a4632, 0x07317773, 0x4870e1b4, 0x516bd0f5, 0x7a468336, 0x635db277,
+        0xcbfad74e, 0xd2e1e60f, 0xf9ccb5cc, 0xe0d7848d, 0xaf96124a, 0xb68d230b,
+        0x9da070c8, 0x84bb4189, 0x03235d46, 0x1a386c07, 0x31153fc4, 0x280e0e85,
+        0x674f9842, 0x7e54a903, 0x5579fac0, 0x4c62cb81, 0x8138c51f, 0x9823f45e,
+        0xb30ea79d, 0xaa1596dc, 0xe554001b, 0xfc4f315a, 0xd7626299, 0xce7953d8,
+        0x49e14f17, 0x50fa7e56, 0x7bd72d95, 0x62cc1cd4, 0x2d8d8a13, 0x3496bb52,
+        0x1fbbe891, 0x06a0d9d0, 0x5e7ef3ec, 0x4765c2ad, 0x6c48916e, 0x7553a02f,
+        0x3a1236e8, 0x230907a9, 0x0824546a, 0x113f652b, 0x96a779e4, 0x8fbc48a5,
+        0xa4911b66, 0xbd8a2a27, 0xf2cbbce0, 0xebd08da1, 0xc0fdde62, 0xd9e6ef23,
+        0x14bce1bd, 0x0da7d0fc, 0x268a833f, 0x3f91b27e, 0x70d024b9, 0x69cb15f8,
+        0x42e6463b, 0x5bfd777a, 0xdc656bb5, 0xc57e5af4, 0xee530937, 0xf7483876,
+        0xb809aeb1, 0xa1129ff0, 0x8a3fcc33, 0x9324fd72
+    },
+    {
+        0x00000000, 0x01c26a37, 0x0384d46e, 0x0246be59, 0x0709a8dc, 0x06cbc2eb,
+        0x048d7cb2, 0x054f1685, 0x0e1351b8, 0x0fd13b8f, 0x0d9785d6, 0x0c55efe1,
+        0x091af964, 0x08d89353, 0x0a9e2d0a, 0x0b5c473d, 0x1c26a370, 0x1de4c947,
+        0x1fa2771e, 0x1e601d29, 0x1b2f0bac, 0x1aed619b, 0x18abdfc2, 0x1969b5f5,
+        0x1235f2c8, 0x13f798ff, 0x11b126a6, 0x10734c91, 0x153c5a14, 0x14fe3023,
+        0x16b88e7a, 0x177ae44d, 0x384d46e0, 0x398f2cd7, 0x3bc9928e, 0x3a0bf8b9,
+        0x3f44ee3c, 0x3e86840b, 0x3cc03a52, 0x3d025065, 0x365e1758, 0x379c7d6f,
+        0x35dac336, 0x3418a901, 0x3157bf84, 0x3095d5b3, 0x32d36bea, 0x331101dd,
+        0x246be590, 0x25a98fa7, 0x27ef31fe, 0x262d5bc9, 0x23624d4c, 0x22a0277b,
+        0x20e69922, 0x2124f315, 0x2a78b428, 0x2bbade1f, 0x29fc6046, 0x283e0a71,
+        0x2d711cf4, 0x2cb376c3, 0x2ef5c89a, 0x2f37a2ad, 0x709a8dc0, 0x7158e7f7,
+        0x731e59ae, 0x72dc3399, 0x7793251c, 0x76514f2b, 0x7417f172, 0x75d59b45,
+        0x7e89dc78, 0x7f4bb64f, 0x7d0d0816, 0x7ccf6221, 0x798074a4, 0x78421e93,
+        0x7a04a0ca, 0x7bc6cafd, 0x6cbc2eb0, 0x6d7e4487, 0x6f38fade, 0x6efa90e9,
+        0x6bb5866c, 0x6a77ec5b, 0x68315202, 0x69f33835, 0x62af7f08, 0x636d153f,
+        0x612bab66, 0x60e9c151, 0x65a6d7d4, 0x6464bde3, 0x662203ba, 0x67e0698d,
+        0x48d7cb20, 0x4915a117, 0x4b531f4e, 0x4a917579, 0x4fde63fc, 0x4e1c09cb,
+        0x4c5ab792, 0x4d98dda5, 0x46c49a98, 0x4706f0af, 0x45404ef6, 0x448224c1,
+        0x41cd3244, 0x400f5873, 0x4249e62a, 0x438b8c1d, 0x54f16850, 0x55330267,
+        0x5775bc3e, 0x56b7d609, 0x53f8c08c, 0x523aaabb, 0x507c14e2, 0x51be7ed5,
+        0x5ae239e8, 0x5b2053df, 0x5966ed86, 0x58a487b1, 0x5deb9134, 0x5c29fb03,
+        0x5e6f455a, 0x5fad2f6d, 0xe1351b80, 0xe0f771b7, 0xe2b1cfee, 0xe373a5d9,
+        0xe63cb35c, 0xe7fed96b, 0xe5b86732, 0xe47a0d05, 0xef264a38, 0xeee4200f,
+        0xeca29e56, 0xed60f461, 0xe82fe2e4, 0xe9ed88d3, 0xebab368a, 0xea695cbd,
+        0xfd13b8f0, 0xfcd1d2c7, 0xfe976c9e, 0xff5506a9, 0xfa1a102c, 0xfbd87a1b,
+        0xf99ec442, 0xf85cae75, 0xf300e948, 0xf2c2837f, 0xf0843d26, 0xf1465711,
+        0xf4094194, 0xf5cb2ba3, 0xf78d95fa, 0xf64fffcd, 0xd9785d60, 0xd8ba3757,
+        0xdafc890e, 0xdb3ee339, 0xde71f5bc, 0xdfb39f8b, 0xddf521d2, 0xdc374be5,
+        0xd76b0cd8, 0xd6a966ef, 0xd4efd8b6, 0xd52db281, 0xd062a404, 0xd1a0ce33,
+        0xd3e6706a, 0xd2241a5d, 0xc55efe10, 0xc49c9427, 0xc6da2a7e, 0xc7184049,
+        0xc25756cc, 0xc3953cfb, 0xc1d382a2, 0xc011e895, 0xcb4dafa8, 0xca8fc59f,
+        0xc8c97bc6, 0xc90b11f1, 0xcc440774, 0xcd866d43, 0xcfc0d31a, 0xce02b92d,
+        0x91af9640, 0x906dfc77, 0x922b422e, 0x93e92819, 0x96a63e9c, 0x976454ab,
+        0x9522eaf2, 0x94e080c5, 0x9fbcc7f8, 0x9e7eadcf, 0x9c381396, 0x9dfa79a1,
+        0x98b56f24, 0x99770513, 0x9b31bb4a, 0x9af3d17d, 0x8d893530, 0x8c4b5f07,
+        0x8e0de15e, 0x8fcf8b69, 0x8a809dec, 0x8b42f7db, 0x89044982, 0x88c623b5,
+        0x839a6488, 0x82580ebf, 0x801eb0e6, 0x81dcdad1, 0x8493cc54, 0x8551a663,
+        0x8717183a, 0x86d5720d, 0xa9e2d0a0, 0xa820ba97, 0xaa6604ce, 0xaba46ef9,
+        0xaeeb787c, 0xaf29124b, 0xad6fac12, 0xacadc625, 0xa7f18118, 0xa633eb2f,
+        0xa4755576, 0xa5b73f41, 0xa0f829c4, 0xa13a43f3, 0xa37cfdaa, 0xa2be979d,
+        0xb5c473d0, 0xb40619e7, 0xb640a7be, 0xb782cd89, 0xb2cddb0c, 0xb30fb13b,
+        0xb1490f62, 0xb08b6555, 0xbbd72268, 0xba15485f, 0xb853f606, 0xb9919c31,
+        0xbcde8ab4, 0xbd1ce083, 0xbf5a5eda, 0xbe9834ed
+    },
+    {
+        0x00000000, 0xb8bc6765, 0xaa09c88b, 0x12b5afee, 0x8f629757, 0x37def032,
+        0x256b5fdc, 0x9dd738b9, 0xc5b428ef, 0x7d084f8a, 0x6fbde064, 0xd7018701,
+        0x4ad6bfb8, 0xf26ad8dd, 0xe0df7733, 0x58631056, 0x5019579f, 0xe8a530fa,
+        0xfa109f14, 0x42acf871, 0xdf7bc0c8, 0x67c7a7ad, 0x75720843, 0xcdce6f26,
+        0x95ad7f70, 0x2d111815, 0x3fa4b7fb, 0x8718d09e, 0x1acfe827, 0xa2738f42,
+        0xb0c620ac, 0x087a47c9, 0xa032af3e, 0x188ec85b, 0x0a3b67b5, 0xb28700d0,
+        0x2f503869, 0x97ec5f0c, 0x8559f0e2, 0x3de59787, 0x658687d1, 0xdd3ae0b4,
+        0xcf8f4f5a, 0x7733283f, 0xeae41086, 0x525877e3, 0x40edd80d, 0xf851bf68,
+        0xf02bf8a1, 0x48979fc4, 0x5a22302a, 0xe29e574f, 0x7f496ff6, 0xc7f50893,
+        0xd540a77d, 0x6dfcc018, 0x359fd04e, 0x8d23b72b, 0x9f9618c5, 0x272a7fa0,
+        0xbafd4719, 0x0241207c, 0x10f48f92, 0xa848e8f7, 0x9b14583d, 0x23a83f58,
+        0x311d90b6, 0x89a1f7d3, 0x1476cf6a, 0xaccaa80f, 0xbe7f07e1, 0x06c36084,
+        0x5ea070d2, 0xe61c17b7, 0xf4a9b859, 0x4c15df3c, 0xd1c2e785, 0x697e80e0,
+        0x7bcb2f0e, 0xc377486b, 0xcb0d0fa2, 0x73b168c7, 0x6104c729, 0xd9b8a04c,
+        0x446f98f5, 0xfcd3ff90, 0xee66507e, 0x56da371b, 0x0eb9274d, 0xb6054028,
+        0xa4b0efc6, 0x1c0c88a3, 0x81dbb01a, 0x3967d77f, 0x2bd27891, 0x936e1ff4,
+        0x3b26f703, 0x839a9066, 0x912f3f88, 0x299358ed, 0xb4446054, 0x0cf80731,
+        0x1e4da8df, 0xa6f1cfba, 0xfe92dfec, 0x462eb889, 0x549b1767, 0xec277002,
+        0x71f048bb, 0xc94c2fde, 0xdbf98030, 0x6345e755, 0x6b3fa09c, 0xd383c7f9,
+        0xc1366817, 0x798a0f72, 0xe45d37cb, 0x5ce150ae, 0x4e54ff40, 0xf6e89825,
+        0xae8b8873, 0x1637ef16, 0x048240f8, 0xbc3e279d, 0x21e91f24, 0x99557841,
+        0x8be0d7af, 0x335cb0ca, 0xed59b63b, 0x55e5d15e, 0x47507eb0, 0xffec19d5,
+        0x623b216c, 0xda874609, 0xc832e9e7, 0x708e8e82, 0x28ed9ed4, 0x9051f9b1,
+        0x82e4565f, 0x3a58313a, 0xa78f0983, 0x1f336ee6, 0x0d86c108, 0xb53aa66d,
+        0xbd40e1a4, 0x05fc86c1, 0x1749292f, 0xaff54e4a, 0x322276f3, 0x8a9e1196,
+        0x982bbe78, 0x2097d91d, 0x78f4c94b, 0xc048ae2e, 0xd2fd01c0, 0x6a4166a5,
+        0xf7965e1c, 0x4f2a3979, 0x5d9f9697, 0xe523f1f2, 0x4d6b1905, 0xf5d77e60,
+        0xe762d18e, 0x5fdeb6eb, 0xc2098e52, 0x7ab5e937, 0x680046d9, 0xd0bc21bc,
+        0x88df31ea, 0x3063568f, 0x22d6f961, 0x9a6a9e04, 0x07bda6bd, 0xbf01c1d8,
+        0xadb46e36, 0x15080953, 0x1d724e9a, 0xa5ce29ff, 0xb77b8611, 0x0fc7e174,
+        0x9210d9cd, 0x2aacbea8, 0x38191146, 0x80a57623, 0xd8c66675, 0x607a0110,
+        0x72cfaefe, 0xca73c99b, 0x57a4f122, 0xef189647, 0xfdad39a9, 0x45115ecc,
+        0x764dee06, 0xcef18963, 0xdc44268d, 0x64f841e8, 0xf92f7951, 0x41931e34,
+        0x5326b1da, 0xeb9ad6bf, 0xb3f9c6e9, 0x0b45a18c, 0x19f00e62, 0xa14c6907,
+        0x3c9b51be, 0x842736db, 0x96929935, 0x2e2efe50, 0x2654b999, 0x9ee8defc,
+        0x8c5d7112, 0x34e11677, 0xa9362ece, 0x118a49ab, 0x033fe645, 0xbb838120,
+        0xe3e09176, 0x5b5cf613, 0x49e959fd, 0xf1553e98, 0x6c820621, 0xd43e6144,
+        0xc68bceaa, 0x7e37a9cf, 0xd67f4138, 0x6ec3265d, 0x7c7689b3, 0xc4caeed6,
+        0x591dd66f, 0xe1a1b10a, 0xf3141ee4, 0x4ba87981, 0x13cb69d7, 0xab770eb2,
+        0xb9c2a15c, 0x017ec639, 0x9ca9fe80, 0x241599e5, 0x36a0360b, 0x8e1c516e,
+        0x866616a7, 0x3eda71c2, 0x2c6fde2c, 0x94d3b949, 0x090481f0, 0xb1b8e695,
+        0xa30d497b, 0x1bb12e1e, 0x43d23e48, 0xfb6e592d, 0xe9dbf6c3, 0x516791a6,
+        0xccb0a91f, 0x740cce7a, 0x66b96194, 0xde0506f1
+    },
+    {
+        0x00000000, 0x3d6029b0, 0x7ac05360, 0x47a07ad0, 0xf580a6c0, 0xc8e08f70,
+        0x8f40f5a0, 0xb220dc10, 0x30704bc1, 0x0d106271, 0x4ab018a1, 0x77d03111,
+        0xc5f0ed01, 0xf890c4b1, 0xbf30be61, 0x825097d1, 0x60e09782, 0x5d80be32,
+        0x1a20c4e2, 0x2740ed52, 0x95603142, 0xa80018f2, 0xefa06222, 0xd2c04b92,
+        0x5090dc43, 0x6df0f5f3, 0x2a508f23, 0x1730a693, 0xa5107a83, 0x98705333,
+        0xdfd029e3, 0xe2b00053, 0xc1c12f04, 0xfca106b4, 0xbb017c64, 0x866155d4,
+        0x344189c4, 0x0921a074, 0x4e81daa4, 0x73e1f314, 0xf1b164c5, 0xccd14d75,
+        0x8b7137a5, 0xb6111e15, 0x0431c205, 0x3951ebb5, 0x7ef19165, 0x4391b8d5,
+        0xa121b886, 0x9c419136, 0xdbe1ebe6, 0xe681c256, 0x54a11e46, 0x69c137f6,
+        0x2e614d26, 0x13016496, 0x9151f347, 0xac31daf7, 0xeb91a027, 0xd6f18997,
+        0x64d15587, 0x59b17c37, 0x1e1106e7, 0x23712f57, 0x58f35849, 0x659371f9,
+        0x22330b29, 0x1f532299, 0xad73fe89, 0x9013d739, 0xd7b3ade9, 0xead38459,
+        0x68831388, 0x55e33a38, 0x124340e8, 0x2f236958, 0x9d03b548, 0xa0639cf8,
+        0xe7c3e628, 0xdaa3cf98, 0x3813cfcb, 0x0573e67b, 0x42d39cab, 0x7fb3b51b,
+        0xcd93690b, 0xf0f340bb, 0xb7533a6b, 0x8a3313db, 0x0863840a, 0x3503adba,
+        0x72a3d76a, 0x4fc3feda, 0xfde322ca, 0xc0830b7a, 0x872371aa, 0xba43581a,
+        0x9932774d, 0xa4525efd, 0xe3f2242d, 0xde920d9d, 0x6cb2d18d, 0x51d2f83d,
+        0x167282ed, 0x2b12ab5d, 0xa9423c8c, 0x9422153c, 0xd3826fec, 0xeee2465c,
+        0x5cc29a4c, 0x61a2b3fc, 0x2602c92c, 0x1b62e09c, 0xf9d2e0cf, 0xc4b2c97f,
+        0x8312b3af, 0xbe729a1f, 0x0c52460f, 0x31326fbf, 0x7692156f, 0x4bf23cdf,
+        0xc9a2ab0e, 0xf4c282be, 0xb362f86e, 0x8e02d1de, 0x3c220dce, 0x0142247e,
+        0x46e25eae, 0x7b82771e, 0xb1e6b092, 0x8c869922, 0xcb26e3f2, 0xf646ca42,
+        0x44661652, 0x79063fe2, 0x3ea64532, 0x03c66c82, 0x8196fb53, 0xbcf6d2e3,
+        0xfb56a833, 0xc6368183, 0x74165d93, 0x49767423, 0x0ed60ef3, 0x33b62743,
+        0xd1062710, 0xec660ea0, 0xabc67470, 0x96a65dc0, 0x248681d0, 0x19e6a860,
+        0x5e46d2b0, 0x6326fb00, 0xe1766cd1, 0xdc164561, 0x9bb63fb1, 0xa6d61601,
+        0x14f6ca11, 0x2996e3a1, 0x6e369971, 0x5356b0c1, 0x70279f96, 0x4d47b626,
+        0x0ae7ccf6, 0x3787e546, 0x85a73956, 0xb8c710e6, 0xff676a36, 0xc2074386,
+        0x4057d457, 0x7d37fde7, 0x3a978737, 0x07f7ae87, 0xb5d77297, 0x88b75b27,
+        0xcf1721f7, 0xf2770847, 0x10c70814, 0x2da721a4, 0x6a075b74, 0x576772c4,
+        0xe547aed4, 0xd8278764, 0x9f87fdb4, 0xa2e7d404, 0x20b743d5, 0x1dd76a65,
+        0x5a7710b5, 0x67173905, 0xd537e515, 0xe857cca5, 0xaff7b675, 0x92979fc5,
+        0xe915e8db, 0xd475c16b, 0x93d5bbbb, 0xaeb5920b, 0x1c954e1b, 0x21f567ab,
+        0x66551d7b, 0x5b3534cb, 0xd965a31a, 0xe4058aaa, 0xa3a5f07a, 0x9ec5d9ca,
+        0x2ce505da, 0x11852c6a, 0x562556ba, 0x6b457f0a, 0x89f57f59, 0xb49556e9,
+        0xf3352c39, 0xce550589, 0x7c75d999, 0x4115f029, 0x06b58af9, 0x3bd5a349,
+        0xb9853498, 0x84e51d28, 0xc34567f8, 0xfe254e48, 0x4c059258, 0x7165bbe8,
+        0x36c5c138, 0x0ba5e888, 0x28d4c7df, 0x15b4ee6f, 0x521494bf, 0x6f74bd0f,
+        0xdd54611f, 0xe03448af, 0xa794327f, 0x9af41bcf, 0x18a48c1e, 0x25c4a5ae,
+        0x6264df7e, 0x5f04f6ce, 0xed242ade, 0xd044036e, 0x97e479be, 0xaa84500e,
+        0x4834505d, 0x755479ed, 0x32f4033d, 0x0f942a8d, 0xbdb4f69d, 0x80d4df2d,
+        0xc774a5fd, 0xfa148c4d, 0x78441b9c, 0x4524322c, 0x028448fc, 0x3fe4614c,
+        0x8dc4bd5c, 0xb0a494ec, 0xf704ee3c, 0xca64c78c
+    },
+    {
+        0x00000000, 0xcb5cd3a5, 0x4dc8a10b, 0x869472ae, 0x9b914216, 0x50cd91b3,
+        0xd659e31d, 0x1d0530b8, 0xec53826d, 0x270f51c8, 0xa19b2366, 0x6ac7f0c3,
+        0x77c2c07b, 0xbc9e13de, 0x3a0a6170, 0xf156b2d5, 0x03d6029b, 0xc88ad13e,
+        0x4e1ea390, 0x85427035, 0x9847408d, 0x531b9328, 0xd58fe186, 0x1ed33223,
+        0xef8580f6, 0x24d95353, 0xa24d21fd, 0x6911f258, 0x7414c2e0, 0xbf481145,
+        0x39dc63eb, 0xf280b04e, 0x07ac0536, 0xccf0d693, 0x4a64a43d, 0x81387798,
+        0x9c3d4720, 0x57619485, 0xd1f5e62b, 0x1aa9358e, 0xebff875b, 0x20a354fe,
+        0xa6372650, 0x6d6bf5f5, 0x706ec54d, 0xbb3216e8, 0x3da66446, 0xf6fab7e3,
+        0x047a07ad, 0xcf26d408, 0x49b2a6a6, 0x82ee7503, 0x9feb45bb, 0x54b7961e,
+        0xd223e4b0, 0x197f3715, 0xe82985c0, 0x23755665, 0xa5e124cb, 0x6ebdf76e,
+        0x73b8c7d6, 0xb8e41473, 0x3e7066dd, 0xf52cb578, 0x0f580a6c, 0xc404d9c9,
+        0x4290ab67, 0x89cc78c2, 0x94c9487a, 0x5f959bdf, 0xd901e971, 0x125d3ad4,
+        0xe30b8801, 0x28575ba4, 0xaec3290a, 0x659ffaaf, 0x789aca17, 0xb3c619b2,
+        0x35526b1c, 0xfe0eb8b9, 0x0c8e08f7, 0xc7d2db52, 0x4146a9fc, 0x8a1a7a59,
+        0x971f4ae1, 0x5c439944, 0xdad7ebea, 0x118b384f, 0xe0dd8a9a, 0x2b81593f,
+        0xad152b91, 0x6649f834, 0x7b4cc88c, 0xb0101b29, 0x36846987, 0xfdd8ba22,
+        0x08f40f5a, 0xc3a8dcff, 0x453cae51, 0x8e607df4, 0x93654d4c, 0x58399ee9,
+        0xdeadec47, 0x15f13fe2, 0xe4a78d37, 0x2ffb5e92, 0xa96f2c3c, 0x6233ff99,
+        0x7f36cf21, 0xb46a1c84, 0x32fe6e2a, 0xf9a2bd8f, 0x0b220dc1, 0xc07ede64,
+        0x46eaacca, 0x8db67f6f, 0x90b34fd7, 0x5bef9c72, 0xdd7beedc, 0x16273d79,
+        0xe7718fac, 0x2c2d5c09, 0xaab92ea7, 0x61e5fd02, 0x7ce0cdba, 0xb7bc1e1f,
+        0x31286cb1, 0xfa74bf14, 0x1eb014d8, 0xd5ecc77d, 0x5378b5d3, 0x98246676,
+        0x852156ce, 0x4e7d856b, 0xc8e9f7c5, 0x03b52460, 0xf2e396b5, 0x39bf4510,
+        0xbf2b37be, 0x7477e41b, 0x6972d4a3, 0xa22e0706, 0x24ba75a8, 0xefe6a60d,
+        0x1d661643, 0xd63ac5e6, 0x50aeb748, 0x9bf264ed, 0x86f75455, 0x4dab87f0,
+        0xcb3ff55e, 0x006326fb, 0xf135942e, 0x3a69478b, 0xbcfd3525, 0x77a1e680,
+        0x6aa4d638, 0xa1f8059d, 0x276c7733, 0xec30a496, 0x191c11ee, 0xd240c24b,
+        0x54d4b0e5, 0x9f886340, 0x828d53f8, 0x49d1805d, 0xcf45f2f3, 0x04192156,
+        0xf54f9383, 0x3e134026, 0xb8873288, 0x73dbe12d, 0x6eded195, 0xa5820230,
+        0x2316709e, 0xe84aa33b, 0x1aca1375, 0xd196c0d0, 0x5702b27e, 0x9c5e61db,
+        0x815b5163, 0x4a0782c6, 0xcc93f068, 0x07cf23cd, 0xf6999118, 0x3dc542bd,
+        0xbb513013, 0x700de3b6, 0x6d08d30e, 0xa65400ab, 0x20c07205, 0xeb9ca1a0,
+        0x11e81eb4, 0xdab4cd11, 0x5c20bfbf, 0x977c6c1a, 0x8a795ca2, 0x41258f07,
+        0xc7b1fda9, 0x0ced2e0c, 0xfdbb9cd9, 0x36e74f7c, 0xb0733dd2, 0x7b2fee77,
+        0x662adecf, 0xad760d6a, 0x2be27fc4, 0xe0beac61, 0x123e1c2f, 0xd962cf8a,
+        0x5ff6bd24, 0x94aa6e81, 0x89af5e39, 0x42f38d9c, 0xc467ff32, 0x0f3b2c97,
+        0xfe6d9e42, 0x35314de7, 0xb3a53f49, 0x78f9ecec, 0x65fcdc54, 0xaea00ff1,
+        0x28347d5f, 0xe368aefa, 0x16441b82, 0xdd18c827, 0x5b8cba89, 0x90d0692c,
+        0x8dd55994, 0x46898a31, 0xc01df89f, 0x0b412b3a, 0xfa1799ef, 0x314b4a4a,
+        0xb7df38e4, 0x7c83eb41, 0x6186dbf9, 0xaada085c, 0x2c4e7af2, 0xe712a957,
+        0x15921919, 0xdececabc, 0x585ab812, 0x93066bb7, 0x8e035b0f, 0x455f88aa,
+        0xc3cbfa04, 0x089729a1, 0xf9c19b74, 0x329d48d1, 0xb4093a7f, 0x7f55e9da,
+        0x6250d962, 0xa90c0ac7, 0x2f987869, 0xe4c4abcc
+    },
+    {
+        0x00000000, 0xa6770bb4, 0x979f1129, 0x31e81a9d, 0xf44f2413, 0x52382fa7,
+        0x63d0353a, 0xc5a73e8e, 0x33ef4e67, 0x959845d3, 0xa4705f4e, 0x020754fa,
+        0xc7a06a74, 0x61d761c0, 0x503f7b5d, 0xf64870e9, 0x67de9cce, 0xc1a9977a,
+        0xf0418de7, 0x56368653, 0x9391b8dd, 0x35e6b369, 0x040ea9f4, 0xa279a240,
+        0x5431d2a9, 0xf246d91d, 0xc3aec380, 0x65d9c834, 0xa07ef6ba, 0x0609fd0e,
+        0x37e1e793, 0x9196ec27, 0xcfbd399c, 0x69ca3228, 0x582228b5, 0xfe552301,
+        0x3bf21d8f, 0x9d85163b, 0xac6d0ca6, 0x0a1a0712, 0xfc5277fb, 0x5a257c4f,
+        0x6bcd66d2, 0xcdba6d66, 0x081d53e8, 0xae6a585c, 0x9f8242c1, 0x39f54975,
+        0xa863a552, 0x0e14aee6, 0x3ffcb47b, 0x998bbfcf, 0x5c2c8141, 0xfa5b8af5,
+        0xcbb39068, 0x6dc49bdc, 0x9b8ceb35, 0x3dfbe081, 0x0c13fa1c, 0xaa64f1a8,
+        0x6fc3cf26, 0xc9b4c492, 0xf85cde0f, 0x5e2bd5bb, 0x440b7579, 0xe27c7ecd,
+        0xd3946450, 0x75e36fe4, 0xb044516a, 0x16335ade, 0x27db4043, 0x81ac4bf7,
+        0x77e43b1e, 0xd19330aa, 0xe07b2a37, 0x460c2183, 0x83ab1f0d, 0x25dc14b9,
+        0x14340e24, 0xb2430590, 0x23d5e9b7, 0x85a2e203, 0xb44af89e, 0x123df32a,
+        0xd79acda4, 0x71edc610, 0x4005dc8d, 0xe672d739, 0x103aa7d0, 0xb64dac64,
+        0x87a5b6f9, 0x21d2bd4d, 0xe47583c3, 0x42028877, 0x73ea92ea, 0xd59d995e,
+        0x8bb64ce5, 0x2dc14751, 0x1c295dcc, 0xba5e5678, 0x7ff968f6, 0xd98e6342,
+        0xe86679df, 0x4e11726b, 0xb8590282, 0x1e2e0936, 0x2fc613ab, 0x89b1181f,
+        0x4c162691, 0xea612d25, 0xdb8937b8, 0x7dfe3c0c, 0xec68d02b, 0x4a1fdb9f,
+        0x7bf7c102, 0xdd80cab6, 0x1827f438, 0xbe50ff8c, 0x8fb8e511, 0x29cfeea5,
+        0xdf879e4c, 0x79f095f8, 0x48188f65, 0xee6f84d1, 0x2bc8ba5f, 0x8dbfb1eb,
+        0xbc57ab76, 0x1a20a0c2, 0x8816eaf2, 0x2e61e146, 0x1f89fbdb, 0xb9fef06f,
+        0x7c59cee1, 0xda2ec555, 0xebc6dfc8, 0x4db1d47c, 0xbbf9a495, 0x1d8eaf21,
+        0x2c66b5bc, 0x8a11be08, 0x4fb68086, 0xe9c18b32, 0xd82991af, 0x7e5e9a1b,
+        0xefc8763c, 0x49bf7d88, 0x78576715, 0xde206ca1, 0x1b87522f, 0xbdf0599b,
+        0x8c184306, 0x2a6f48b2, 0xdc27385b, 0x7a5033ef, 0x4bb82972, 0xedcf22c6,
+        0x28681c48, 0x8e1f17fc, 0xbff70d61, 0x198006d5, 0x47abd36e, 0xe1dcd8da,
+        0xd034c247, 0x7643c9f3, 0xb3e4f77d, 0x1593fcc9, 0x247be654, 0x820cede0,
+        0x74449d09, 0xd23396bd, 0xe3db8c20, 0x45ac8794, 0x800bb91a, 0x267cb2ae,
+        0x1794a833, 0xb1e3a387, 0x20754fa0, 0x86024414, 0xb7ea5e89, 0x119d553d,
+        0xd43a6bb3, 0x724d6007, 0x43a57a9a, 0xe5d2712e, 0x139a01c7, 0xb5ed0a73,
+        0x840510ee, 0x22721b5a, 0xe7d525d4, 0x41a22e60, 0x704a34fd, 0xd63d3f49,
+        0xcc1d9f8b, 0x6a6a943f, 0x5b828ea2, 0xfdf58516, 0x3852bb98, 0x9e25b02c,
+        0xafcdaab1, 0x09baa105, 0xfff2d1ec, 0x5985da58, 0x686dc0c5, 0xce1acb71,
+        0x0bbdf5ff, 0xadcafe4b, 0x9c22e4d6, 0x3a55ef62, 0xabc30345, 0x0db408f1,
+        0x3c5c126c, 0x9a2b19d8, 0x5f8c2756, 0xf9fb2ce2, 0xc813367f, 0x6e643dcb,
+        0x982c4d22, 0x3e5b4696, 0x0fb35c0b, 0xa9c457bf, 0x6c636931, 0xca146285,
+        0xfbfc7818, 0x5d8b73ac, 0x03a0a617, 0xa5d7ada3, 0x943fb73e, 0x3248bc8a,
+        0xf7ef8204, 0x519889b0, 0x6070932d, 0xc6079899, 0x304fe870, 0x9638e3c4,
+        0xa7d0f959, 0x01a7f2ed, 0xc400cc63, 0x6277c7d7, 0x539fdd4a, 0xf5e8d6fe,
+        0x647e3ad9, 0xc209316d, 0xf3e12bf0, 0x55962044, 0x90311eca, 0x3646157e,
+        0x07ae0fe3, 0xa1d90457, 0x579174be, 0xf1e67f0a, 0xc00e6597, 0x66796e23,
+        0xa3de50ad, 0x05a95b19, 0x34414184, 0x92364a30
+    },
+    {
+        0x00000000, 0xccaa009e, 0x4225077d, 0x8e8f07e3, 0x844a0efa, 0x48e00e64,
+        0xc66f0987, 0x0ac50919, 0xd3e51bb5, 0x1f4f1b2b, 0x91c01cc8, 0x5d6a1c56,
+        0x57af154f, 0x9b0515d1, 0x158a1232, 0xd92012ac, 0x7cbb312b, 0xb01131b5,
+        0x3e9e3656, 0xf23436c8, 0xf8f13fd1, 0x345b3f4f, 0xbad438ac, 0x767e3832,
+        0xaf5e2a9e, 0x63f42a00, 0xed7b2de3, 0x21d12d7d, 0x2b142464, 0xe7be24fa,
+        0x69312319, 0xa59b2387, 0xf9766256, 0x35dc62c8, 0xbb53652b, 0x77f965b5,
+        0x7d3c6cac, 0xb1966c32, 0x3f196bd1, 0xf3b36b4f, 0x2a9379e3, 0xe639797d,
+        0x68b67e9e, 0xa41c7e00, 0xaed97719, 0x62737787, 0xecfc7064, 0x205670fa,
+        0x85cd537d, 0x496753e3, 0xc7e85400, 0x0b42549e, 0x01875d87, 0xcd2d5d19,
+        0x43a25afa, 0x8f085a64, 0x562848c8, 0x9a824856, 0x140d4fb5, 0xd8a74f2b,
+        0xd2624632, 0x1ec846ac, 0x9047414f, 0x5ced41d1, 0x299dc2ed, 0xe537c273,
+        0x6bb8c590, 0xa712c50e, 0xadd7cc17, 0x617dcc89, 0xeff2cb6a, 0x2358cbf4,
+        0xfa78d958, 0x36d2d9c6, 0xb85dde25, 0x74f7debb, 0x7e32d7a2, 0xb298d73c,
+        0x3c17d0df, 0xf0bdd041, 0x5526f3c6, 0x998cf358, 0x1703f4bb, 0xdba9f425,
+        0xd16cfd3c, 0x1dc6fda2, 0x9349fa41, 0x5fe3fadf, 0x86c3e873, 0x4a69e8ed,
+        0xc4e6ef0e, 0x084cef90, 0x0289e689, 0xce23e617, 0x40ace1f4, 0x8c06e16a,
+        0xd0eba0bb, 0x1c41a025, 0x92cea7c6, 0x5e64a758, 0x54a1ae41, 0x980baedf,
+        0x1684a93c, 0xda2ea9a2, 0x030ebb0e, 0xcfa4bb90, 0x412bbc73, 0x8d81bced,
+        0x8744b5f4, 0x4beeb56a, 0xc561b289, 0x09cbb217, 0xac509190, 0x60fa910e,
+        0xee7596ed, 0x22df9673, 0x281a9f6a, 0xe4b09ff4, 0x6a3f9817, 0xa6959889,
+        0x7fb58a25, 0xb31f8abb, 0x3d908d58, 0xf13a8dc6, 0xfbff84df, 0x37558441,
+        0xb9da83a2, 0x7570833c, 0x533b85da, 0x9f918544, 0x111e82a7, 0xddb48239,
+        0xd7718b20, 0x1bdb8bbe, 0x95548c5d, 0x59fe8cc3, 0x80de9e6f, 0x4c749ef1,
+        0xc2fb9912, 0x0e51998c, 0x04949095, 0xc83e900b, 0x46b197e8, 0x8a1b9776,
+        0x2f80b4f1, 0xe32ab46f, 0x6da5b38c, 0xa10fb312, 0xabcaba0b, 0x6760ba95,
+        0xe9efbd76, 0x2545bde8, 0xfc65af44, 0x30cfafda, 0xbe40a839, 0x72eaa8a7,
+        0x782fa1be, 0xb485a120, 0x3a0aa6c3, 0xf6a0a65d, 0xaa4de78c, 0x66e7e712,
+        0xe868e0f1, 0x24c2e06f, 0x2e07e976, 0xe2ade9e8, 0x6c22ee0b, 0xa088ee95,
+        0x79a8fc39, 0xb502fca7, 0x3b8dfb44, 0xf727fbda, 0xfde2f2c3, 0x3148f25d,
+        0xbfc7f5be, 0x736df520, 0xd6f6d6a7, 0x1a5cd639, 0x94d3d1da, 0x5879d144,
+        0x52bcd85d, 0x9e16d8c3, 0x1099df20, 0xdc33dfbe, 0x0513cd12, 0xc9b9cd8c,
+        0x4736ca6f, 0x8b9ccaf1, 0x8159c3e8, 0x4df3c376, 0xc37cc495, 0x0fd6c40b,
+        0x7aa64737, 0xb60c47a9, 0x3883404a, 0xf42940d4, 0xfeec49cd, 0x32464953,
+        0xbcc94eb0, 0x70634e2e, 0xa9435c82, 0x65e95c1c, 0xeb665bff, 0x27cc5b61,
+        0x2d095278, 0xe1a352e6, 0x6f2c5505, 0xa386559b, 0x061d761c, 0xcab77682,
+        0x44387161, 0x889271ff, 0x825778e6, 0x4efd7878, 0xc0727f9b, 0x0cd87f05,
+        0xd5f86da9, 0x19526d37, 0x97dd6ad4, 0x5b776a4a, 0x51b26353, 0x9d1863cd,
+        0x1397642e, 0xdf3d64b0, 0x83d02561, 0x4f7a25ff, 0xc1f5221c, 0x0d5f2282,
+        0x079a2b9b, 0xcb302b05, 0x45bf2ce6, 0x89152c78, 0x50353ed4, 0x9c9f3e4a,
+        0x121039a9, 0xdeba3937, 0xd47f302e, 0x18d530b0, 0x965a3753, 0x5af037cd,
+        0xff6b144a, 0x33c114d4, 0xbd4e1337, 0x71e413a9, 0x7b211ab0, 0xb78b1a2e,
+        0x39041dcd, 0xf5ae1d53, 0x2c8e0fff, 0xe0240f61, 0x6eab0882, 0xa201081c,
+        0xa8c40105, 0x646e019b, 0xeae10678, 0x264b06e6
+    }};
+
+// Slicing by 8 bytes, several times faster than the byte-wise mz_crc32 on
+// the central directory and the entry data it checks.
+unsigned int zip_crc32(unsigned int crc, const void *buf, size_t bufsize) {
+  const mz_uint8 *p = (const mz_uint8 *)buf;
+  mz_uint32 c = ~(mz_uint32)crc, next;
+
+  // a NULL buffer gives 0, like mz_crc32
+  if (!p) {
+    return 0;
+  }
+  for (; bufsize >= 8; p += 8, bufsize -= 8) {
+    c ^= MZ_READ_LE32(p);
+    next = MZ_READ_LE32(p + 4);
+    c = zip_crc32_table[7][c & 0xFF] ^ zip_crc32_table[6][(c >> 8) & 0xFF] ^
+        zip_crc32_table[5][(c >> 16) & 0xFF] ^ zip_crc32_table[4][c >> 24] ^
+        zip_crc32_table[3][next & 0xFF] ^
+        zip_crc32_table[2][(next >> 8) & 0xFF] ^
+        zip_crc32_table[1][(next >> 16) & 0xFF] ^
+        zip_crc32_table[0][next >> 24];
+  }
+  for (; bufsize; ++p, --bufsize) {
+    c = (c >> 8) ^ zip_crc32_table[0][(c ^ *p) & 0xFF];
+  }
+  return (unsigned int)~c;
+}
+
+void *zip_deflate_mem(const void *buf, size_t bufsize, int level,
+                      size_t *outsize) {
+  if (!outsize || (!buf && bufsize) || level > MZ_UBER_COMPRESSION) {
+    return NULL;
+  }
+  if (level < 0) {
+    level = MZ_DEFAULT_LEVEL;
+  }
+  return tdefl_compress_mem_to_heap(
+      buf, bufsize, outsize,
+      (int)tdefl_create_comp_flags_from_zip_params(level, -15,
+                                                   MZ_DEFAULT_STRATEGY));
+}
+
+unsigned long long zip_entry_dir_offset(struct zip_t *zip) {
+  return zip ? zip->entry.dir_offset : 0;
+}
+
+unsigned long long zip_entry_header_offset(struct zip_t *zip) {
+  return zip ? zip->entry.header_offset : 0;
+}
+
+int zip_entry_rawoffset(struct zip_t *zip, unsigned long long *offset) {
+  mz_zip_archive *pzip = NULL;
+  const mz_uint8 *pHeader = NULL;
+  mz_uint64 data_offset = 0;
+  int err;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!offset) {
+    return ZIP_EINVAL;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return ZIP_ENOENT;
+  }
+
+  pHeader = zip_central_dir_header(pzip, (mz_uint)zip->entry.index);
+  if (!pHeader) {
+    return ZIP_ENOHDR;
+  }
+  if (zip->entry.method != 0 ||
+      !zip_reader_supported(MZ_READ_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS),
+                            zip->entry.method)) {
+    // only plain stored data can be copied as is
+    return ZIP_EINVENTTYPE;
+  }
+
+  err = zip_local_data_offset(pzip->m_pRead, pzip->m_pIO_opaque,
+                              pzip->m_archive_size, zip->entry.header_offset,
+                              zip->entry.comp_size, &data_offset);
+  if (err < 0) {
+    return err;
+  }
+  if (pzip->m_pState->m_pFile) {
+    data_offset += pzip->m_pState->m_file_archive_start_ofs;
+  }
+  *offset = data_offset;
+  return 0;
+}
+
+int zip_entry_set_mtime(struct zip_t *zip, long long mtime) {
+  mz_zip_archive *pzip = NULL;
+  mz_uint16 dos_time = 0, dos_date = 0;
+  mz_uint8 field[4];
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING || !zip->entry.name) {
+    return ZIP_EINVMODE;
+  }
+  zip->entry.m_time = (time_t)mtime;
+#ifndef MINIZ_NO_TIME
+  mz_zip_time_t_to_dos_time(zip->entry.m_time, &dos_time, &dos_date);
+#endif
+  // keep the local header in sync, the central directory record is written
+  // by zip_entry_close
+  MZ_WRITE_LE16(field, dos_time);
+  MZ_WRITE_LE16(field + 2, dos_date);
+  if (pzip->m_pWrite(pzip->m_pIO_opaque,
+                     zip->entry.header_offset + MZ_ZIP_LDH_FILE_TIME_OFS, field,
+                     sizeof(field)) != sizeof(field)) {
+    return ZIP_EWRTHDR;
+  }
+  return 0;
+}
+
+void zip_entry_set_unix_permissions(struct zip_t *zip, unsigned int mode, int is_dir) {
+  if (!zip) {
+    return;
+  }
+  mz_uint32 perm = (mz_uint32)(mode & 0x0FFF);
+  mz_uint32 type = is_dir ? UNX_IFDIR : UNX_IFREG;
+  zip->entry.external_attr = ((type | perm) << 16);
+  if (is_dir) {
+    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+  }
+}
+
+int zip_entry_write(struct zip_t *zip, const void *buf, size_t bufsize) {
+  mz_uint level;
+  mz_zip_archive *pzip = NULL;
+  tdefl_status status;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (zip->entry.raw) {
+    // already holds data written by zip_entry_rawwrite
+    return ZIP_EINVMODE;
+  }
+  if (buf && bufsize > 0) {
+    zip->entry.uncomp_size += bufsize;
+    zip->entry.uncomp_crc32 =
+        (mz_uint32)zip_crc32(zip->entry.uncomp_crc32, buf, bufsize);
+
+    level = zip->level & 0xF;
+    if (!level) {
+      if ((pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, buf,
+                          bufsize) != bufsize)) {
+        // Cannot write buffer
+        return ZIP_EWRTENT;
+      }
+      zip->entry.dir_offset += bufsize;
+      zip->entry.comp_size += bufsize;
+    } else {
+      status = tdefl_compress_buffer(zip->entry.comp, buf, bufsize,
+                                     TDEFL_NO_FLUSH);
+      if (status != TDEFL_STATUS_DONE && status != TDEFL_STATUS_OKAY) {
+        // Cannot compress buffer
+        return ZIP_ETDEFLBUF;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int zip_entry_rawwrite(struct zip_t *zip, const void *buf, size_t bufsize,
+                       int method, unsigned long long uncomp_size,
+                       unsigned int crc32) {
+  mz_zip_archive *pzip = NULL;
+  mz_uint8 method_field[2];
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING || !zip->entry.name) {
+    return ZIP_EINVMODE;
+  }
+  if (method != 0 && method != MZ_DEFLATED) {
+    return ZIP_EINVENTTYPE;
+  }
+  if (!zip->entry.raw) {
+    if (zip->entry.uncomp_size) {
+      // already holds data written by zip_entry_write
+      return ZIP_EINVMODE;
+    }
+    zip->entry.raw = MZ_TRUE;
+  }
+  if (zip->entry.method != (mz_uint16)method) {
+    // the local header was written by zip_entry_open with the archive level
+    MZ_WRITE_LE16(method_field, method);
+    if (pzip->m_pWrite(pzip->m_pIO_opaque,
+                       zip->entry.header_offset + MZ_ZIP_LDH_METHOD_OFS,
+                       method_field,
+                       sizeof(method_field)) != sizeof(method_field)) {
+      return ZIP_EWRTHDR;
+    }
+    zip->entry.method = (mz_uint16)method;
+  }
+
+  if (buf && bufsize > 0) {
+    if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, buf,
+                       bufsize) != bufsize) {
+      // Cannot write buffer
+      return ZIP_EWRTENT;
+    }
+    zip->entry.dir_offset += bufsize;
+    zip->entry.comp_size += bufsize;
+  }
+  zip->entry.uncomp_size = uncomp_size;
+  zip->entry.uncomp_crc32 = crc32;
+  return 0;
+}
+
+int zip_entry_fwrite(struct zip_t *zip, const char *filename) {
+  int err = 0;
+  size_t n = 0;
+  MZ_FILE *stream = NULL;
+  mz_uint8 buf[MZ_ZIP_MAX_IO_BUF_SIZE];
+  struct MZ_FILE_STAT_STRUCT file_stat;
+  mz_uint16 modes;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+
+  memset(buf, 0, MZ_ZIP_MAX_IO_BUF_SIZE);
+  memset((void *)&file_stat, 0, sizeof(struct MZ_FILE_STAT_STRUCT));
+  if (MZ_FILE_STAT(filename, &file_stat) != 0) {
+    // problem getting information - check errno
+    return ZIP_ENOENT;
+  }
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(DJGPP)
+  (void)modes; // unused
+#else
+  /* Initialize with permission bits--which are not implementation-optional */
+  modes = file_stat.st_mode &
+          (S_IRWXU | S_IRWXG | S_IRWXO | S_ISUID | S_ISGID | S_ISVTX);
+  if (S_ISDIR(file_stat.st_mode))
+    modes |= UNX_IFDIR;
+  if (S_ISREG(file_stat.st_mode))
+    modes |= UNX_IFREG;
+  if (S_ISLNK(file_stat.st_mode))
+    modes |= UNX_IFLNK;
+  if (S_ISBLK(file_stat.st_mode))
+    modes |= UNX_IFBLK;
+  if (S_ISCHR(file_stat.st_mode))
+    modes |= UNX_IFCHR;
+  if (S_ISFIFO(file_stat.st_mode))
+    modes |= UNX_IFIFO;
+  if (S_ISSOCK(file_stat.st_mode))
+    modes |= UNX_IFSOCK;
+  zip->entry.external_attr = (modes << 16) | !(file_stat.st_mode & S_IWUSR);
+  if ((file_stat.st_mode & S_IFMT) == S_IFDIR) {
+    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+  }
+#endif
+
+  zip->entry.m_time = file_stat.st_mtime;
+
+  if (!(stream = MZ_FOPEN(filename, "rb"))) {
+    // Cannot open filename
+    return ZIP_EOPNFILE;
+  }
+
+  while ((n = fread(buf, sizeof(mz_uint8), MZ_ZIP_MAX_IO_BUF_SIZE, stream)) >
+         0) {
+    if (zip_entry_write(zip, buf, n) < 0) {
+      err = ZIP_EWRTENT;
+      break;
+    }
+  }
+  fclose(stream);
+
+  return err;
+}
+
+ssize_t zip_entry_read(struct zip_t *zip, void **buf, size_t *bufsize) {
+  mz_zip_archive *pzip = NULL;
+  mz_uint idx;
+  size_t size = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return (ssize_t)ZIP_ENOENT;
+  }
+
+  idx = (mz_uint)zip->entry.index;
+  if (mz_zip_reader_is_file_a_directory(pzip, idx)) {
+    // the entry is a directory
+    return (ssize_t)ZIP_EINVENTTYPE;
+  }
+
+  *buf = mz_zip_reader_extract_to_heap(pzip, idx, &size, 0);
+  if (*buf && bufsize) {
+    *bufsize = size;
+  }
+  return (ssize_t)size;
+}
+
+ssize_t zip_entry_noallocread(struct zip_t *zip, void *buf, size_t bufsize) {
+  mz_zip_archive *pzip = NULL;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return (ssize_t)ZIP_ENOENT;
+  }
+
+  if (!mz_zip_reader_extract_to_mem_no_alloc(pzip, (mz_uint)zip->entry.index,
+                                             buf, bufsize, 0, NULL, 0)) {
+    return (ssize_t)ZIP_EMEMNOALLOC;
+  }
+
+  return (ssize_t)zip->entry.uncomp_size;
+}
+
+ssize_t zip_entry_noallocreadwithoffset(struct zip_t *zip, size_t offset,
+                                        size_t size, void *buf) {
+  mz_zip_archive *pzip = NULL;
+  const mz_uint8 *pHeader = NULL;
+  struct zip_inflate_t *inf = NULL;
+  const struct zip_seek_point_t *point = NULL;
+  mz_uint64 data_offset = 0;
+  mz_uint8 *writebuf = (mz_uint8 *)buf;
+  size_t write_cursor = 0;
+  ssize_t n = 0;
+  int err = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return (ssize_t)ZIP_ENOINIT;
+  }
+
+  if (offset >= (size_t)zip->entry.uncomp_size) {
+    return (ssize_t)ZIP_EINVAL;
+  }
+
+  if ((offset + size) > (size_t)zip->entry.uncomp_size) {
+    size = (ssize_t)zip->entry.uncomp_size - offset;
+  }
+
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return (ssize_t)ZIP_ENOENT;
+  }
+
+  pHeader = zip_central_dir_header(pzip, (mz_uint)zip->entry.index);
+  if (!pHeader) {
+    return (ssize_t)ZIP_ENOHDR;
+  }
+  if (MZ_READ_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS) &
+      (MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_IS_ENCRYPTED |
+       MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_USES_STRONG_ENCRYPTION |
+       MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_COMPRESSED_PATCH_FLAG)) {
+    return (ssize_t)ZIP_ENORITER;
+  }
+  if (zip->entry.method != 0 && zip->entry.method != MZ_DEFLATED) {
+    return (ssize_t)ZIP_ENORITER;
+  }
+
+  err = zip_local_data_offset(pzip->m_pRead, pzip->m_pIO_opaque,
+                              pzip->m_archive_size, zip->entry.header_offset,
+                              zip->entry.comp_size, &data_offset);
+  if (err < 0) {
+    return (ssize_t)err;
+  }
+
+  if (!zip->entry.method) {
+    // stored data can be read in place
+    if (pzip->m_pRead(pzip->m_pIO_opaque, data_offset + offset, buf, size) !=
+        size) {
+      return (ssize_t)ZIP_EFREAD;
     }
-    // The file pointer is now owned by the archive object.
-    zip->archive.m_zip_type = MZ_ZIP_TYPE_FILE;
-  } break;
+    return (ssize_t)size;
+  }
 
-  default:
-    *errnum = ZIP_EINVMODE;
-    goto cleanup;
+  inf = (struct zip_inflate_t *)malloc(sizeof(struct zip_inflate_t));
+  if (!inf) {
+    return (ssize_t)ZIP_EOOMEM;
   }
+  zip_inflate_init(inf, pzip->m_pRead, pzip->m_pIO_opaque, data_offset,
+                   zip->entry.comp_size, zip->entry.uncomp_size);
 
-  return zip;
+  // resume from the nearest checkpoint instead of the start of the entry
+  point = zip_seek_index_lookup(
+      zip_seek_index_find(zip->seek_index, (mz_uint32)zip->entry.index),
+      offset);
+  if (point) {
+    zip_inflate_restore(inf, point);
+  }
 
-cleanup:
-  CLEANUP(zip);
-  return NULL;
-}
+  while (write_cursor < size) {
+    const mz_uint8 *out = NULL;
+    mz_uint64 chunk_ofs;
+    size_t skip, read_size;
 
-void zip_close(struct zip_t *zip) {
-  if (zip) {
-    mz_zip_archive *pZip = &(zip->archive);
-    // Always finalize, even if adding failed for some reason, so we have a
-    // valid central directory.
-    if (pZip->m_zip_mode == MZ_ZIP_MODE_WRITING) {
-      mz_zip_writer_finalize_archive(pZip);
+    n = zip_inflate_next(inf, &out);
+    if (n <= 0) {
+      break;
     }
 
-    if (pZip->m_zip_mode == MZ_ZIP_MODE_WRITING ||
-        pZip->m_zip_mode == MZ_ZIP_MODE_WRITING_HAS_BEEN_FINALIZED) {
-      zip_archive_truncate(pZip);
-      mz_zip_writer_end(pZip);
+    if (inf->out_ofs <= offset) {
+      continue;
     }
-    if (pZip->m_zip_mode == MZ_ZIP_MODE_READING) {
-      mz_zip_reader_end(pZip);
+    chunk_ofs = inf->out_ofs - (mz_uint64)n;
+    skip = (offset > chunk_ofs) ? (size_t)(offset - chunk_ofs) : 0;
+    read_size = (size_t)n - skip;
+    if (read_size > size - write_cursor) {
+      read_size = size - write_cursor;
     }
 
-    CLEANUP(zip);
+    memcpy(&writebuf[write_cursor], out + skip, read_size);
+    write_cursor += read_size;
+    offset += read_size;
   }
+
+  CLEANUP(inf);
+  return (n < 0) ? n : (ssize_t)write_cursor;
 }
 
-int zip_is64(struct zip_t *zip) {
-  if (!zip || !zip->archive.m_pState) {
-    // zip_t handler or zip state is not initialized
+int zip_entry_seekindex(struct zip_t *zip, size_t span) {
+  mz_zip_archive *pzip = NULL;
+  struct zip_inflate_t *inf = NULL;
+  struct zip_seek_index_t *seek_index = NULL;
+  mz_uint64 data_offset = 0, next_point;
+  ssize_t n = 0;
+  int err = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
     return ZIP_ENOINIT;
   }
 
-  return (int)zip->archive.m_pState->m_zip64;
-}
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return ZIP_ENOENT;
+  }
 
-int zip_offset(struct zip_t *zip, uint64_t *offset) {
-  if (!zip || !zip->archive.m_pState) {
-    // zip_t handler or zip state is not initialized
-    return ZIP_ENOINIT;
+  if (mz_zip_reader_is_file_a_directory(pzip, (mz_uint)zip->entry.index)) {
+    // the entry is a directory
+    return ZIP_EINVENTTYPE;
   }
 
-  *offset = mz_zip_get_archive_file_start_offset(&zip->archive);
-  return 0;
+  if (zip->entry.method != MZ_DEFLATED) {
+    // stored entries are read in place, nothing to index
+    return 0;
+  }
+
+  if (!span) {
+    span = ZIP_DEFAULT_SEEK_SPAN;
+  }
+
+  err = zip_local_data_offset(pzip->m_pRead, pzip->m_pIO_opaque,
+                              pzip->m_archive_size, zip->entry.header_offset,
+                              zip->entry.comp_size, &data_offset);
+  if (err < 0) {
+    return err;
+  }
+
+  seek_index =
+      (struct zip_seek_index_t *)calloc(1, sizeof(struct zip_seek_index_t));
+  inf = (struct zip_inflate_t *)malloc(sizeof(struct zip_inflate_t));
+  if (!seek_index || !inf) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+
+  seek_index->index = (mz_uint32)zip->entry.index;
+  seek_index->header_offset = zip->entry.header_offset;
+  seek_index->comp_size = zip->entry.comp_size;
+  seek_index->uncomp_size = zip->entry.uncomp_size;
+  seek_index->uncomp_crc32 = zip->entry.uncomp_crc32;
+  seek_index->span = span;
+
+  zip_inflate_init(inf, pzip->m_pRead, pzip->m_pIO_opaque, data_offset,
+                   zip->entry.comp_size, zip->entry.uncomp_size);
+  next_point = span;
+  for (;;) {
+    const mz_uint8 *out = NULL;
+    n = zip_inflate_next(inf, &out);
+    if (n <= 0) {
+      break;
+    }
+    if (inf->out_ofs >= next_point && inf->out_ofs < inf->uncomp_size) {
+      if ((err = zip_seek_index_push(seek_index, inf)) < 0) {
+        goto cleanup;
+      }
+      next_point = inf->out_ofs + span;
+    }
+  }
+  if (n < 0) {
+    err = (int)n;
+    goto cleanup;
+  }
+
+  zip_seek_index_insert(zip, seek_index);
+  seek_index = NULL;
+
+cleanup:
+  zip_seek_index_free(seek_index);
+  CLEANUP(inf);
+  return err;
 }
 
-static int _zip_entry_open(struct zip_t *zip, const char *entryname,
-                           int case_sensitive) {
-  size_t entrylen = 0;
-  mz_zip_archive *pzip = NULL;
-  mz_uint num_alignment_padding_bytes, level;
-  mz_zip_archive_file_stat stats;
+#define ZIP_SEEK_INDEX_MAGIC 0x5849535a // "ZSIX"
+#define ZIP_SEEK_INDEX_VERSION 2
+#define ZIP_SEEK_INDEX_LAYOUT_SIZE 28
+
+// The inflate state is dumped as-is, so the sidecar records everything its
+// meaning depends on: the miniz version (its state machine), the size of the
+// state and of the bit buffer, and the byte order.
+static void zip_seek_index_layout(mz_uint8 *layout) {
+  const mz_uint32 probe = 0x01020304;
+
+  memset(layout, 0, ZIP_SEEK_INDEX_LAYOUT_SIZE);
+  strncpy((char *)layout, MZ_VERSION, 16);
+  MZ_WRITE_LE32(layout + 16, (mz_uint32)sizeof(tinfl_decompressor));
+  MZ_WRITE_LE32(layout + 20, (mz_uint32)sizeof(tinfl_bit_buf_t));
+  memcpy(layout + 24, &probe, sizeof(probe));
+}
+
+// CRC-32 of a checkpoint, seeded with the entry it belongs to so a point can
+// not be moved to another entry or position unnoticed.
+static mz_uint32 zip_seek_point_crc32(const struct zip_seek_index_t *seek_index,
+                                      const struct zip_seek_point_t *point) {
+  mz_uint8 fields[36];
+  mz_uint32 crc;
+
+  MZ_WRITE_LE32(fields, seek_index->index);
+  MZ_WRITE_LE64(fields + 4, seek_index->header_offset);
+  MZ_WRITE_LE32(fields + 12, seek_index->uncomp_crc32);
+  MZ_WRITE_LE64(fields + 16, point->out_ofs);
+  MZ_WRITE_LE64(fields + 24, point->comp_ofs);
+  MZ_WRITE_LE32(fields + 32, point->dict_ofs);
+  crc = zip_crc32(0, fields, sizeof(fields));
+  crc = zip_crc32(crc, &point->inflator, sizeof(tinfl_decompressor));
+  return zip_crc32(crc, point->dict, TINFL_LZ_DICT_SIZE);
+}
+
+// Range checks on the restored state, on top of the checksum: counts and
+// sizes tinfl uses as shifts or table bounds must be possible values.
+static int zip_seek_point_valid(const struct zip_seek_point_t *point) {
+  const tinfl_decompressor *r = &point->inflator;
+  const mz_uint32 bits = 8 * (mz_uint32)sizeof(tinfl_bit_buf_t);
+
+  // m_type also counts the Huffman tables down to -1 while they are built
+  return r->m_num_bits < bits && !(r->m_bit_buf >> r->m_num_bits) &&
+         (r->m_type <= 2 || r->m_type == (mz_uint32)-1) &&
+         r->m_num_extra <= 13 &&
+         r->m_dist <= TINFL_LZ_DICT_SIZE &&
+         r->m_table_sizes[0] <= TINFL_MAX_HUFF_SYMBOLS_0 &&
+         r->m_table_sizes[1] <= TINFL_MAX_HUFF_SYMBOLS_1 &&
+         r->m_table_sizes[2] <= TINFL_MAX_HUFF_SYMBOLS_2;
+}
+
+int zip_seekindex_save(struct zip_t *zip, const char *filename) {
+  MZ_FILE *fp = NULL;
+  struct zip_seek_index_t *it = NULL;
+  mz_uint8 layout[ZIP_SEEK_INDEX_LAYOUT_SIZE];
+  mz_uint64 count = 0;
+  size_t i;
   int err = 0;
-  mz_uint16 dos_time = 0, dos_date = 0;
-  mz_uint32 extra_size = 0;
-  mz_uint8 extra_data[MZ_ZIP64_MAX_CENTRAL_EXTRA_FIELD_SIZE];
-  mz_uint64 local_dir_header_ofs = 0;
 
   if (!zip) {
+    // zip_t handler is not initialized
     return ZIP_ENOINIT;
   }
-
-  local_dir_header_ofs = zip->archive.m_archive_size;
-
-  if (!entryname) {
-    return ZIP_EINVENTNAME;
+  if (!filename) {
+    return ZIP_EINVAL;
   }
 
-  entrylen = strlen(entryname);
-  if (entrylen == 0) {
-    return ZIP_EINVENTNAME;
+  for (it = zip->seek_index; it; it = it->next) {
+    count++;
   }
 
-  if (zip->entry.name) {
-    CLEANUP(zip->entry.name);
+  if (!(fp = MZ_FOPEN(filename, "wb"))) {
+    return ZIP_EOPNFILE;
   }
 
-  pzip = &(zip->archive);
-  if (pzip->m_zip_mode == MZ_ZIP_MODE_READING) {
-    zip->entry.name = zip_strclone(entryname, entrylen);
-    if (!zip->entry.name) {
-      // Cannot parse zip entry name
-      return ZIP_EINVENTNAME;
-    }
+  zip_seek_index_layout(layout);
+  if ((err = zip_file_write_le(fp, ZIP_SEEK_INDEX_MAGIC, 4)) < 0 ||
+      (err = zip_file_write_le(fp, ZIP_SEEK_INDEX_VERSION, 4)) < 0) {
+    goto cleanup;
+  }
+  if (fwrite(layout, 1, ZIP_SEEK_INDEX_LAYOUT_SIZE, fp) !=
+      ZIP_SEEK_INDEX_LAYOUT_SIZE) {
+    err = ZIP_EFWRITE;
+    goto cleanup;
+  }
+  if ((err = zip_file_write_le(fp, count, 4)) < 0) {
+    goto cleanup;
+  }
 
-    zip->entry.index = (ssize_t)mz_zip_reader_locate_file(
-        pzip, zip->entry.name, NULL,
-        case_sensitive ? MZ_ZIP_FLAG_CASE_SENSITIVE : 0);
-    if (zip->entry.index < (ssize_t)0) {
-      err = ZIP_ENOENT;
+  for (it = zip->seek_index; it; it = it->next) {
+    if ((err = zip_file_write_le(fp, it->index, 4)) < 0 ||
+        (err = zip_file_write_le(fp, it->header_offset, 8)) < 0 ||
+        (err = zip_file_write_le(fp, it->comp_size, 8)) < 0 ||
+        (err = zip_file_write_le(fp, it->uncomp_size, 8)) < 0 ||
+        (err = zip_file_write_le(fp, it->uncomp_crc32, 4)) < 0 ||
+        (err = zip_file_write_le(fp, it->span, 8)) < 0 ||
+        (err = zip_file_write_le(fp, it->num_points, 8)) < 0) {
       goto cleanup;
     }
-
-    if (!mz_zip_reader_file_stat(pzip, (mz_uint)zip->entry.index, &stats)) {
-      err = ZIP_ENOENT;
-      goto cleanup;
+    for (i = 0; i < it->num_points; ++i) {
+      const struct zip_seek_point_t *point = &it->points[i];
+      if ((err = zip_file_write_le(fp, point->out_ofs, 8)) < 0 ||
+          (err = zip_file_write_le(fp, point->comp_ofs, 8)) < 0 ||
+          (err = zip_file_write_le(fp, point->dict_ofs, 4)) < 0) {
+        goto cleanup;
+      }
+      // the inflator state is dumped as-is, the header records its layout
+      if (fwrite(&point->inflator, 1, sizeof(tinfl_decompressor), fp) !=
+              sizeof(tinfl_decompressor) ||
+          fwrite(point->dict, 1, TINFL_LZ_DICT_SIZE, fp) !=
+              TINFL_LZ_DICT_SIZE) {
+        err = ZIP_EFWRITE;
+        goto cleanup;
+      }
+      if ((err = zip_file_write_le(fp, zip_seek_point_crc32(it, point), 4)) <
+          0) {
+        goto cleanup;
+      }
     }
+  }
 
-    zip->entry.comp_size = stats.m_comp_size;
-    zip->entry.uncomp_size = stats.m_uncomp_size;
-    zip->entry.uncomp_crc32 = stats.m_crc32;
-    zip->entry.dir_offset = stats.m_central_dir_ofs;
-    zip->entry.header_offset = stats.m_local_header_ofs;
-    zip->entry.method = stats.m_method;
-    zip->entry.external_attr = stats.m_external_attr;
-#ifndef MINIZ_NO_TIME
-    zip->entry.m_time = stats.m_time;
-#endif
+cleanup:
+  if (fclose(fp) != 0 && !err) {
+    err = ZIP_EFWRITE;
+  }
+  return err;
+}
 
-    return 0;
+static int zip_seek_index_read(MZ_FILE *fp, mz_zip_archive *pzip,
+                               struct zip_seek_index_t *seek_index) {
+  mz_uint64 value = 0, prev_ofs = 0;
+  size_t i;
+  int err = 0;
+
+  if ((err = zip_file_read_le(fp, &value, 4)) < 0) {
+    return err;
+  }
+  seek_index->index = (mz_uint32)value;
+  if ((err = zip_file_read_le(fp, &seek_index->header_offset, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &seek_index->comp_size, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &seek_index->uncomp_size, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &value, 4)) < 0) {
+    return err;
+  }
+  seek_index->uncomp_crc32 = (mz_uint32)value;
+  if ((err = zip_file_read_le(fp, &seek_index->span, 8)) < 0 ||
+      (err = zip_file_read_le(fp, &value, 8)) < 0) {
+    return err;
   }
 
-  /*
-    .ZIP File Format Specification Version: 6.3.3
+  // the index must describe the entry as it is in this archive
+  if (!zip_seek_index_matches(pzip, seek_index) || !seek_index->span ||
+      value > seek_index->uncomp_size / seek_index->span + 1) {
+    return ZIP_EINVIDXFILE;
+  }
 
-    4.4.17.1 The name of the file, with optional relative path.
-    The path stored MUST not contain a drive or
-    device letter, or a leading slash.  All slashes
-    MUST be forward slashes '/' as opposed to
-    backwards slashes '\' for compatibility with Amiga
-    and UNIX file systems etc.  If input came from standard
-    input, there is no file name field.
-  */
-  zip->entry.name = zip_strrpl(entryname, entrylen, '\\', '/');
-  if (!zip->entry.name) {
-    // Cannot parse zip entry name
-    return ZIP_EINVENTNAME;
+  if (value) {
+    seek_index->points = (struct zip_seek_point_t *)calloc(
+        (size_t)value, sizeof(struct zip_seek_point_t));
+    if (!seek_index->points) {
+      return ZIP_EOOMEM;
+    }
+    seek_index->capacity = (size_t)value;
   }
 
-  level = zip->level & 0xF;
+  for (i = 0; i < (size_t)value; ++i) {
+    struct zip_seek_point_t *point = &seek_index->points[i];
+    mz_uint64 dict_ofs = 0, crc32 = 0;
+    if ((err = zip_file_read_le(fp, &point->out_ofs, 8)) < 0 ||
+        (err = zip_file_read_le(fp, &point->comp_ofs, 8)) < 0 ||
+        (err = zip_file_read_le(fp, &dict_ofs, 4)) < 0) {
+      return err;
+    }
+    if (fread(&point->inflator, 1, sizeof(tinfl_decompressor), fp) !=
+            sizeof(tinfl_decompressor) ||
+        fread(point->dict, 1, TINFL_LZ_DICT_SIZE, fp) != TINFL_LZ_DICT_SIZE) {
+      return ZIP_EINVIDXFILE;
+    }
+    if ((err = zip_file_read_le(fp, &crc32, 4)) < 0) {
+      return err;
+    }
+    if (point->out_ofs <= prev_ofs ||
+        point->out_ofs >= seek_index->uncomp_size ||
+        point->comp_ofs > seek_index->comp_size ||
+        dict_ofs >= TINFL_LZ_DICT_SIZE) {
+      return ZIP_EINVIDXFILE;
+    }
+    point->dict_ofs = (mz_uint32)dict_ofs;
+    // nothing read from the file reaches tinfl before it verifies
+    if (crc32 != zip_seek_point_crc32(seek_index, point) ||
+        !zip_seek_point_valid(point)) {
+      return ZIP_EINVIDXFILE;
+    }
+    prev_ofs = point->out_ofs;
+    seek_index->num_points++;
+  }
+  return 0;
+}
 
-  zip->entry.index = (ssize_t)zip->archive.m_total_files;
-  zip->entry.comp_size = 0;
-  zip->entry.uncomp_size = 0;
-  zip->entry.uncomp_crc32 = MZ_CRC32_INIT;
-  zip->entry.dir_offset = zip->archive.m_archive_size;
-  zip->entry.header_offset = zip->archive.m_archive_size;
-  memset(zip->entry.header, 0, MZ_ZIP_LOCAL_DIR_HEADER_SIZE * sizeof(mz_uint8));
-  zip->entry.method = level ? MZ_DEFLATED : 0;
+int zip_seekindex_load(struct zip_t *zip, const char *filename) {
+  MZ_FILE *fp = NULL;
+  struct zip_seek_index_t *loaded = NULL;
+  mz_uint8 layout[ZIP_SEEK_INDEX_LAYOUT_SIZE];
+  mz_uint8 expected[ZIP_SEEK_INDEX_LAYOUT_SIZE];
+  mz_uint64 magic = 0, version = 0, count = 0, i;
+  int err = 0;
 
-  // UNIX or APPLE
-#if MZ_PLATFORM == 3 || MZ_PLATFORM == 19
-  // regular file with rw-r--r-- permissions
-  zip->entry.external_attr = (mz_uint32)(0100644) << 16;
-#else
-  zip->entry.external_attr = 0;
-#endif
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!filename) {
+    return ZIP_EINVAL;
+  }
+  if (zip->archive.m_zip_mode != MZ_ZIP_MODE_READING) {
+    return ZIP_EINVMODE;
+  }
 
-  num_alignment_padding_bytes =
-      mz_zip_writer_compute_padding_needed_for_file_alignment(pzip);
+  if (!(fp = MZ_FOPEN(filename, "rb"))) {
+    return ZIP_EOPNFILE;
+  }
 
-  if (!pzip->m_pState || (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING)) {
-    // Invalid zip mode
-    err = ZIP_EINVMODE;
+  if ((err = zip_file_read_le(fp, &magic, 4)) < 0 ||
+      (err = zip_file_read_le(fp, &version, 4)) < 0) {
     goto cleanup;
   }
-  if (zip->level & MZ_ZIP_FLAG_COMPRESSED_DATA) {
-    // Invalid zip compression level
-    err = ZIP_EINVLVL;
+  if (magic != ZIP_SEEK_INDEX_MAGIC || version != ZIP_SEEK_INDEX_VERSION ||
+      fread(layout, 1, ZIP_SEEK_INDEX_LAYOUT_SIZE, fp) !=
+          ZIP_SEEK_INDEX_LAYOUT_SIZE) {
+    err = ZIP_EINVIDXFILE;
     goto cleanup;
   }
-
-  if (!mz_zip_writer_write_zeros(pzip, zip->entry.dir_offset,
-                                 num_alignment_padding_bytes)) {
-    // Cannot memset zip entry header
-    err = ZIP_EMEMSET;
+  // inflator state is only meaningful to a build with the same layout
+  zip_seek_index_layout(expected);
+  if (memcmp(layout, expected, ZIP_SEEK_INDEX_LAYOUT_SIZE) != 0) {
+    err = ZIP_EINVIDXFILE;
+    goto cleanup;
+  }
+  if ((err = zip_file_read_le(fp, &count, 4)) < 0) {
     goto cleanup;
   }
-  local_dir_header_ofs += num_alignment_padding_bytes;
-
-  zip->entry.m_time = time(NULL);
-#ifndef MINIZ_NO_TIME
-  mz_zip_time_t_to_dos_time(zip->entry.m_time, &dos_time, &dos_date);
-#endif
 
-  // ZIP64 header with NULL sizes (sizes will be in the data descriptor, just
-  // after file data)
-  extra_size = mz_zip_writer_create_zip64_extra_data(
-      extra_data, NULL, NULL,
-      (local_dir_header_ofs >= MZ_UINT32_MAX) ? &local_dir_header_ofs : NULL);
+  for (i = 0; i < count; ++i) {
+    struct zip_seek_index_t *seek_index =
+        (struct zip_seek_index_t *)calloc(1, sizeof(struct zip_seek_index_t));
+    if (!seek_index) {
+      err = ZIP_EOOMEM;
+      goto cleanup;
+    }
+    seek_index->next = loaded;
+    loaded = seek_index;
+    if ((err = zip_seek_index_read(fp, &zip->archive, seek_index)) < 0) {
+      goto cleanup;
+    }
+  }
 
-  if (!mz_zip_writer_create_local_dir_header(
-          pzip, zip->entry.header, (mz_uint16)entrylen, (mz_uint16)extra_size,
-          0, 0, 0, zip->entry.method,
-          MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8 |
-              MZ_ZIP_LDH_BIT_FLAG_HAS_LOCATOR,
-          dos_time, dos_date)) {
-    // Cannot create zip entry header
-    err = ZIP_EMEMSET;
-    goto cleanup;
+  // all or nothing: only replace cached indexes once the file checks out
+  while (loaded) {
+    struct zip_seek_index_t *next = loaded->next;
+    loaded->next = NULL;
+    zip_seek_index_insert(zip, loaded);
+    loaded = next;
   }
 
-  zip->entry.header_offset =
-      zip->entry.dir_offset + num_alignment_padding_bytes;
+cleanup:
+  zip_seek_index_free(loaded);
+  fclose(fp);
+  return err;
+}
+
+struct zip_reader_t *zip_reader_open(struct zip_t *zip, int *errnum) {
+  mz_zip_archive *pzip = NULL;
+  const mz_uint8 *pHeader = NULL;
+  struct zip_reader_t *reader = NULL;
+  mz_uint64 data_offset = 0;
+  int err = 0;
 
-  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.header_offset,
-                     zip->entry.header,
-                     sizeof(zip->entry.header)) != sizeof(zip->entry.header)) {
-    // Cannot write zip entry header
-    err = ZIP_EMEMSET;
+  if (!zip) {
+    // zip_t handler is not initialized
+    err = ZIP_ENOINIT;
     goto cleanup;
   }
 
-  if (pzip->m_file_offset_alignment) {
-    MZ_ASSERT(
-        (zip->entry.header_offset & (pzip->m_file_offset_alignment - 1)) == 0);
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    err = ZIP_ENOENT;
+    goto cleanup;
   }
-  zip->entry.dir_offset +=
-      num_alignment_padding_bytes + sizeof(zip->entry.header);
 
-  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, zip->entry.name,
-                     entrylen) != entrylen) {
-    // Cannot write data to zip entry
-    err = ZIP_EWRTENT;
+  pHeader = zip_central_dir_header(pzip, (mz_uint)zip->entry.index);
+  if (!pHeader) {
+    err = ZIP_ENOHDR;
     goto cleanup;
   }
-
-  zip->entry.dir_offset += entrylen;
-
-  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, extra_data,
-                     extra_size) != extra_size) {
-    // Cannot write ZIP64 data to zip entry
-    err = ZIP_EWRTENT;
+  if (!zip_reader_supported(MZ_READ_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS),
+                            zip->entry.method)) {
+    // encrypted, patched or unknown compression method
+    err = ZIP_ENORITER;
     goto cleanup;
   }
-  zip->entry.dir_offset += extra_size;
-
-  if (level) {
-    zip->entry.state.m_pZip = pzip;
-    zip->entry.state.m_cur_archive_file_ofs = zip->entry.dir_offset;
-    zip->entry.state.m_comp_size = 0;
 
-    if (tdefl_init(&(zip->entry.comp), mz_zip_writer_add_put_buf_callback,
-                   &(zip->entry.state),
-                   (int)tdefl_create_comp_flags_from_zip_params(
-                       (int)level, -15, MZ_DEFAULT_STRATEGY)) !=
-        TDEFL_STATUS_OKAY) {
-      // Cannot initialize the zip compressor
-      err = ZIP_ETDEFLINIT;
+  if (zip->entry.comp_size) {
+    err = zip_local_data_offset(pzip->m_pRead, pzip->m_pIO_opaque,
+                                pzip->m_archive_size, zip->entry.header_offset,
+                                zip->entry.comp_size, &data_offset);
+    if (err < 0) {
       goto cleanup;
     }
   }
 
-  return 0;
-
-cleanup:
-  CLEANUP(zip->entry.name);
-  return err;
-}
+  reader = (struct zip_reader_t *)malloc(sizeof(struct zip_reader_t));
+  if (!reader) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
 
-int zip_entry_open(struct zip_t *zip, const char *entryname) {
-  return _zip_entry_open(zip, entryname, 0);
-}
+  zip_reader_init(reader, pzip->m_pRead, pzip->m_pIO_opaque, data_offset,
+                  zip->entry.comp_size, zip->entry.uncomp_size,
+                  zip->entry.method, zip->entry.uncomp_crc32);
 
-int zip_entry_opencasesensitive(struct zip_t *zip, const char *entryname) {
-  return _zip_entry_open(zip, entryname, 1);
+cleanup:
+  if (errnum) {
+    *errnum = err;
+  }
+  return reader;
 }
 
-int zip_entry_openbyindex(struct zip_t *zip, size_t index) {
-  mz_zip_archive *pZip = NULL;
-  mz_zip_archive_file_stat stats;
-  mz_uint namelen;
-  const mz_uint8 *pHeader;
-  const char *pFilename;
+ssize_t zip_reader_next(struct zip_reader_t *reader, const void **chunk) {
+  struct zip_inflate_t *inf = NULL;
+  const mz_uint8 *out = NULL;
+  ssize_t n = 0;
 
-  if (!zip) {
-    // zip_t handler is not initialized
-    return ZIP_ENOINIT;
+  if (!reader || !chunk) {
+    return (ssize_t)ZIP_EINVAL;
   }
-
-  pZip = &(zip->archive);
-  if (pZip->m_zip_mode != MZ_ZIP_MODE_READING) {
-    // open by index requires readonly mode
-    return ZIP_EINVMODE;
+  if (reader->err) {
+    return (ssize_t)reader->err;
   }
 
-  if (index >= (size_t)pZip->m_total_files) {
-    // index out of range
-    return ZIP_EINVIDX;
+  if (reader->pending_size) {
+    // hand out what a previous zip_reader_read left behind first
+    *chunk = reader->pending;
+    n = (ssize_t)reader->pending_size;
+    reader->pending = NULL;
+    reader->pending_size = 0;
+    return n;
   }
 
-  if (!(pHeader = &MZ_ZIP_ARRAY_ELEMENT(
-            &pZip->m_pState->m_central_dir, mz_uint8,
-            MZ_ZIP_ARRAY_ELEMENT(&pZip->m_pState->m_central_dir_offsets,
-                                 mz_uint32, (mz_uint)index)))) {
-    // cannot find header in central directory
-    return ZIP_ENOHDR;
+  inf = &reader->inflate;
+  if (reader->method) {
+    n = zip_inflate_next(inf, &out);
+  } else if (inf->read_ofs < inf->comp_size) {
+    // stored data passes through the input buffer
+    size_t size = (size_t)MZ_MIN((mz_uint64)sizeof(inf->in),
+                                 inf->comp_size - inf->read_ofs);
+    if (inf->read(inf->opaque, inf->data_offset + inf->read_ofs, inf->in,
+                  size) != size) {
+      n = ZIP_EFREAD;
+    } else {
+      inf->read_ofs += size;
+      inf->out_ofs += size;
+      out = inf->in;
+      n = (ssize_t)size;
+    }
   }
 
-  namelen = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
-  pFilename = (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
-
-  if (zip->entry.name) {
-    CLEANUP(zip->entry.name);
+  if (n > 0) {
+    reader->crc32 = (mz_uint32)zip_crc32(reader->crc32, out, (size_t)n);
+    *chunk = out;
+    return n;
   }
 
-  zip->entry.name = zip_strclone(pFilename, namelen);
-  if (!zip->entry.name) {
-    // local entry name is NULL
-    return ZIP_EINVENTNAME;
+  if (n == 0 && (inf->out_ofs != inf->uncomp_size ||
+                 reader->crc32 != reader->uncomp_crc32)) {
+    // end of data, the entry must match its central directory record
+    n = ZIP_ECRC;
   }
+  reader->err = (int)n;
+  return n;
+}
 
-  if (!mz_zip_reader_file_stat(pZip, (mz_uint)index, &stats)) {
-    return ZIP_ENOENT;
+ssize_t zip_reader_read(struct zip_reader_t *reader, void *buf,
+                        size_t bufsize) {
+  mz_uint8 *writebuf = (mz_uint8 *)buf;
+  size_t write_cursor = 0;
+
+  if (!reader || (!buf && bufsize)) {
+    return (ssize_t)ZIP_EINVAL;
   }
 
-  zip->entry.index = (ssize_t)index;
-  zip->entry.comp_size = stats.m_comp_size;
-  zip->entry.uncomp_size = stats.m_uncomp_size;
-  zip->entry.uncomp_crc32 = stats.m_crc32;
-  zip->entry.dir_offset = stats.m_central_dir_ofs;
-  zip->entry.header_offset = stats.m_local_header_ofs;
-  zip->entry.method = stats.m_method;
-  zip->entry.external_attr = stats.m_external_attr;
-#ifndef MINIZ_NO_TIME
-  zip->entry.m_time = stats.m_time;
-#endif
+  while (write_cursor < bufsize) {
+    const void *chunk = NULL;
+    size_t size;
+    ssize_t n = zip_reader_next(reader, &chunk);
+    if (n < 0) {
+      return write_cursor ? (ssize_t)write_cursor : n;
+    }
+    if (n == 0) {
+      break;
+    }
 
-  return 0;
+    size = (size_t)n;
+    if (size > bufsize - write_cursor) {
+      size = bufsize - write_cursor;
+      // keep the rest of the chunk for the next call
+      reader->pending = (const mz_uint8 *)chunk + size;
+      reader->pending_size = (size_t)n - size;
+    }
+    memcpy(&writebuf[write_cursor], chunk, size);
+    write_cursor += size;
+  }
+  return (ssize_t)write_cursor;
 }
 
-int zip_entry_close(struct zip_t *zip) {
+void zip_reader_close(struct zip_reader_t *reader) { CLEANUP(reader); }
+
+struct zip_cursor_t *zip_cursor_open(struct zip_t *zip, int *errnum) {
   mz_zip_archive *pzip = NULL;
-  mz_uint level;
-  tdefl_status done;
-  mz_uint16 entrylen;
-  mz_uint16 dos_time = 0, dos_date = 0;
+  mz_zip_internal_state *pState = NULL;
+  struct zip_cursor_t *cursor = NULL;
   int err = 0;
-  mz_uint8 *pExtra_data = NULL;
-  mz_uint32 extra_size = 0;
-  mz_uint8 extra_data[MZ_ZIP64_MAX_CENTRAL_EXTRA_FIELD_SIZE];
-  mz_uint8 local_dir_footer[MZ_ZIP_DATA_DESCRIPTER_SIZE64];
-  mz_uint32 local_dir_footer_size = MZ_ZIP_DATA_DESCRIPTER_SIZE64;
 
   if (!zip) {
     // zip_t handler is not initialized
@@ -1368,456 +4680,754 @@ int zip_entry_close(struct zip_t *zip) {
   }
 
   pzip = &(zip->archive);
-  if (pzip->m_zip_mode == MZ_ZIP_MODE_READING) {
+  pState = pzip->m_pState;
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING || !pState ||
+      (!pState->m_pFile && !pState->m_pMem)) {
+    // cursors need a read-only archive backed by a file or a memory buffer
+    err = ZIP_EINVMODE;
     goto cleanup;
   }
 
-  level = zip->level & 0xF;
-  if (level) {
-    done = tdefl_compress_buffer(&(zip->entry.comp), "", 0, TDEFL_FINISH);
-    if (done != TDEFL_STATUS_DONE && done != TDEFL_STATUS_OKAY) {
-      // Cannot flush compressed buffer
-      err = ZIP_ETDEFLBUF;
+  if (!zip->dir_streamed && !zip->name_index.slots) {
+    err = zip_name_index_build(pzip, &zip->name_index);
+    if (err < 0) {
       goto cleanup;
     }
-    zip->entry.comp_size = zip->entry.state.m_comp_size;
-    zip->entry.dir_offset = zip->entry.state.m_cur_archive_file_ofs;
-    zip->entry.method = MZ_DEFLATED;
   }
 
-  entrylen = (mz_uint16)strlen(zip->entry.name);
-#ifndef MINIZ_NO_TIME
-  mz_zip_time_t_to_dos_time(zip->entry.m_time, &dos_time, &dos_date);
-#endif
-
-  MZ_WRITE_LE32(local_dir_footer + 0, MZ_ZIP_DATA_DESCRIPTOR_ID);
-  MZ_WRITE_LE32(local_dir_footer + 4, zip->entry.uncomp_crc32);
-  MZ_WRITE_LE64(local_dir_footer + 8, zip->entry.comp_size);
-  MZ_WRITE_LE64(local_dir_footer + 16, zip->entry.uncomp_size);
-
-  if (pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset,
-                     local_dir_footer,
-                     local_dir_footer_size) != local_dir_footer_size) {
-    // Cannot write zip entry header
-    err = ZIP_EWRTHDR;
+  cursor = (struct zip_cursor_t *)calloc(1, sizeof(struct zip_cursor_t));
+  if (!cursor) {
+    err = ZIP_EOOMEM;
     goto cleanup;
   }
-  zip->entry.dir_offset += local_dir_footer_size;
 
-  pExtra_data = extra_data;
-  extra_size = mz_zip_writer_create_zip64_extra_data(
-      extra_data,
-      (zip->entry.uncomp_size >= MZ_UINT32_MAX) ? &zip->entry.uncomp_size
-                                                : NULL,
-      (zip->entry.comp_size >= MZ_UINT32_MAX) ? &zip->entry.comp_size : NULL,
-      (zip->entry.header_offset >= MZ_UINT32_MAX) ? &zip->entry.header_offset
-                                                  : NULL);
+  cursor->zip = zip;
+  cursor->index = -1;
+  if (pState->m_pMem) {
+    cursor->pMem = (const mz_uint8 *)pState->m_pMem;
+    cursor->mem_size = pState->m_mem_size;
+  } else {
+    cursor->pFile = pState->m_pFile;
+    cursor->file_ofs = pState->m_file_archive_start_ofs;
+  }
 
-  if ((entrylen) && ISSLASH(zip->entry.name[entrylen - 1]) &&
-      !zip->entry.uncomp_size) {
-    /* Set DOS Subdirectory attribute bit. */
-    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+cleanup:
+  if (errnum) {
+    *errnum = err;
   }
+  return cursor;
+}
 
-  if (!mz_zip_writer_add_to_central_dir(
-          pzip, zip->entry.name, entrylen, pExtra_data, (mz_uint16)extra_size,
-          "", 0, zip->entry.uncomp_size, zip->entry.comp_size,
-          zip->entry.uncomp_crc32, zip->entry.method,
-          MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8 |
-              MZ_ZIP_LDH_BIT_FLAG_HAS_LOCATOR,
-          dos_time, dos_date, zip->entry.header_offset,
-          zip->entry.external_attr, NULL, 0)) {
-    // Cannot write to zip central dir
-    err = ZIP_EWRTDIR;
-    goto cleanup;
+// Prepares the reader for the entry described by cursor->stat.
+static int zip_cursor_entry_load(struct zip_cursor_t *cursor) {
+  mz_zip_archive *pzip = &(cursor->zip->archive);
+  mz_uint64 data_offset = 0;
+  int err;
+
+  if (!cursor->stat.m_is_directory &&
+      zip_reader_supported(cursor->stat.m_bit_flag, cursor->stat.m_method) &&
+      cursor->stat.m_comp_size) {
+    err = zip_local_data_offset(zip_cursor_read_func, cursor,
+                                pzip->m_archive_size,
+                                cursor->stat.m_local_header_ofs,
+                                cursor->stat.m_comp_size, &data_offset);
+    if (err < 0) {
+      return err;
+    }
   }
 
-  pzip->m_total_files++;
-  pzip->m_archive_size = zip->entry.dir_offset;
+  zip_reader_init(&cursor->reader, zip_cursor_read_func, cursor, data_offset,
+                  cursor->stat.m_comp_size, cursor->stat.m_uncomp_size,
+                  cursor->stat.m_method, cursor->stat.m_crc32);
+  cursor->index = (ssize_t)cursor->stat.m_file_index;
+  return 0;
+}
 
-cleanup:
-  if (zip) {
-    zip->entry.m_time = 0;
-    zip->entry.index = -1;
-    CLEANUP(zip->entry.name);
+static int zip_cursor_entry_set(struct zip_cursor_t *cursor, mz_uint index) {
+  cursor->index = -1;
+  // the central directory was validated when the archive was opened, stat only
+  // reads from it
+  if (!mz_zip_reader_file_stat(&(cursor->zip->archive), index,
+                               &cursor->stat)) {
+    return ZIP_ENOENT;
   }
-  return err;
+  return zip_cursor_entry_load(cursor);
 }
 
-const char *zip_entry_name(struct zip_t *zip) {
-  if (!zip) {
-    // zip_t handler is not initialized
-    return NULL;
+struct zip_dir_stream_find_t {
+  const char *name; // NULL looks up by index
+  size_t len;
+  mz_uint flags;
+  mz_uint32 index;
+  mz_zip_archive_file_stat *stat;
+  int err;
+};
+
+// Copies only the fields used by the cursor, the record info points into may
+// be gone once the caller moves on.
+static void zip_cursor_stat_from_info(mz_zip_archive_file_stat *stat,
+                                      const struct zip_entry_info_t *info) {
+  size_t namelen = MZ_MIN(info->namelen, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE - 1);
+
+  memset(stat, 0, sizeof(*stat));
+  stat->m_file_index = (mz_uint32)info->index;
+  stat->m_bit_flag = info->bit_flag;
+  stat->m_method = (mz_uint16)info->method;
+  stat->m_crc32 = info->crc32;
+  stat->m_comp_size = info->comp_size;
+  stat->m_uncomp_size = info->uncomp_size;
+  stat->m_local_header_ofs = info->header_offset;
+  stat->m_external_attr = info->external_attr;
+  stat->m_is_directory = (mz_bool)info->isdir;
+  memcpy(stat->m_filename, info->name, namelen);
+  stat->m_filename[namelen] = '\0';
+}
+
+static int zip_dir_stream_find_visit(void *arg, mz_uint32 index,
+                                     const mz_uint8 *pHeader) {
+  struct zip_dir_stream_find_t *find = (struct zip_dir_stream_find_t *)arg;
+  mz_zip_archive_file_stat *stat = find->stat;
+  struct zip_entry_info_t info;
+
+  if (find->name) {
+    if (MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS) != find->len ||
+        !mz_zip_string_equal(
+            find->name, (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+            (mz_uint)find->len, find->flags)) {
+      return 0;
+    }
+  } else if (index != find->index) {
+    return 0;
   }
-  return zip->entry.name;
+  if ((find->err = zip_central_dir_record_info(pHeader, index, &info)) < 0) {
+    return 1;
+  }
+  zip_cursor_stat_from_info(stat, &info);
+  find->err = 1;
+  return 1;
 }
 
-ssize_t zip_entry_index(struct zip_t *zip) {
-  if (!zip) {
-    // zip_t handler is not initialized
-    return (ssize_t)ZIP_ENOINIT;
+// Looks the entry up with a scan over the streamed central directory.
+static int zip_cursor_entry_stream(struct zip_cursor_t *cursor,
+                                   struct zip_dir_stream_find_t *find) {
+  ssize_t n;
+
+  cursor->index = -1;
+  find->stat = &cursor->stat;
+  find->err = 0;
+  n = zip_dir_stream_foreach(cursor->zip, &cursor->dir_window,
+                             zip_dir_stream_find_visit, find);
+  if (n < 0) {
+    return (int)n;
+  }
+  if (find->err <= 0) {
+    return find->err < 0 ? find->err : ZIP_ENOENT;
   }
+  return zip_cursor_entry_load(cursor);
+}
 
-  return zip->entry.index;
+static int zip_cursor_entry_find(struct zip_cursor_t *cursor,
+                                 const char *entryname, mz_uint flags) {
+  struct zip_t *zip = NULL;
+  size_t entrylen = 0;
+  ssize_t index;
+
+  if (!cursor) {
+    return ZIP_ENOINIT;
+  }
+  if (!entryname || !(entrylen = strlen(entryname)) ||
+      entrylen >= MZ_UINT16_MAX) {
+    return ZIP_EINVENTNAME;
+  }
+
+  zip = cursor->zip;
+  if (zip->dir_streamed) {
+    struct zip_dir_stream_find_t find;
+    memset(&find, 0, sizeof(find));
+    find.name = entryname;
+    find.len = entrylen;
+    find.flags = flags;
+    return zip_cursor_entry_stream(cursor, &find);
+  }
+  index = zip_name_index_find(&(zip->archive), &zip->name_index, entryname,
+                              entrylen, flags);
+  if (index < (ssize_t)0) {
+    cursor->index = -1;
+    return ZIP_ENOENT;
+  }
+  return zip_cursor_entry_set(cursor, (mz_uint)index);
 }
 
-int zip_entry_isdir(struct zip_t *zip) {
-  mz_uint16 entrylen;
-  if (!zip) {
-    // zip_t handler is not initialized
+int zip_cursor_entry_open(struct zip_cursor_t *cursor, const char *entryname) {
+  return zip_cursor_entry_find(cursor, entryname, 0);
+}
+
+int zip_cursor_entry_opencasesensitive(struct zip_cursor_t *cursor,
+                                       const char *entryname) {
+  return zip_cursor_entry_find(cursor, entryname, MZ_ZIP_FLAG_CASE_SENSITIVE);
+}
+
+int zip_cursor_entry_openbyindex(struct zip_cursor_t *cursor, size_t index) {
+  struct zip_dir_stream_find_t find;
+
+  if (!cursor) {
     return ZIP_ENOINIT;
   }
+  if (cursor->zip->dir_streamed) {
+    if (index >= (size_t)cursor->zip->dir_total_files) {
+      cursor->index = -1;
+      return ZIP_EINVIDX;
+    }
+    memset(&find, 0, sizeof(find));
+    find.index = (mz_uint32)index;
+    return zip_cursor_entry_stream(cursor, &find);
+  }
+  if (index >= (size_t)cursor->zip->archive.m_total_files) {
+    // index out of range
+    cursor->index = -1;
+    return ZIP_EINVIDX;
+  }
+  return zip_cursor_entry_set(cursor, (mz_uint)index);
+}
 
-  if (zip->entry.index < (ssize_t)0) {
-    // zip entry is not opened
+int zip_cursor_entry_openinfo(struct zip_cursor_t *cursor,
+                              const struct zip_entry_info_t *info) {
+  struct zip_t *zip = NULL;
+
+  if (!cursor) {
+    return ZIP_ENOINIT;
+  }
+  if (!info || !info->name) {
+    return ZIP_EINVAL;
+  }
+  zip = cursor->zip;
+  cursor->index = -1;
+  if (info->index >= (size_t)(zip->dir_streamed ? zip->dir_total_files
+                                                : zip->archive.m_total_files)) {
     return ZIP_EINVIDX;
   }
+  // the record was decoded by zip_entries_foreach, no lookup is needed
+  zip_cursor_stat_from_info(&cursor->stat, info);
+  return zip_cursor_entry_load(cursor);
+}
 
-  entrylen = (mz_uint16)strlen(zip->entry.name);
-  return ISSLASH(zip->entry.name[entrylen - 1]);
+int zip_cursor_entry_close(struct zip_cursor_t *cursor) {
+  if (!cursor) {
+    return ZIP_ENOINIT;
+  }
+  cursor->index = -1;
+  return 0;
 }
 
-unsigned long long zip_entry_size(struct zip_t *zip) {
-  return zip_entry_uncomp_size(zip);
+const char *zip_cursor_entry_name(struct zip_cursor_t *cursor) {
+  if (!cursor || cursor->index < (ssize_t)0) {
+    return NULL;
+  }
+  return cursor->stat.m_filename;
 }
 
-unsigned long long zip_entry_uncomp_size(struct zip_t *zip) {
-  return zip ? zip->entry.uncomp_size : 0;
+ssize_t zip_cursor_entry_index(struct zip_cursor_t *cursor) {
+  if (!cursor) {
+    return (ssize_t)ZIP_ENOINIT;
+  }
+  return cursor->index;
 }
 
-unsigned long long zip_entry_comp_size(struct zip_t *zip) {
-  return zip ? zip->entry.comp_size : 0;
+int zip_cursor_entry_isdir(struct zip_cursor_t *cursor) {
+  if (!cursor) {
+    return ZIP_ENOINIT;
+  }
+  if (cursor->index < (ssize_t)0) {
+    return ZIP_EINVIDX;
+  }
+  return (int)cursor->stat.m_is_directory;
 }
 
-unsigned int zip_entry_crc32(struct zip_t *zip) {
-  return zip ? zip->entry.uncomp_crc32 : 0;
+unsigned long long zip_cursor_entry_size(struct zip_cursor_t *cursor) {
+  return (cursor && cursor->index >= (ssize_t)0) ? cursor->stat.m_uncomp_size
+                                                 : 0;
 }
 
-unsigned long long zip_entry_dir_offset(struct zip_t *zip) {
-  return zip ? zip->entry.dir_offset : 0;
+unsigned long long zip_cursor_entry_comp_size(struct zip_cursor_t *cursor) {
+  return (cursor && cursor->index >= (ssize_t)0) ? cursor->stat.m_comp_size : 0;
 }
 
-unsigned long long zip_entry_header_offset(struct zip_t *zip) {
-  return zip ? zip->entry.header_offset : 0;
+unsigned int zip_cursor_entry_crc32(struct zip_cursor_t *cursor) {
+  return (cursor && cursor->index >= (ssize_t)0) ? cursor->stat.m_crc32 : 0;
 }
 
-void zip_entry_set_unix_permissions(struct zip_t *zip, unsigned int mode, int is_dir) {
-  if (!zip) {
-    return;
+static int zip_cursor_entry_rewind(struct zip_cursor_t *cursor) {
+  if (!cursor) {
+    return ZIP_ENOINIT;
   }
-  mz_uint32 perm = (mz_uint32)(mode & 0x0FFF);
-  mz_uint32 type = is_dir ? UNX_IFDIR : UNX_IFREG;
-  zip->entry.external_attr = ((type | perm) << 16);
-  if (is_dir) {
-    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+  if (cursor->index < (ssize_t)0) {
+    // the entry is not found
+    return ZIP_ENOENT;
   }
+  if (cursor->stat.m_is_directory) {
+    return ZIP_EINVENTTYPE;
+  }
+  if (!zip_reader_supported(cursor->stat.m_bit_flag, cursor->stat.m_method)) {
+    // encrypted, patched or unknown compression method
+    return ZIP_ENORITER;
+  }
+  // every read starts over, a previous one may have stopped half way
+  zip_reader_init(&cursor->reader, zip_cursor_read_func, cursor,
+                  cursor->reader.inflate.data_offset, cursor->stat.m_comp_size,
+                  cursor->stat.m_uncomp_size, cursor->stat.m_method,
+                  cursor->stat.m_crc32);
+  return 0;
 }
 
-int zip_entry_write(struct zip_t *zip, const void *buf, size_t bufsize) {
-  mz_uint level;
-  mz_zip_archive *pzip = NULL;
-  tdefl_status status;
-
-  if (!zip) {
-    // zip_t handler is not initialized
-    return ZIP_ENOINIT;
+ssize_t zip_cursor_entry_noallocread(struct zip_cursor_t *cursor, void *buf,
+                                     size_t bufsize) {
+  ssize_t n;
+  int err = zip_cursor_entry_rewind(cursor);
+  if (err < 0) {
+    return (ssize_t)err;
+  }
+  if (!buf || bufsize < cursor->stat.m_uncomp_size) {
+    return (ssize_t)ZIP_EMEMNOALLOC;
   }
 
-  pzip = &(zip->archive);
-  if (buf && bufsize > 0) {
-    zip->entry.uncomp_size += bufsize;
-    zip->entry.uncomp_crc32 = (mz_uint32)mz_crc32(
-        zip->entry.uncomp_crc32, (const mz_uint8 *)buf, bufsize);
-
-    level = zip->level & 0xF;
-    if (!level) {
-      if ((pzip->m_pWrite(pzip->m_pIO_opaque, zip->entry.dir_offset, buf,
-                          bufsize) != bufsize)) {
-        // Cannot write buffer
-        return ZIP_EWRTENT;
-      }
-      zip->entry.dir_offset += bufsize;
-      zip->entry.comp_size += bufsize;
-    } else {
-      status = tdefl_compress_buffer(&(zip->entry.comp), buf, bufsize,
-                                     TDEFL_NO_FLUSH);
-      if (status != TDEFL_STATUS_DONE && status != TDEFL_STATUS_OKAY) {
-        // Cannot compress buffer
-        return ZIP_ETDEFLBUF;
-      }
+  n = zip_reader_read(&cursor->reader, buf, bufsize);
+  if (n >= 0 && (mz_uint64)n == cursor->stat.m_uncomp_size) {
+    // a read reaching the end verifies the CRC-32 of the entry
+    const void *chunk = NULL;
+    ssize_t rest = zip_reader_next(&cursor->reader, &chunk);
+    if (rest != 0) {
+      return (rest < 0) ? rest : (ssize_t)ZIP_EINFLATE;
     }
   }
-
-  return 0;
+  return n;
 }
 
-int zip_entry_fwrite(struct zip_t *zip, const char *filename) {
-  int err = 0;
-  size_t n = 0;
-  MZ_FILE *stream = NULL;
-  mz_uint8 buf[MZ_ZIP_MAX_IO_BUF_SIZE];
-  struct MZ_FILE_STAT_STRUCT file_stat;
-  mz_uint16 modes;
-
-  if (!zip) {
-    // zip_t handler is not initialized
-    return ZIP_ENOINIT;
+int zip_cursor_entry_extract(struct zip_cursor_t *cursor,
+                             size_t (*on_extract)(void *arg, uint64_t offset,
+                                                  const void *data,
+                                                  size_t size),
+                             void *arg) {
+  mz_uint64 offset = 0;
+  int err = zip_cursor_entry_rewind(cursor);
+  if (err < 0) {
+    return err;
   }
-
-  memset(buf, 0, MZ_ZIP_MAX_IO_BUF_SIZE);
-  memset((void *)&file_stat, 0, sizeof(struct MZ_FILE_STAT_STRUCT));
-  if (MZ_FILE_STAT(filename, &file_stat) != 0) {
-    // problem getting information - check errno
-    return ZIP_ENOENT;
+  if (!on_extract) {
+    return ZIP_EINVAL;
   }
 
-#if defined(_WIN32) || defined(__WIN32__) || defined(DJGPP)
-  (void)modes; // unused
-#else
-  /* Initialize with permission bits--which are not implementation-optional */
-  modes = file_stat.st_mode &
-          (S_IRWXU | S_IRWXG | S_IRWXO | S_ISUID | S_ISGID | S_ISVTX);
-  if (S_ISDIR(file_stat.st_mode))
-    modes |= UNX_IFDIR;
-  if (S_ISREG(file_stat.st_mode))
-    modes |= UNX_IFREG;
-  if (S_ISLNK(file_stat.st_mode))
-    modes |= UNX_IFLNK;
-  if (S_ISBLK(file_stat.st_mode))
-    modes |= UNX_IFBLK;
-  if (S_ISCHR(file_stat.st_mode))
-    modes |= UNX_IFCHR;
-  if (S_ISFIFO(file_stat.st_mode))
-    modes |= UNX_IFIFO;
-  if (S_ISSOCK(file_stat.st_mode))
-    modes |= UNX_IFSOCK;
-  zip->entry.external_attr = (modes << 16) | !(file_stat.st_mode & S_IWUSR);
-  if ((file_stat.st_mode & S_IFMT) == S_IFDIR) {
-    zip->entry.external_attr |= MZ_ZIP_DOS_DIR_ATTRIBUTE_BITFLAG;
+  for (;;) {
+    const void *chunk = NULL;
+    ssize_t n = zip_reader_next(&cursor->reader, &chunk);
+    if (n <= 0) {
+      return (int)n;
+    }
+    if (on_extract(arg, offset, chunk, (size_t)n) != (size_t)n) {
+      return ZIP_EFWRITE;
+    }
+    offset += (mz_uint64)n;
   }
-#endif
-
-  zip->entry.m_time = file_stat.st_mtime;
+}
 
-  if (!(stream = MZ_FOPEN(filename, "rb"))) {
-    // Cannot open filename
-    return ZIP_EOPNFILE;
+int zip_cursor_entry_rawextract(struct zip_cursor_t *cursor,
+                                size_t (*on_extract)(void *arg,
+                                                     uint64_t offset,
+                                                     const void *data,
+                                                     size_t size),
+                                void *arg) {
+  mz_uint64 offset = 0, data_offset = 0;
+  mz_uint8 *buf = NULL;
+  int err = zip_cursor_entry_rewind(cursor);
+  if (err < 0) {
+    return err;
+  }
+  if (!on_extract) {
+    return ZIP_EINVAL;
   }
 
-  while ((n = fread(buf, sizeof(mz_uint8), MZ_ZIP_MAX_IO_BUF_SIZE, stream)) >
-         0) {
-    if (zip_entry_write(zip, buf, n) < 0) {
-      err = ZIP_EWRTENT;
-      break;
+  // the inflate input buffer is idle, the data is handed over as is
+  buf = cursor->reader.inflate.in;
+  data_offset = cursor->reader.inflate.data_offset;
+  while (offset < cursor->stat.m_comp_size) {
+    size_t n = (size_t)MZ_MIN(cursor->stat.m_comp_size - offset,
+                              (mz_uint64)MZ_ZIP_MAX_IO_BUF_SIZE);
+    if (zip_cursor_read_func(cursor, data_offset + offset, buf, n) != n) {
+      return ZIP_EFREAD;
+    }
+    if (on_extract(arg, offset, buf, n) != n) {
+      return ZIP_EFWRITE;
     }
+    offset += (mz_uint64)n;
   }
-  fclose(stream);
+  return 0;
+}
 
-  return err;
+void zip_cursor_close(struct zip_cursor_t *cursor) {
+  if (cursor) {
+    CLEANUP(cursor->dir_window);
+    CLEANUP(cursor);
+  }
 }
 
-ssize_t zip_entry_read(struct zip_t *zip, void **buf, size_t *bufsize) {
+int zip_entry_fread(struct zip_t *zip, const char *filename) {
   mz_zip_archive *pzip = NULL;
   mz_uint idx;
-  size_t size = 0;
+  mz_uint32 xattr = 0;
+  mz_zip_archive_file_stat info;
 
   if (!zip) {
     // zip_t handler is not initialized
-    return (ssize_t)ZIP_ENOINIT;
+    return ZIP_ENOINIT;
   }
 
+  memset((void *)&info, 0, sizeof(mz_zip_archive_file_stat));
   pzip = &(zip->archive);
   if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
       zip->entry.index < (ssize_t)0) {
     // the entry is not found or we do not have read access
-    return (ssize_t)ZIP_ENOENT;
+    return ZIP_ENOENT;
   }
 
   idx = (mz_uint)zip->entry.index;
   if (mz_zip_reader_is_file_a_directory(pzip, idx)) {
     // the entry is a directory
-    return (ssize_t)ZIP_EINVENTTYPE;
+    return ZIP_EINVENTTYPE;
   }
 
-  *buf = mz_zip_reader_extract_to_heap(pzip, idx, &size, 0);
-  if (*buf && bufsize) {
-    *bufsize = size;
+  if (!mz_zip_reader_extract_to_file(pzip, idx, filename, 0)) {
+    return ZIP_ENOFILE;
   }
-  return (ssize_t)size;
+
+#if defined(_MSC_VER) || defined(PS4)
+  (void)xattr; // unused
+#else
+  if (!mz_zip_reader_file_stat(pzip, idx, &info)) {
+    // Cannot get information about zip archive;
+    return ZIP_ENOFILE;
+  }
+
+  xattr = (info.m_external_attr >> 16) & 0xFFFF;
+  if (xattr > 0 && xattr <= MZ_UINT16_MAX) {
+    if (CHMOD(filename, (mode_t)xattr) < 0) {
+      return ZIP_ENOPERM;
+    }
+  }
+#endif
+
+  return 0;
 }
 
-ssize_t zip_entry_noallocread(struct zip_t *zip, void *buf, size_t bufsize) {
+int zip_entry_extract(struct zip_t *zip,
+                      size_t (*on_extract)(void *arg, uint64_t offset,
+                                           const void *buf, size_t bufsize),
+                      void *arg) {
   mz_zip_archive *pzip = NULL;
+  mz_uint idx;
 
   if (!zip) {
     // zip_t handler is not initialized
-    return (ssize_t)ZIP_ENOINIT;
+    return ZIP_ENOINIT;
   }
 
   pzip = &(zip->archive);
   if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
       zip->entry.index < (ssize_t)0) {
     // the entry is not found or we do not have read access
-    return (ssize_t)ZIP_ENOENT;
-  }
-
-  if (!mz_zip_reader_extract_to_mem_no_alloc(pzip, (mz_uint)zip->entry.index,
-                                             buf, bufsize, 0, NULL, 0)) {
-    return (ssize_t)ZIP_EMEMNOALLOC;
+    return ZIP_ENOENT;
   }
 
-  return (ssize_t)zip->entry.uncomp_size;
+  idx = (mz_uint)zip->entry.index;
+  return (mz_zip_reader_extract_to_callback(pzip, idx, on_extract, arg, 0))
+             ? 0
+             : ZIP_EINVIDX;
 }
 
-ssize_t zip_entry_noallocreadwithoffset(struct zip_t *zip, size_t offset,
-                                        size_t size, void *buf) {
-  mz_zip_archive *pzip = NULL;
-
+ssize_t zip_entries_total(struct zip_t *zip) {
   if (!zip) {
     // zip_t handler is not initialized
-    return (ssize_t)ZIP_ENOINIT;
+    return ZIP_ENOINIT;
   }
 
-  if (offset >= (size_t)zip->entry.uncomp_size) {
-    return (ssize_t)ZIP_EINVAL;
+  if (zip->dir_streamed) {
+    return (ssize_t)zip->dir_total_files;
   }
+  return (ssize_t)zip->archive.m_total_files;
+}
 
-  if ((offset + size) > (size_t)zip->entry.uncomp_size) {
-    size = (ssize_t)zip->entry.uncomp_size - offset;
-  }
+struct zip_dir_stream_visit_t {
+  int (*on_entry)(void *arg, const struct zip_entry_info_t *info);
+  void *arg;
+  int err;
+};
 
-  pzip = &(zip->archive);
-  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
-      zip->entry.index < (ssize_t)0) {
-    // the entry is not found or we do not have read access
-    return (ssize_t)ZIP_ENOENT;
-  }
+static int zip_dir_stream_visit(void *arg, mz_uint32 index,
+                                const mz_uint8 *pHeader) {
+  struct zip_dir_stream_visit_t *visit = (struct zip_dir_stream_visit_t *)arg;
+  struct zip_entry_info_t info;
 
-  mz_zip_reader_extract_iter_state *iter =
-      mz_zip_reader_extract_iter_new(pzip, (mz_uint)zip->entry.index, 0);
-  if (!iter) {
-    return (ssize_t)ZIP_ENORITER;
+  if ((visit->err = zip_central_dir_record_info(pHeader, index, &info)) < 0) {
+    return 1;
   }
+  return visit->on_entry(visit->arg, &info);
+}
 
-  mz_uint8 *writebuf = (mz_uint8 *)buf;
-  size_t file_offset = 0;
-  size_t write_cursor = 0;
-  size_t to_read = size;
-
-  // iterate until the requested offset is in range
-  while (file_offset < zip->entry.uncomp_size && to_read > 0) {
-    size_t nread = mz_zip_reader_extract_iter_read(
-        iter, (void *)&writebuf[write_cursor], to_read);
-
-    if (nread == 0)
-      break;
+ssize_t zip_entries_foreach(struct zip_t *zip,
+                            int (*on_entry)(void *arg,
+                                            const struct zip_entry_info_t *info),
+                            void *arg) {
+  mz_zip_archive *pzip = NULL;
+  struct zip_entry_info_t info;
+  mz_uint32 index;
+  int err;
 
-    if (offset < (file_offset + nread)) {
-      size_t read_cursor = offset - file_offset;
-      MZ_ASSERT(read_cursor < size);
-      size_t read_size = nread - read_cursor;
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!on_entry) {
+    return ZIP_EINVAL;
+  }
 
-      if (to_read < read_size)
-        read_size = to_read;
-      MZ_ASSERT(read_size <= size);
+  pzip = &(zip->archive);
+  if (!pzip->m_pState) {
+    return ZIP_ENOINIT;
+  }
+  if (zip->dir_streamed) {
+    struct zip_dir_stream_visit_t visit = {on_entry, arg, 0};
+    ssize_t n = zip_dir_stream_foreach(zip, &zip->dir_window,
+                                       zip_dir_stream_visit, &visit);
+    return visit.err < 0 ? (ssize_t)visit.err : n;
+  }
+  for (index = 0; index < pzip->m_total_files; ++index) {
+    err = zip_central_dir_info(pzip, index, &info);
+    if (err < 0) {
+      return err;
+    }
+    if (on_entry(arg, &info)) {
+      return (ssize_t)index + 1;
+    }
+  }
+  return (ssize_t)pzip->m_total_files;
+}
 
-      // If it's an unaligned read (i.e. the first one)
-      if (read_cursor != 0) {
-        memmove(&writebuf[write_cursor], &writebuf[read_cursor], read_size);
-      }
+struct zip_dir_stream_prefix_t {
+  const char *prefix;
+  size_t len;
+  int (*on_entry)(void *arg, size_t index, const char *name, size_t namelen);
+  void *arg;
+  ssize_t n;
+};
 
-      write_cursor += read_size;
-      offset += read_size;
-      to_read -= read_size;
-    }
+static int zip_dir_stream_prefix(void *arg, mz_uint32 index,
+                                 const mz_uint8 *pHeader) {
+  struct zip_dir_stream_prefix_t *scan = (struct zip_dir_stream_prefix_t *)arg;
+  const char *name = (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
+  size_t namelen = MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS);
 
-    file_offset += nread;
+  if (namelen < scan->len || memcmp(name, scan->prefix, scan->len) != 0) {
+    return 0;
   }
-
-  mz_zip_reader_extract_iter_free(iter);
-  return (ssize_t)write_cursor;
+  ++scan->n;
+  return scan->on_entry(scan->arg, index, name, namelen);
 }
 
-int zip_entry_fread(struct zip_t *zip, const char *filename) {
+ssize_t zip_entries_prefix(struct zip_t *zip, const char *prefix,
+                           int (*on_entry)(void *arg, size_t index,
+                                           const char *name, size_t namelen),
+                           void *arg) {
   mz_zip_archive *pzip = NULL;
-  mz_uint idx;
-  mz_uint32 xattr = 0;
-  mz_zip_archive_file_stat info;
+  const mz_uint8 *pHeader = NULL;
+  size_t len, lo, hi, mid, i;
+  ssize_t n = 0;
+  mz_uint32 index;
+  int err;
 
   if (!zip) {
     // zip_t handler is not initialized
     return ZIP_ENOINIT;
   }
-
-  memset((void *)&info, 0, sizeof(mz_zip_archive_file_stat));
-  pzip = &(zip->archive);
-  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
-      zip->entry.index < (ssize_t)0) {
-    // the entry is not found or we do not have read access
-    return ZIP_ENOENT;
+  if (!prefix || !on_entry) {
+    return ZIP_EINVENTNAME;
+  }
+
+  pzip = &(zip->archive);
+  if (!pzip->m_pState) {
+    return ZIP_ENOINIT;
   }
+  len = strlen(prefix);
 
-  idx = (mz_uint)zip->entry.index;
-  if (mz_zip_reader_is_file_a_directory(pzip, idx)) {
-    // the entry is a directory
-    return ZIP_EINVENTTYPE;
+  if (zip->dir_streamed) {
+    struct zip_dir_stream_prefix_t scan = {prefix, len, on_entry, arg, 0};
+    ssize_t err = zip_dir_stream_foreach(zip, &zip->dir_window,
+                                         zip_dir_stream_prefix, &scan);
+    return err < 0 ? err : scan.n;
   }
 
-  if (!mz_zip_reader_extract_to_file(pzip, idx, filename, 0)) {
-    return ZIP_ENOFILE;
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING) {
+    // entries may still change, scan the central directory in order
+    for (index = 0; index < pzip->m_total_files; ++index) {
+      if (zip_name_prefix_compare(pzip, index, prefix, len) != 0) {
+        continue;
+      }
+      pHeader = zip_central_dir_header(pzip, index);
+      ++n;
+      if (on_entry(arg, index,
+                   (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+                   MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS))) {
+        break;
+      }
+    }
+    return n;
   }
 
-#if defined(_MSC_VER) || defined(PS4)
-  (void)xattr; // unused
-#else
-  if (!mz_zip_reader_file_stat(pzip, idx, &info)) {
-    // Cannot get information about zip archive;
-    return ZIP_ENOFILE;
+  if (!zip->name_index.sorted) {
+    err = zip_name_index_sort(pzip, &zip->name_index);
+    if (err < 0) {
+      return err;
+    }
   }
 
-  xattr = (info.m_external_attr >> 16) & 0xFFFF;
-  if (xattr > 0 && xattr <= MZ_UINT16_MAX) {
-    if (CHMOD(filename, (mode_t)xattr) < 0) {
-      return ZIP_ENOPERM;
+  // lower bound of the prefix, matches are contiguous from there
+  lo = 0;
+  hi = pzip->m_total_files;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (zip_name_prefix_compare(pzip, zip->name_index.sorted[mid], prefix,
+                                len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
   }
-#endif
 
-  return 0;
+  for (i = lo; i < pzip->m_total_files; ++i) {
+    index = zip->name_index.sorted[i];
+    if (zip_name_prefix_compare(pzip, index, prefix, len) != 0) {
+      break;
+    }
+    pHeader = zip_central_dir_header(pzip, index);
+    ++n;
+    if (on_entry(arg, index,
+                 (const char *)pHeader + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE,
+                 MZ_READ_LE16(pHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS))) {
+      break;
+    }
+  }
+  return n;
 }
 
-int zip_entry_extract(struct zip_t *zip,
-                      size_t (*on_extract)(void *arg, uint64_t offset,
-                                           const void *buf, size_t bufsize),
-                      void *arg) {
+ssize_t zip_entries_layout(struct zip_t *zip, const char *const names[],
+                           struct zip_entry_span_t *spans, size_t n) {
   mz_zip_archive *pzip = NULL;
-  mz_uint idx;
+  struct zip_entry_info_t info;
+  // arena sizes are returned as ssize_t
+  const mz_uint64 max_size = (mz_uint64)((size_t)-1 >> 1);
+  mz_uint64 total = 0;
+  size_t i, len;
+  ssize_t index;
+  int err;
 
   if (!zip) {
     // zip_t handler is not initialized
     return ZIP_ENOINIT;
   }
+  if (!spans && n) {
+    return ZIP_EINVAL;
+  }
 
   pzip = &(zip->archive);
-  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING ||
-      zip->entry.index < (ssize_t)0) {
-    // the entry is not found or we do not have read access
-    return ZIP_ENOENT;
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_READING || !pzip->m_pState ||
+      zip->dir_streamed) {
+    return ZIP_EINVMODE;
+  }
+  if (names && !zip->name_index.slots) {
+    err = zip_name_index_build(pzip, &zip->name_index);
+    if (err < 0) {
+      return err;
+    }
   }
 
-  idx = (mz_uint)zip->entry.index;
-  return (mz_zip_reader_extract_to_callback(pzip, idx, on_extract, arg, 0))
-             ? 0
-             : ZIP_EINVIDX;
+  for (i = 0; i < n; ++i) {
+    struct zip_entry_span_t *span = &spans[i];
+    span->offset = (size_t)total;
+    span->size = 0;
+    span->err = 0;
+    if (names) {
+      if (!names[i] || !(len = strlen(names[i])) || len >= MZ_UINT16_MAX) {
+        span->err = ZIP_EINVENTNAME;
+        continue;
+      }
+      index = zip_name_index_find(pzip, &zip->name_index, names[i], len, 0);
+      if (index < (ssize_t)0) {
+        span->err = ZIP_ENOENT;
+        continue;
+      }
+      span->index = (size_t)index;
+    } else if (span->index >= (size_t)pzip->m_total_files) {
+      span->err = ZIP_EINVIDX;
+      continue;
+    }
+
+    err = zip_central_dir_info(pzip, (mz_uint32)span->index, &info);
+    if (err < 0) {
+      span->err = err;
+      continue;
+    }
+    if (info.isdir) {
+      span->err = ZIP_EINVENTTYPE;
+      continue;
+    }
+    if (info.uncomp_size > max_size - total) {
+      return ZIP_EOOMEM;
+    }
+    span->size = (size_t)info.uncomp_size;
+    total += info.uncomp_size;
+  }
+  return (ssize_t)total;
 }
 
-ssize_t zip_entries_total(struct zip_t *zip) {
-  if (!zip) {
-    // zip_t handler is not initialized
+ssize_t zip_cursor_entries_read(struct zip_cursor_t *cursor,
+                                struct zip_entry_span_t *spans, size_t n,
+                                void *arena) {
+  ssize_t read = 0, size;
+  size_t i;
+
+  if (!cursor) {
     return ZIP_ENOINIT;
   }
+  if (!spans && n) {
+    return ZIP_EINVAL;
+  }
 
-  return (ssize_t)zip->archive.m_total_files;
+  for (i = 0; i < n; ++i) {
+    struct zip_entry_span_t *span = &spans[i];
+    if (span->err < 0) {
+      continue;
+    }
+    if (span->size) {
+      if (!arena) {
+        return ZIP_EMEMNOALLOC;
+      }
+      span->err = zip_cursor_entry_openbyindex(cursor, span->index);
+      if (span->err < 0) {
+        continue;
+      }
+      // the central directory sizes laid out the arena, the entry has to
+      // fill its span exactly
+      size = zip_cursor_entry_noallocread(
+          cursor, (mz_uint8 *)arena + span->offset, span->size);
+      if (size < 0) {
+        span->err = (int)size;
+        continue;
+      }
+      if ((size_t)size != span->size) {
+        span->err = ZIP_EINFLATE;
+        continue;
+      }
+    }
+    ++read;
+  }
+  return read;
 }
 
 ssize_t zip_entries_delete(struct zip_t *zip, char *const entries[],
@@ -1853,7 +5463,7 @@ ssize_t zip_entries_delete(struct zip_t *zip, char *const entries[],
     return err;
   }
 
-  err = zip_entries_delete_mark(zip, entry_mark, (int)n);
+  err = zip_entries_delete_mark(zip, entry_mark, (size_t)n);
   CLEANUP(entry_mark);
   return err;
 }
@@ -1891,8 +5501,434 @@ ssize_t zip_entries_deletebyindex(struct zip_t *zip, size_t entries[],
     return err;
   }
 
-  err = zip_entries_delete_mark(zip, entry_mark, (int)n);
+  err = zip_entries_delete_mark(zip, entry_mark, (size_t)n);
+  CLEANUP(entry_mark);
+  return err;
+}
+
+ssize_t zip_entries_unlink(struct zip_t *zip, char *const entries[],
+                           size_t len) {
+  ssize_t n = 0;
+  ssize_t err = 0;
+  struct zip_entry_mark_t *entry_mark = NULL;
+
+  if (zip == NULL || (entries == NULL && len != 0)) {
+    return ZIP_ENOINIT;
+  }
+  if (zip->archive.m_zip_mode != MZ_ZIP_MODE_WRITING) {
+    return ZIP_EINVMODE;
+  }
+  if ((entries == NULL && len == 0) || zip->archive.m_total_files == 0) {
+    return 0;
+  }
+
+  n = zip_entries_total(zip);
+  entry_mark = (struct zip_entry_mark_t *)calloc(
+      (size_t)n, sizeof(struct zip_entry_mark_t));
+  if (!entry_mark) {
+    return ZIP_EOOMEM;
+  }
+
+  err = zip_entry_mark(zip, entry_mark, (size_t)n, entries, len);
+  if (err >= 0) {
+    err = zip_entries_unlink_mark(zip, entry_mark, (size_t)n);
+  }
+  CLEANUP(entry_mark);
+  return err;
+}
+
+int zip_entry_replace(struct zip_t *zip, const char *entryname,
+                      const void *buf, size_t bufsize) {
+  mz_zip_archive *pzip = NULL;
+  struct zip_entry_info_t info, other;
+  struct zip_entry_mark_t *entry_mark = NULL;
+  mz_uint8 local[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
+  mz_uint8 *pHeader = NULL;
+  void *comp = NULL;
+  const void *data = buf;
+  size_t entrylen, comp_size = bufsize;
+  mz_uint64 slot_end;
+  mz_uint32 i, index, uncomp_crc32;
+  mz_uint16 method = 0, dos_time = 0, dos_date = 0;
+  mz_uint level;
+  int err = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!entryname || (!buf && bufsize)) {
+    return ZIP_EINVENTNAME;
+  }
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING) {
+    return ZIP_EINVMODE;
+  }
+
+  entrylen = strlen(entryname);
+  for (index = 0; index < pzip->m_total_files; ++index) {
+    const mz_uint8 *pName = zip_central_dir_header(pzip, index);
+    if (MZ_READ_LE16(pName + MZ_ZIP_CDH_FILENAME_LEN_OFS) == entrylen &&
+        memcmp(pName + MZ_ZIP_CENTRAL_DIR_HEADER_SIZE, entryname, entrylen) ==
+            0) {
+      break;
+    }
+  }
+  if (index == pzip->m_total_files) {
+    return ZIP_ENOENT;
+  }
+  if ((err = zip_central_dir_info(pzip, index, &info)) < 0) {
+    return err;
+  }
+
+  uncomp_crc32 = (mz_uint32)zip_crc32(MZ_CRC32_INIT, buf, bufsize);
+  level = zip->level & 0xF;
+  if (level && bufsize) {
+    comp = tdefl_compress_mem_to_heap(
+        buf, bufsize, &comp_size,
+        (int)tdefl_create_comp_flags_from_zip_params((int)level, -15,
+                                                     MZ_DEFAULT_STRATEGY));
+    if (!comp) {
+      return ZIP_EOOMEM;
+    }
+    if (comp_size < bufsize) {
+      data = comp;
+      method = MZ_DEFLATED;
+    } else {
+      comp_size = bufsize;
+    }
+  }
+#ifndef MINIZ_NO_TIME
+  mz_zip_time_t_to_dos_time(time(NULL), &dos_time, &dos_date);
+#endif
+
+  // the old slot reaches up to the next local record; records that need
+  // zip64 fields are always appended
+  slot_end = pzip->m_archive_size;
+  for (i = 0; i < pzip->m_total_files; ++i) {
+    if (i != index && zip_central_dir_info(pzip, i, &other) == 0 &&
+        other.header_offset > info.header_offset &&
+        other.header_offset < slot_end) {
+      slot_end = other.header_offset;
+    }
+  }
+  if (info.header_offset < MZ_UINT32_MAX && info.comp_size < MZ_UINT32_MAX &&
+      info.uncomp_size < MZ_UINT32_MAX && bufsize < MZ_UINT32_MAX &&
+      info.header_offset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + entrylen +
+              comp_size <=
+          slot_end) {
+    if (!mz_zip_writer_create_local_dir_header(
+            pzip, local, (mz_uint16)entrylen, 0, bufsize, comp_size, uncomp_crc32,
+            method, MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8, dos_time,
+            dos_date)) {
+      err = ZIP_EMEMSET;
+      goto cleanup;
+    }
+    if (pzip->m_pWrite(pzip->m_pIO_opaque, info.header_offset, local,
+                       sizeof(local)) != sizeof(local) ||
+        pzip->m_pWrite(pzip->m_pIO_opaque, info.header_offset + sizeof(local),
+                       entryname, entrylen) != entrylen ||
+        pzip->m_pWrite(pzip->m_pIO_opaque,
+                       info.header_offset + sizeof(local) + entrylen, data,
+                       comp_size) != comp_size) {
+      err = ZIP_EWRTENT;
+      goto cleanup;
+    }
+    pHeader = &MZ_ZIP_ARRAY_ELEMENT(
+        &pzip->m_pState->m_central_dir, mz_uint8,
+        MZ_ZIP_ARRAY_ELEMENT(&pzip->m_pState->m_central_dir_offsets,
+                             mz_uint32, index));
+    MZ_WRITE_LE16(pHeader + MZ_ZIP_CDH_BIT_FLAG_OFS,
+                  MZ_ZIP_GENERAL_PURPOSE_BIT_FLAG_UTF8);
+    MZ_WRITE_LE16(pHeader + MZ_ZIP_CDH_METHOD_OFS, method);
+    MZ_WRITE_LE16(pHeader + MZ_ZIP_CDH_FILE_TIME_OFS, dos_time);
+    MZ_WRITE_LE16(pHeader + MZ_ZIP_CDH_FILE_DATE_OFS, dos_date);
+    MZ_WRITE_LE32(pHeader + MZ_ZIP_CDH_CRC32_OFS, uncomp_crc32);
+    MZ_WRITE_LE32(pHeader + MZ_ZIP_CDH_COMPRESSED_SIZE_OFS, comp_size);
+    MZ_WRITE_LE32(pHeader + MZ_ZIP_CDH_DECOMPRESSED_SIZE_OFS, bufsize);
+    goto cleanup;
+  }
+
+  entry_mark = (struct zip_entry_mark_t *)calloc(pzip->m_total_files,
+                                                 sizeof(struct zip_entry_mark_t));
+  if (!entry_mark) {
+    err = ZIP_EOOMEM;
+    goto cleanup;
+  }
+  entry_mark[index].type = MZ_DELETE;
+  if ((err = zip_entries_unlink_mark(zip, entry_mark, pzip->m_total_files)) <
+      0) {
+    goto cleanup;
+  }
+  if ((err = zip_entry_open(zip, entryname)) < 0) {
+    goto cleanup;
+  }
+  zip->entry.external_attr = info.external_attr;
+  // the buffer is already compressed for the slot, reuse it
+  if ((err = zip_entry_rawwrite(zip, data, comp_size, method, bufsize,
+                                uncomp_crc32)) < 0) {
+    zip_entry_close(zip);
+    goto cleanup;
+  }
+  if ((err = zip_entry_close(zip)) == 0) {
+    err = 1;
+  }
+
+cleanup:
   CLEANUP(entry_mark);
+  if (comp) {
+    mz_free(comp);
+  }
+  return err;
+}
+
+int zip_archive_usage(struct zip_t *zip, unsigned long long *used,
+                      unsigned long long *size) {
+  mz_zip_archive *pzip = NULL;
+  mz_uint64 data_size, length, total = 0;
+  mz_uint32 i;
+  int err;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  if (!used || !size) {
+    return ZIP_EINVAL;
+  }
+  pzip = &(zip->archive);
+  if (!pzip->m_pState) {
+    return ZIP_ENOINIT;
+  }
+  data_size = pzip->m_zip_mode == MZ_ZIP_MODE_READING
+                  ? pzip->m_central_directory_file_ofs
+                  : pzip->m_archive_size;
+
+  for (i = 0; i < pzip->m_total_files; ++i) {
+    if ((err = zip_local_record_length(pzip, i, data_size, &length)) < 0) {
+      return err;
+    }
+    total += length;
+  }
+  *used = total;
+  *size = data_size;
+  return 0;
+}
+
+int zip_compact(struct zip_t *zip, unsigned long long *reclaimed) {
+  mz_zip_archive *pzip = NULL;
+  struct zip_entry_order_t *order = NULL;
+  mz_uint64 run_from = 0, run_to = 0, run_len = 0, write_ofs = 0;
+  mz_uint32 i, n;
+  int err = 0;
+
+  if (!zip) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  pzip = &(zip->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING) {
+    return ZIP_EINVMODE;
+  }
+  if (reclaimed) {
+    *reclaimed = 0;
+  }
+  n = pzip->m_total_files;
+  if (n == 0) {
+    pzip->m_archive_size = 0;
+    return 0;
+  }
+
+  order = (struct zip_entry_order_t *)malloc(n * sizeof(*order));
+  if (!order) {
+    return ZIP_EOOMEM;
+  }
+  // measure every record before moving anything, a bad record leaves the
+  // archive untouched
+  for (i = 0; i < n; ++i) {
+    struct zip_entry_info_t info;
+    if ((err = zip_central_dir_info(pzip, i, &info)) < 0 ||
+        (err = zip_local_record_length(pzip, i, pzip->m_archive_size,
+                                       &order[i].length)) < 0) {
+      goto cleanup;
+    }
+    order[i].m_local_header_ofs = info.header_offset;
+    order[i].index = i;
+  }
+  qsort(order, n, sizeof(*order), zip_entry_order_compare);
+  for (i = 1; i < n; ++i) {
+    if (order[i - 1].m_local_header_ofs + order[i - 1].length >
+        order[i].m_local_header_ofs) {
+      // records overlap
+      err = ZIP_ENOHDR;
+      goto cleanup;
+    }
+  }
+
+  // records that are already adjacent are moved together
+  for (i = 0; i < n; ++i) {
+    const mz_uint64 ofs = order[i].m_local_header_ofs;
+    if (ofs != run_from + run_len) {
+      if (run_len && run_from != run_to &&
+          (err = zip_files_move(zip, run_to, run_from, run_len)) < 0) {
+        goto cleanup;
+      }
+      run_from = ofs;
+      run_to = write_ofs;
+      run_len = 0;
+    }
+    if (run_from != run_to &&
+        (err = zip_central_dir_set_offset(
+             &MZ_ZIP_ARRAY_ELEMENT(
+                 &pzip->m_pState->m_central_dir, mz_uint8,
+                 MZ_ZIP_ARRAY_ELEMENT(&pzip->m_pState->m_central_dir_offsets,
+                                      mz_uint32, order[i].index)),
+             ofs - (run_from - run_to))) < 0) {
+      goto cleanup;
+    }
+    run_len += order[i].length;
+    write_ofs += order[i].length;
+  }
+  if (run_len && run_from != run_to &&
+      (err = zip_files_move(zip, run_to, run_from, run_len)) < 0) {
+    goto cleanup;
+  }
+
+  if (reclaimed) {
+    *reclaimed = pzip->m_archive_size - write_ofs;
+  }
+  pzip->m_archive_size = write_ofs;
+
+cleanup:
+  CLEANUP(order);
+  return err;
+}
+
+int zip_entry_rawcopy(struct zip_t *zip, struct zip_t *source, size_t index) {
+  mz_zip_archive *pzip = NULL, *psrc = NULL;
+  struct zip_entry_info_t info;
+  const mz_uint8 *pSrcHeader = NULL;
+  mz_uint8 *pHeader = NULL, *copy_buf = NULL;
+  mz_uint64 length, copied = 0, dst_ofs, src_ofs;
+  size_t header_len, central_dir_ofs, n;
+  mz_uint32 offset_field;
+  int err = 0;
+
+  if (!zip || !source) {
+    // zip_t handler is not initialized
+    return ZIP_ENOINIT;
+  }
+  pzip = &(zip->archive);
+  psrc = &(source->archive);
+  if (pzip->m_zip_mode != MZ_ZIP_MODE_WRITING ||
+      psrc->m_zip_mode != MZ_ZIP_MODE_READING) {
+    return ZIP_EINVMODE;
+  }
+  if (index >= psrc->m_total_files) {
+    return ZIP_EINVIDX;
+  }
+  if ((err = zip_central_dir_info(psrc, (mz_uint32)index, &info)) < 0 ||
+      (err = zip_local_record_length(psrc, (mz_uint32)index,
+                                     psrc->m_central_directory_file_ofs,
+                                     &length)) < 0) {
+    return err;
+  }
+  pSrcHeader = zip_central_dir_header(psrc, (mz_uint32)index);
+  offset_field = MZ_READ_LE32(pSrcHeader + MZ_ZIP_CDH_LOCAL_HEADER_OFS);
+  if (offset_field != MZ_UINT32_MAX && pzip->m_archive_size >= MZ_UINT32_MAX) {
+    // the new offset needs a zip64 field the record does not have yet, let
+    // miniz rebuild the record
+    return mz_zip_writer_add_from_zip_reader(pzip, psrc, (mz_uint)index)
+               ? 0
+               : ZIP_EWRTENT;
+  }
+
+  // the local record is position independent and is copied byte for byte
+  dst_ofs = pzip->m_archive_size;
+  src_ofs = info.header_offset;
+#if defined(__linux__)
+  if (pzip->m_pState->m_pFile && psrc->m_pState->m_pFile &&
+      fflush(pzip->m_pState->m_pFile) == 0) {
+    int in_fd = fileno(psrc->m_pState->m_pFile);
+    int out_fd = fileno(pzip->m_pState->m_pFile);
+    while (copied < length) {
+      loff_t off_in =
+          (loff_t)(psrc->m_pState->m_file_archive_start_ofs + src_ofs + copied);
+      loff_t off_out =
+          (loff_t)(pzip->m_pState->m_file_archive_start_ofs + dst_ofs + copied);
+      ssize_t got = copy_file_range(
+          in_fd, &off_in, out_fd, &off_out,
+          (size_t)MZ_MIN(length - copied, (mz_uint64)1 << 30), 0);
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got <= 0) {
+        // not supported here, copy the rest through the buffer
+        break;
+      }
+      copied += (mz_uint64)got;
+    }
+  }
+#endif
+  if (copied < length) {
+    copy_buf = (mz_uint8 *)malloc(
+        (size_t)MZ_MIN(length - copied, (mz_uint64)ZIP_MOVE_BUFFER_SIZE));
+    if (!copy_buf) {
+      return ZIP_EOOMEM;
+    }
+  }
+  while (copied < length) {
+    n = (size_t)MZ_MIN(length - copied, (mz_uint64)ZIP_MOVE_BUFFER_SIZE);
+    if (psrc->m_pRead(psrc->m_pIO_opaque, src_ofs + copied, copy_buf, n) !=
+        n) {
+      err = ZIP_EFREAD;
+      goto cleanup;
+    }
+    if (pzip->m_pWrite(pzip->m_pIO_opaque, dst_ofs + copied, copy_buf, n) !=
+        n) {
+      err = ZIP_EFWRITE;
+      goto cleanup;
+    }
+    copied += n;
+  }
+
+  // the central directory record is copied as well, only the local header
+  // offset changes
+  header_len = MZ_ZIP_CENTRAL_DIR_HEADER_SIZE +
+               MZ_READ_LE16(pSrcHeader + MZ_ZIP_CDH_FILENAME_LEN_OFS) +
+               MZ_READ_LE16(pSrcHeader + MZ_ZIP_CDH_EXTRA_LEN_OFS) +
+               MZ_READ_LE16(pSrcHeader + MZ_ZIP_CDH_COMMENT_LEN_OFS);
+  central_dir_ofs = pzip->m_pState->m_central_dir.m_size;
+  if ((mz_uint64)central_dir_ofs + header_len >= MZ_UINT32_MAX) {
+    err = ZIP_EWRTDIR;
+    goto cleanup;
+  }
+  {
+    mz_uint32 ofs32 = (mz_uint32)central_dir_ofs;
+    if (!mz_zip_array_push_back(pzip, &pzip->m_pState->m_central_dir,
+                                pSrcHeader, header_len) ||
+        !mz_zip_array_push_back(pzip, &pzip->m_pState->m_central_dir_offsets,
+                                &ofs32, 1)) {
+      // keep the central directory consistent
+      mz_zip_array_resize(pzip, &pzip->m_pState->m_central_dir,
+                          central_dir_ofs, MZ_FALSE);
+      err = ZIP_EOOMEM;
+      goto cleanup;
+    }
+  }
+  pHeader = (mz_uint8 *)pzip->m_pState->m_central_dir.m_p + central_dir_ofs;
+  if ((err = zip_central_dir_set_offset(pHeader, dst_ofs)) < 0) {
+    mz_zip_array_resize(pzip, &pzip->m_pState->m_central_dir, central_dir_ofs,
+                        MZ_FALSE);
+    mz_zip_array_resize(pzip, &pzip->m_pState->m_central_dir_offsets,
+                        pzip->m_total_files, MZ_FALSE);
+    goto cleanup;
+  }
+  pzip->m_total_files++;
+  pzip->m_archive_size += length;
+
+cleanup:
+  CLEANUP(copy_buf);
   return err;
 }
 
@@ -1989,6 +6025,10 @@ void zip_stream_close(struct zip_t *zip) {
   if (zip) {
     mz_zip_writer_end(&(zip->archive));
     mz_zip_reader_end(&(zip->archive));
+    zip_seek_index_free(zip->seek_index);
+    zip_name_index_free(&zip->name_index);
+    CLEANUP(zip->entry.comp);
+    CLEANUP(zip->dir_window);
     CLEANUP(zip);
   }
 }
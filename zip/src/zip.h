@@ -61,6 +61,12 @@ typedef long ssize_t; /* byte count or error */
  */
 #define ZIP_DEFAULT_COMPRESSION_LEVEL 6
 
+/**
+ * Default distance (in bytes of uncompressed data) between seek index
+ * checkpoints.
+ */
+#define ZIP_DEFAULT_SEEK_SPAN (1 << 20)
+
 /**
  * Error codes
  */
@@ -98,6 +104,9 @@ typedef long ssize_t; /* byte count or error */
 #define ZIP_EWRINIT -32     // cannot initialize writer from reader
 #define ZIP_EINVAL -33      // invalid argument
 #define ZIP_ENORITER -34    // cannot initialize reader iterator
+#define ZIP_EINFLATE -35    // cannot inflate entry data
+#define ZIP_EINVIDXFILE -36 // invalid index file
+#define ZIP_ECRC -37        // crc32 mismatch
 
 /**
  * Looks up the error message string corresponding to an error number.
@@ -122,6 +131,15 @@ struct zip_t;
  * @param level compression level (0-9 are the standard zlib-style levels).
  * @param mode file access mode.
  *        - 'r': opens a file for reading/extracting (the file must exists).
+ *          A valid zipname.zidx sidecar (see zip_dirindex_save) is used to
+ *          skip parsing the central directory.
+ *        - 's': opens a file for reading with memory bounded independently
+ *          of the number of entries. The central directory is not loaded but
+ *          streamed from the file through a fixed window whenever it is
+ *          needed. Entries are enumerated with zip_entries_foreach and
+ *          zip_entries_prefix and read through cursors, whose lookups then
+ *          scan the directory unless the entry is opened with
+ *          zip_cursor_entry_openinfo; zip_entry_open returns ZIP_EINVMODE.
  *        - 'w': creates an empty file for writing.
  *        - 'a': appends to an existing archive.
  *
@@ -138,6 +156,7 @@ extern ZIP_EXPORT struct zip_t *zip_open(const char *zipname, int level,
  * @param level compression level (0-9 are the standard zlib-style levels).
  * @param mode file access mode.
  *        - 'r': opens a file for reading/extracting (the file must exists).
+ *        - 's': like 'r', streaming the central directory (see zip_open).
  *        - 'w': creates an empty file for writing.
  *        - 'a': appends to an existing archive.
  * @param errnum 0 on success, negative number (< 0) on error.
@@ -164,6 +183,37 @@ extern ZIP_EXPORT void zip_close(struct zip_t *zip);
  */
 extern ZIP_EXPORT int zip_is64(struct zip_t *zip);
 
+/**
+ * Makes the data of entries stored without compression start at a multiple
+ * of alignment in the archive, so it can be mapped straight out of the file.
+ * The padding goes into the local header's extra field, as zipalign does.
+ * Applies to the entries opened afterwards; directories are not padded.
+ *
+ * @param zip zip archive handler (opened in 'w' or 'a' mode).
+ * @param alignment a power of two up to 32768, 0 disables the alignment.
+ *
+ * @note the padding is sized when the entry is written. zip_entries_delete,
+ *       zip_compact and zip_entry_rawcopy move local records by arbitrary
+ *       amounts without re-padding them, so the entries they move lose the
+ *       alignment.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_set_alignment(struct zip_t *zip,
+                                        unsigned int alignment);
+
+/**
+ * Changes the compression level of the entries opened afterwards, e.g. to
+ * store some entries without compression. Must not be called while an entry
+ * is open.
+ *
+ * @param zip zip archive handler (opened in 'w' or 'a' mode).
+ * @param level compression level (0-9), negative for the default level.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_set_level(struct zip_t *zip, int level);
+
 /**
  * Returns the offset in the stream where the zip header is located.
  *
@@ -297,6 +347,52 @@ extern ZIP_EXPORT unsigned long long zip_entry_comp_size(struct zip_t *zip);
  */
 extern ZIP_EXPORT unsigned int zip_entry_crc32(struct zip_t *zip);
 
+/**
+ * Returns the compression method of the current zip entry.
+ *
+ * @param zip zip archive handler.
+ *
+ * @return the method from the central directory (0 stored, 8 deflated), or
+ *         negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_method(struct zip_t *zip);
+
+/**
+ * Returns the last modification time of the current zip entry.
+ *
+ * @param zip zip archive handler.
+ *
+ * @return the modification time in seconds since the Unix epoch (the DOS
+ *         timestamp of the entry is interpreted as local time).
+ */
+extern ZIP_EXPORT long long zip_entry_mtime(struct zip_t *zip);
+
+/**
+ * Computes CRC-32 checksum of a buffer, the same one stored for zip entries.
+ *
+ * @param crc checksum of the preceding data, 0 for the first buffer.
+ * @param buf input buffer.
+ * @param bufsize input buffer size (in bytes).
+ *
+ * @return the CRC-32 checksum.
+ */
+extern ZIP_EXPORT unsigned int zip_crc32(unsigned int crc, const void *buf,
+                                         size_t bufsize);
+
+/**
+ * Compresses a buffer into a raw deflate stream, the format of DEFLATED zip
+ * entry data.
+ *
+ * @param buf input buffer.
+ * @param bufsize input buffer size (in bytes).
+ * @param level compression level (0-10), negative for the default.
+ * @param outsize receives the size of the compressed data.
+ *
+ * @return the compressed data, to be released with free(), or NULL on error.
+ */
+extern ZIP_EXPORT void *zip_deflate_mem(const void *buf, size_t bufsize,
+                                        int level, size_t *outsize);
+
 /**
  * Returns byte offset of the current zip entry
  * in the archive's central directory.
@@ -316,6 +412,24 @@ extern ZIP_EXPORT unsigned long long zip_entry_dir_offset(struct zip_t *zip);
  */
 extern ZIP_EXPORT unsigned long long zip_entry_header_offset(struct zip_t *zip);
 
+/**
+ * Locates the data of the current zip entry when it is stored without
+ * compression or encryption, so callers can copy it straight from the
+ * archive file (e.g. with sendfile) instead of going through zip_entry_read.
+ *
+ * The offset is absolute in the archive file, or in the memory buffer for
+ * archives opened with zip_stream_open. The data is comp_size bytes long and
+ * its CRC-32 is not verified.
+ *
+ * @param zip zip archive handler.
+ * @param offset the offset of the entry data.
+ *
+ * @return the return code - 0 on success, ZIP_EINVENTTYPE if the entry is
+ *         compressed or encrypted, negative number (< 0) on other errors.
+ */
+extern ZIP_EXPORT int zip_entry_rawoffset(struct zip_t *zip,
+                                          unsigned long long *offset);
+
 /**
  * Sets the Unix permission bits for the current zip entry (to be stored
  * in the external file attributes field). Should be called after
@@ -327,6 +441,16 @@ extern ZIP_EXPORT unsigned long long zip_entry_header_offset(struct zip_t *zip);
  */
 extern ZIP_EXPORT void zip_entry_set_unix_permissions(struct zip_t *zip, unsigned int mode, int is_dir);
 
+/**
+ * Sets the last modification time of the zip entry opened for writing.
+ *
+ * @param zip zip archive handler.
+ * @param mtime seconds since the Unix epoch, stored as local DOS time.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_set_mtime(struct zip_t *zip, long long mtime);
+
 /**
  * Compresses an input buffer for the current zip entry.
  *
@@ -339,6 +463,26 @@ extern ZIP_EXPORT void zip_entry_set_unix_permissions(struct zip_t *zip, unsigne
 extern ZIP_EXPORT int zip_entry_write(struct zip_t *zip, const void *buf,
                                       size_t bufsize);
 
+/**
+ * Writes already compressed data to the zip entry opened for writing,
+ * instead of zip_entry_write. May be called several times to append chunks;
+ * uncomp_size and crc32 describe the whole entry and the values of the last
+ * call are stored.
+ *
+ * @param zip zip archive handler.
+ * @param buf compressed data (a raw deflate stream for MZ_DEFLATED).
+ * @param bufsize compressed data size (in bytes).
+ * @param method compression method, 0 (stored) or 8 (deflated).
+ * @param uncomp_size uncompressed size of the entry.
+ * @param crc32 CRC-32 of the uncompressed data.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_rawwrite(struct zip_t *zip, const void *buf,
+                                         size_t bufsize, int method,
+                                         unsigned long long uncomp_size,
+                                         unsigned int crc32);
+
 /**
  * Compresses a file for the current zip entry.
  *
@@ -396,8 +540,11 @@ extern ZIP_EXPORT ssize_t zip_entry_noallocread(struct zip_t *zip, void *buf,
  * @param size requested number of bytes (in bytes).
  * @param buf preallocated output buffer.
  *
- * @note the iterator api uses an allocation to create its state
- * @note each call will iterate from the start of the entry
+ * @note an allocation is used to create the inflate state
+ * @note stored entries are read in place. Deflated entries are inflated from
+ *       the start of the entry, or from the nearest checkpoint if a seek
+ *       index has been built (zip_entry_seekindex) or loaded
+ *       (zip_seekindex_load) for the entry.
  *
  * @return the return code - the number of bytes actually read on success.
  *         Otherwise a negative number (< 0) on error (e.g. offset is too
@@ -408,6 +555,343 @@ extern ZIP_EXPORT ssize_t zip_entry_noallocreadwithoffset(struct zip_t *zip,
                                                           size_t size,
                                                           void *buf);
 
+/**
+ * Builds a seek index for the current zip entry.
+ *
+ * The entry is inflated once and the inflate state together with its 32 KB
+ * window is saved every span bytes of uncompressed data. The index is cached
+ * in the zip archive handler, so later zip_entry_noallocreadwithoffset calls
+ * resume from the nearest checkpoint instead of the start of the entry.
+ * Each checkpoint costs about 43 KB of memory.
+ *
+ * @param zip zip archive handler (opened in 'r' mode).
+ * @param span distance between checkpoints (in bytes), 0 selects
+ *        ZIP_DEFAULT_SEEK_SPAN.
+ *
+ * @note stored entries can be read in place and need no index.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_seekindex(struct zip_t *zip, size_t span);
+
+/**
+ * Saves all seek indexes cached in the zip archive handler into a sidecar
+ * file.
+ *
+ * @param zip zip archive handler.
+ * @param filename output file.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_seekindex_save(struct zip_t *zip,
+                                         const char *filename);
+
+/**
+ * Loads seek indexes from a sidecar file written by zip_seekindex_save.
+ *
+ * Every index is validated against the entry it describes (local header
+ * offset, sizes and CRC-32) and every checkpoint against its own CRC-32.
+ * Nothing is loaded if any of them does not match.
+ *
+ * @param zip zip archive handler (opened in 'r' mode).
+ * @param filename sidecar file.
+ *
+ * @note the inflate state is stored in the native layout, so the sidecar is
+ *       only accepted by builds with the same miniz version, state layout and
+ *       byte order; others get ZIP_EINVIDXFILE and nothing is rebuilt. The
+ *       caller must then rebuild the indexes with zip_entry_seekindex and
+ *       save them again with zip_seekindex_save.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_seekindex_load(struct zip_t *zip,
+                                         const char *filename);
+
+/**
+ * Saves the central directory index of the archive (the offsets of the
+ * records and the name hash table) into a sidecar file. zip_open in 'r' mode
+ * picks up zipname.zidx when its recorded archive size and central directory
+ * CRC-32 still match, reading the central directory in one piece instead of
+ * parsing every record and hashing every name. A stale index is ignored.
+ *
+ * @param zip zip archive handler (opened in 'r' mode from a file).
+ * @param filename output file, normally the archive name + ".zidx".
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_dirindex_save(struct zip_t *zip,
+                                        const char *filename);
+
+/**
+ * @struct zip_reader_t
+ *
+ * Pull-style reader over the data of a single zip entry - forward
+ * declaration.
+ */
+struct zip_reader_t;
+
+/**
+ * Opens a reader over the current zip entry.
+ *
+ * The reader inflates the entry incrementally through a bounded internal
+ * buffer (about 110 KB regardless of the entry size) and verifies the
+ * CRC-32 and size once the end of the data is reached. It does not depend on
+ * the current entry afterwards, but must be closed before the zip archive.
+ *
+ * @param zip zip archive handler (opened in 'r' mode).
+ * @param errnum 0 on success, negative number (< 0) on error. May be NULL.
+ *
+ * @return the reader handler or NULL on error.
+ */
+extern ZIP_EXPORT struct zip_reader_t *zip_reader_open(struct zip_t *zip,
+                                                       int *errnum);
+
+/**
+ * Reads the next bytes of the entry into a caller supplied buffer.
+ *
+ * @param reader reader handler.
+ * @param buf output buffer.
+ * @param bufsize output buffer size (in bytes).
+ *
+ * @return the return code - the number of bytes read, 0 at the end of the
+ *         entry, negative number (< 0) on error (ZIP_ECRC if the data does
+ *         not match its CRC-32 or size).
+ */
+extern ZIP_EXPORT ssize_t zip_reader_read(struct zip_reader_t *reader,
+                                          void *buf, size_t bufsize);
+
+/**
+ * Returns the next chunk of the entry without copying it.
+ *
+ * @param reader reader handler.
+ * @param chunk receives a pointer into the reader's internal buffer, valid
+ *        until the next call on the reader.
+ *
+ * @return the return code - the chunk size, 0 at the end of the entry,
+ *         negative number (< 0) on error (ZIP_ECRC if the data does not
+ *         match its CRC-32 or size).
+ */
+extern ZIP_EXPORT ssize_t zip_reader_next(struct zip_reader_t *reader,
+                                          const void **chunk);
+
+/**
+ * Closes the reader and releases its resources.
+ *
+ * @param reader reader handler.
+ */
+extern ZIP_EXPORT void zip_reader_close(struct zip_reader_t *reader);
+
+/**
+ * @struct zip_cursor_t
+ *
+ * Independent read cursor over a zip archive opened in 'r' mode - forward
+ * declaration.
+ */
+struct zip_cursor_t;
+
+/**
+ * Opens a read cursor sharing the parsed central directory of the archive.
+ *
+ * Every cursor keeps its own entry and inflate state and reads the archive
+ * with positional reads, so different cursors may be used concurrently from
+ * different threads. Opening a cursor is not thread-safe itself: the first
+ * call builds the entry name index of the archive. All cursors must be closed
+ * before the zip archive.
+ *
+ * In 's' mode no name index is built; every lookup by name or index scans
+ * the streamed central directory.
+ *
+ * @param zip zip archive handler (opened in 'r' or 's' mode).
+ * @param errnum 0 on success, negative number (< 0) on error. May be NULL.
+ *
+ * @return the cursor handler or NULL on error.
+ */
+extern ZIP_EXPORT struct zip_cursor_t *zip_cursor_open(struct zip_t *zip,
+                                                       int *errnum);
+
+/**
+ * Opens an entry by name in the cursor. The lookup is case-insensitive, as
+ * for zip_entry_open.
+ *
+ * @param cursor cursor handler.
+ * @param entryname an entry name in local dictionary.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_cursor_entry_open(struct zip_cursor_t *cursor,
+                                            const char *entryname);
+
+/**
+ * Opens an entry by name in the cursor. The lookup is case-sensitive.
+ *
+ * @param cursor cursor handler.
+ * @param entryname an entry name in local dictionary.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int
+zip_cursor_entry_opencasesensitive(struct zip_cursor_t *cursor,
+                                   const char *entryname);
+
+/**
+ * Opens an entry by index in the cursor.
+ *
+ * @param cursor cursor handler.
+ * @param index index in local dictionary.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_cursor_entry_openbyindex(struct zip_cursor_t *cursor,
+                                                   size_t index);
+
+struct zip_entry_info_t;
+
+/**
+ * Opens the entry described by info in the cursor.
+ *
+ * info must come from zip_entries_foreach on the archive of the cursor. The
+ * record is not looked up again, so in 's' mode this avoids a scan of the
+ * central directory per entry.
+ *
+ * @param cursor cursor handler.
+ * @param info entry information passed to the foreach callback.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int
+zip_cursor_entry_openinfo(struct zip_cursor_t *cursor,
+                          const struct zip_entry_info_t *info);
+
+/**
+ * Closes the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_cursor_entry_close(struct zip_cursor_t *cursor);
+
+/**
+ * Returns the name of the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the pointer to the entry name (valid until the entry is closed) or
+ *         NULL on error.
+ */
+extern ZIP_EXPORT const char *
+zip_cursor_entry_name(struct zip_cursor_t *cursor);
+
+/**
+ * Returns the index of the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the index on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_cursor_entry_index(struct zip_cursor_t *cursor);
+
+/**
+ * Determines if the current entry of the cursor is a directory.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the return code - 1 (true), 0 (false), negative number (< 0) on
+ *         error.
+ */
+extern ZIP_EXPORT int zip_cursor_entry_isdir(struct zip_cursor_t *cursor);
+
+/**
+ * Returns the uncompressed size of the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the uncompressed size in bytes.
+ */
+extern ZIP_EXPORT unsigned long long
+zip_cursor_entry_size(struct zip_cursor_t *cursor);
+
+/**
+ * Returns the compressed size of the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the compressed size in bytes.
+ */
+extern ZIP_EXPORT unsigned long long
+zip_cursor_entry_comp_size(struct zip_cursor_t *cursor);
+
+/**
+ * Returns CRC-32 checksum of the current entry of the cursor.
+ *
+ * @param cursor cursor handler.
+ *
+ * @return the CRC-32 checksum.
+ */
+extern ZIP_EXPORT unsigned int
+zip_cursor_entry_crc32(struct zip_cursor_t *cursor);
+
+/**
+ * Extracts the current entry of the cursor into a memory buffer using no
+ * memory allocation.
+ *
+ * @param cursor cursor handler.
+ * @param buf preallocated output buffer.
+ * @param bufsize output buffer size (in bytes).
+ *
+ * @return the return code - the number of bytes actually read on success.
+ *         Otherwise a negative number (< 0) on error (e.g. bufsize is not
+ *         large enough).
+ */
+extern ZIP_EXPORT ssize_t
+zip_cursor_entry_noallocread(struct zip_cursor_t *cursor, void *buf,
+                             size_t bufsize);
+
+/**
+ * Extracts the current entry of the cursor using a callback function
+ * (on_extract). The CRC-32 and size of the data are verified at the end.
+ *
+ * @param cursor cursor handler.
+ * @param on_extract callback function.
+ * @param arg opaque pointer (optional argument, which you can pass to the
+ *        on_extract callback)
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int
+zip_cursor_entry_extract(struct zip_cursor_t *cursor,
+                         size_t (*on_extract)(void *arg, uint64_t offset,
+                                              const void *data, size_t size),
+                         void *arg);
+
+/**
+ * Passes the compressed data of the current entry of the cursor to a
+ * callback function (on_extract) as stored in the archive, e.g. a raw
+ * deflate stream for MZ_DEFLATED entries. Nothing is inflated and the CRC-32
+ * is not verified; use zip_cursor_entry_crc32 and zip_cursor_entry_size to
+ * describe the data.
+ *
+ * @param cursor cursor handler.
+ * @param on_extract callback function.
+ * @param arg opaque pointer (optional argument, which you can pass to the
+ *        on_extract callback)
+ *
+ * @return the return code - 0 on success, ZIP_EINVENTTYPE for directories,
+ *         negative number (< 0) on other errors.
+ */
+extern ZIP_EXPORT int
+zip_cursor_entry_rawextract(struct zip_cursor_t *cursor,
+                            size_t (*on_extract)(void *arg, uint64_t offset,
+                                                 const void *data, size_t size),
+                            void *arg);
+
+/**
+ * Closes the cursor and releases its resources.
+ *
+ * @param cursor cursor handler.
+ */
+extern ZIP_EXPORT void zip_cursor_close(struct zip_cursor_t *cursor);
+
 /**
  * Extracts the current zip entry into output file.
  *
@@ -445,6 +929,138 @@ zip_entry_extract(struct zip_t *zip,
  */
 extern ZIP_EXPORT ssize_t zip_entries_total(struct zip_t *zip);
 
+/**
+ * @struct zip_entry_info_t
+ *
+ * Central directory record of an entry as seen by zip_entries_foreach.
+ * The name points into the central directory and is not NUL-terminated;
+ * it stays valid until the archive is modified or closed. The modification
+ * time is the raw MS-DOS date and time (local time).
+ */
+struct zip_entry_info_t {
+  size_t index;
+  const char *name;
+  size_t namelen;
+  int isdir;
+  int method;
+  unsigned int crc32;
+  unsigned long long uncomp_size;
+  unsigned long long comp_size;
+  unsigned long long header_offset;
+  unsigned int external_attr;
+  unsigned short dos_date;
+  unsigned short dos_time;
+  unsigned short bit_flag;
+};
+
+/**
+ * Visits every entry in central directory order by decoding the records in
+ * place, without allocating or copying names and without touching the
+ * current entry of the handler. ZIP64 sizes and offsets are resolved.
+ * In 's' mode the records are read in windows and info->name is only valid
+ * during the callback.
+ *
+ * Returning a non-zero value from on_entry stops the iteration.
+ *
+ * @param zip zip archive handler.
+ * @param on_entry callback invoked with each entry's record.
+ * @param arg opaque pointer.
+ *
+ * @return the number of visited entries, or negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t
+zip_entries_foreach(struct zip_t *zip,
+                    int (*on_entry)(void *arg,
+                                    const struct zip_entry_info_t *info),
+                    void *arg);
+
+/**
+ * Visits the entries whose names start with the given prefix.
+ *
+ * In 'r' mode the lookup is a binary search over a byte-wise sorted name
+ * index that is built on first use; entries are visited in name order. In
+ * the other modes, 's' included, the central directory is scanned in order
+ * and in 's' the name is only valid during the callback. The index is built
+ * lazily, so concurrent calls on the same handler are not thread-safe.
+ *
+ * The name passed to on_entry points into the central directory and is not
+ * NUL-terminated. Returning a non-zero value from on_entry stops the
+ * iteration.
+ *
+ * @param zip zip archive handler.
+ * @param prefix name prefix, an empty string visits all entries.
+ * @param on_entry callback invoked with the entry index and its name.
+ * @param arg opaque pointer.
+ *
+ * @return the number of visited entries, or negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t
+zip_entries_prefix(struct zip_t *zip, const char *prefix,
+                   int (*on_entry)(void *arg, size_t index, const char *name,
+                                   size_t namelen),
+                   void *arg);
+
+/**
+ * @struct zip_entry_span_t
+ *
+ * Place of one entry inside an arena shared by a batch of entries, see
+ * zip_entries_layout. A span whose err is not 0 is skipped by the reads and
+ * takes no room in the arena.
+ */
+struct zip_entry_span_t {
+  size_t index;
+  size_t offset;
+  size_t size;
+  int err;
+};
+
+/**
+ * Lays a batch of entries out in one contiguous arena, using the
+ * uncompressed sizes from the central directory. Nothing is read from the
+ * local records; allocate the returned number of bytes once and fill it with
+ * zip_cursor_entries_read.
+ *
+ * With names the entries are looked up through the name index, the same way
+ * as zip_cursor_entry_open, and spans[i].index is filled in. Without names the
+ * indices must already be set in spans. Missing entries get ZIP_ENOENT (or
+ * ZIP_EINVIDX) and directories ZIP_EINVENTTYPE in their err field. The name
+ * index is built on first use, so do not call it concurrently with other
+ * lookups on the same handler.
+ *
+ * Only valid in read ('r') mode.
+ *
+ * @param zip zip archive handler.
+ * @param names entry names, or NULL to use spans[i].index.
+ * @param spans array of n spans to fill.
+ * @param n the number of entries.
+ *
+ * @return the arena size in bytes, or negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_entries_layout(struct zip_t *zip,
+                                             const char *const names[],
+                                             struct zip_entry_span_t *spans,
+                                             size_t n);
+
+/**
+ * Inflates the entries of spans laid out by zip_entries_layout into arena,
+ * verifying their CRC-32. Spans that fail get the error code in their err
+ * field and the rest of the batch is still read.
+ *
+ * The spans never overlap, so cursors on different threads may each read a
+ * separate range of the same spans array into the same arena.
+ *
+ * @param cursor cursor handler.
+ * @param spans array of n spans.
+ * @param n the number of spans.
+ * @param arena output buffer of the size returned by zip_entries_layout.
+ *
+ * @return the number of spans read without error, or negative number (< 0)
+ *         on error.
+ */
+extern ZIP_EXPORT ssize_t
+zip_cursor_entries_read(struct zip_cursor_t *cursor,
+                        struct zip_entry_span_t *spans, size_t n, void *arena);
+
 /**
  * Deletes zip archive entries.
  *
@@ -468,6 +1084,96 @@ extern ZIP_EXPORT ssize_t zip_entries_deletebyindex(struct zip_t *zip,
                                                     size_t entries[],
                                                     size_t len);
 
+/**
+ * Deletes zip archive entries by dropping their central directory records
+ * only. The local records stay in the file as dead space until
+ * zip_compact is called, so the cost does not depend on the archive size.
+ *
+ * Only valid in append ('a') and delete ('d') modes.
+ *
+ * @param zip zip archive handler.
+ * @param entries array of zip archive entries to be deleted.
+ * @param len the number of entries to be deleted.
+ * @return the number of deleted entries, or negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_entries_unlink(struct zip_t *zip,
+                                             char *const entries[], size_t len);
+
+/**
+ * Replaces the content of an existing entry.
+ *
+ * The buffer is compressed with the archive's compression level. When the new
+ * local record fits into the space of the old one (up to the next local
+ * record) it is overwritten in place and only the central directory record is
+ * updated; otherwise the old record is unlinked and the entry is appended.
+ * An interrupted in-place replacement leaves the entry corrupted.
+ *
+ * Only valid in append ('a') and delete ('d') modes.
+ *
+ * @param zip zip archive handler.
+ * @param entryname name of the entry to replace.
+ * @param buf new entry content.
+ * @param bufsize size of the content.
+ *
+ * @return the return code - 0 when written in place, 1 when appended,
+ *         negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_replace(struct zip_t *zip,
+                                        const char *entryname, const void *buf,
+                                        size_t bufsize);
+
+/**
+ * Reports how much of the local record area is still referenced by the
+ * central directory.
+ *
+ * @param zip zip archive handler.
+ * @param used bytes taken by local records of the entries.
+ * @param size bytes in front of the central directory.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_archive_usage(struct zip_t *zip,
+                                        unsigned long long *used,
+                                        unsigned long long *size);
+
+/**
+ * Reclaims the dead space left by unlinked or replaced entries in one pass
+ * over the local records in file order; entry data is moved, never
+ * recompressed.
+ *
+ * Only valid in append ('a') and delete ('d') modes. The file is truncated
+ * when the archive is closed.
+ *
+ * @param zip zip archive handler.
+ * @param reclaimed number of bytes removed, may be NULL.
+ *
+ * @note records are moved as they are, entries written with
+ *       zip_set_alignment are no longer aligned once moved.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_compact(struct zip_t *zip,
+                                  unsigned long long *reclaimed);
+
+/**
+ * Appends an entry of another archive without recompressing it. The local
+ * record is copied byte for byte (with copy_file_range on Linux when both
+ * archives are files), and the central directory record is reused with the
+ * new local header offset.
+ *
+ * @param zip zip archive handler opened for writing ('w', 'a' or 'd').
+ * @param source zip archive handler opened for reading ('r').
+ * @param index index of the entry in the source archive.
+ *
+ * @note the alignment padding of the source record is copied as is, it does
+ *       not align the data at the new offset and zip_set_alignment of zip is
+ *       not applied.
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_rawcopy(struct zip_t *zip,
+                                        struct zip_t *source, size_t index);
+
 /**
  * Extracts a zip archive stream into directory.
  *
@@ -390,6 +390,305 @@ MU_TEST(test_entries_delete) {
   zip_close(zip);
 }
 
+#define LARGESIZE (2 * 1024 * 1024 + 17)
+
+static void fill_large(char *data, size_t size, unsigned int seed) {
+  size_t i;
+  for (i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = (char)(seed >> 16);
+  }
+}
+
+MU_TEST(test_entries_delete_large) {
+  char *entries[] = {"large.bin"};
+  char *large = (char *)malloc(LARGESIZE);
+  char *tail = (char *)malloc(LARGESIZE);
+  char *buf = (char *)malloc(LARGESIZE);
+  mu_check(large != NULL && tail != NULL && buf != NULL);
+  fill_large(large, LARGESIZE, 1);
+  fill_large(tail, LARGESIZE, 2);
+
+  // stored, so the hole is larger than the 1 MiB move buffer and the
+  // records behind it take the copy_file_range path on Linux
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'a');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "large.bin"));
+  mu_assert_int_eq(0, zip_entry_write(zip, large, LARGESIZE));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "after.txt"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "tail.bin"));
+  mu_assert_int_eq(0, zip_entry_write(zip, tail, LARGESIZE));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'd');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(1, zip_entries_delete(zip, entries, 1));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(total_entries + 2, zip_entries_total(zip));
+  mu_assert_int_eq(ZIP_ENOENT, zip_entry_open(zip, "large.bin"));
+  mu_assert_int_eq(0, zip_entry_open(zip, "after.txt"));
+  mu_assert_int_eq(strlen(TESTDATA1),
+                   zip_entry_noallocread(zip, buf, LARGESIZE));
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "tail.bin"));
+  mu_assert_int_eq(LARGESIZE, zip_entry_noallocread(zip, buf, LARGESIZE));
+  mu_assert_int_eq(0, memcmp(buf, tail, LARGESIZE));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "delete/file.4"));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_entry_noallocread(zip, buf, LARGESIZE));
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA2, strlen(TESTDATA2)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  free(large);
+  free(tail);
+  free(buf);
+}
+
+static unsigned char *put_le(unsigned char *p, unsigned long long value,
+                             int n) {
+  int i;
+  for (i = 0; i < n; ++i) {
+    *p++ = (unsigned char)(value >> (8 * i));
+  }
+  return p;
+}
+
+static unsigned char *put_local(unsigned char *p, const char *name,
+                                const char *data, unsigned int crc32) {
+  p = put_le(p, 0x04034b50, 4);
+  p = put_le(p, 20, 2);
+  p = put_le(p, 0, 2 * 4); // flags, method, time, date
+  p = put_le(p, crc32, 4);
+  p = put_le(p, strlen(data), 4);
+  p = put_le(p, strlen(data), 4);
+  p = put_le(p, strlen(name), 2);
+  p = put_le(p, 0, 2);
+  memcpy(p, name, strlen(name));
+  p += strlen(name);
+  memcpy(p, data, strlen(data));
+  return p + strlen(data);
+}
+
+MU_TEST(test_entries_delete_zip64_offset) {
+  char ZIP64NAME[L_tmpnam + 1] = {0};
+  unsigned char archive[512], *p = archive, *cdir, *cdir_end;
+  const unsigned int crc1 = zip_crc32(0, TESTDATA1, strlen(TESTDATA1));
+  unsigned long long second_ofs;
+  char buf[64] = {0};
+  char *entries[] = {"a.txt"};
+  FILE *fp;
+
+  // "b.txt" has its local header offset and sizes saturated and stored in
+  // the zip64 extended information field, as archives past 4 GiB do
+  p = put_local(p, "a.txt", TESTDATA1, crc1);
+  second_ofs = (unsigned long long)(p - archive);
+  p = put_local(p, "b.txt", TESTDATA2, CRC32DATA2);
+  cdir = p;
+  p = put_le(p, 0x02014b50, 4);
+  p = put_le(p, 20, 2);
+  p = put_le(p, 20, 2);
+  p = put_le(p, 0, 2 * 4);
+  p = put_le(p, crc1, 4);
+  p = put_le(p, strlen(TESTDATA1), 4);
+  p = put_le(p, strlen(TESTDATA1), 4);
+  p = put_le(p, 5, 2);
+  p = put_le(p, 0, 2 * 4 + 4 + 4); // extra, comment, disk, attrs, offset
+  memcpy(p, "a.txt", 5);
+  p += 5;
+  p = put_le(p, 0x02014b50, 4);
+  p = put_le(p, 45, 2);
+  p = put_le(p, 45, 2);
+  p = put_le(p, 0, 2 * 4);
+  p = put_le(p, CRC32DATA2, 4);
+  p = put_le(p, 0xFFFFFFFF, 4);
+  p = put_le(p, 0xFFFFFFFF, 4);
+  p = put_le(p, 5, 2);
+  p = put_le(p, 4 + 24, 2);
+  p = put_le(p, 0, 2 * 3 + 4);
+  p = put_le(p, 0xFFFFFFFF, 4);
+  memcpy(p, "b.txt", 5);
+  p += 5;
+  p = put_le(p, 0x0001, 2);
+  p = put_le(p, 24, 2);
+  p = put_le(p, strlen(TESTDATA2), 8);
+  p = put_le(p, strlen(TESTDATA2), 8);
+  p = put_le(p, second_ofs, 8);
+  cdir_end = p;
+  p = put_le(p, 0x06054b50, 4);
+  p = put_le(p, 0, 2 * 2);
+  p = put_le(p, 2, 2);
+  p = put_le(p, 2, 2);
+  p = put_le(p, (unsigned long long)(cdir_end - cdir), 4);
+  p = put_le(p, (unsigned long long)(cdir - archive), 4);
+  p = put_le(p, 0, 2);
+
+  strncpy(ZIP64NAME, "z-XXXXXX\0", L_tmpnam);
+  MKTEMP(ZIP64NAME);
+  fp = fopen(ZIP64NAME, "wb");
+  mu_check(fp != NULL);
+  mu_assert_int_eq(p - archive, fwrite(archive, 1, p - archive, fp));
+  fclose(fp);
+
+  struct zip_t *zip = zip_open(ZIP64NAME, 0, 'd');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(1, zip_entries_delete(zip, entries, 1));
+  zip_close(zip);
+
+  // the offset is rewritten inside the zip64 field, behind both sizes
+  zip = zip_open(ZIP64NAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(1, zip_entries_total(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "b.txt"));
+  mu_assert_int_eq(0, zip_entry_header_offset(zip));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_entry_noallocread(zip, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+  UNLINK(ZIP64NAME);
+}
+
+MU_TEST(test_entries_unlink) {
+  char *entries[] = {"delete.me", "delete/file.1"};
+  unsigned long long used = 0, size = 0, reclaimed = 0;
+  char data[1024];
+  unsigned int seed = 1;
+  size_t i;
+  for (i = 0; i < sizeof(data); ++i) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = (char)(seed >> 16);
+  }
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'd');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(2, zip_entries_unlink(zip, entries, 2));
+  mu_assert_int_eq(0, zip_archive_usage(zip, &used, &size));
+  mu_check(used < size);
+  // same size, overwritten in place
+  mu_assert_int_eq(
+      0, zip_entry_replace(zip, "delete/file.2", TESTDATA1, strlen(TESTDATA1)));
+  // does not fit, appended
+  mu_assert_int_eq(1, zip_entry_replace(zip, "_", data, sizeof(data)));
+  mu_assert_int_eq(ZIP_ENOENT, zip_entry_replace(zip, "delete.me", data, 1));
+
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'd');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_compact(zip, &reclaimed));
+  mu_check(reclaimed > 0);
+  mu_assert_int_eq(0, zip_archive_usage(zip, &used, &size));
+  mu_assert_int_eq(size, used);
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(total_entries - 2, zip_entries_total(zip));
+  mu_assert_int_eq(ZIP_ENOENT, zip_entry_open(zip, "delete.me"));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  size_t buftmp = 0;
+  char *buf = NULL;
+  mu_assert_int_eq(0, zip_entry_open(zip, "delete/file.2"));
+  ssize_t bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(strlen(TESTDATA1), bufsize);
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA1, bufsize));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+  buf = NULL;
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "_"));
+  bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(sizeof(data), bufsize);
+  mu_assert_int_eq(0, memcmp(buf, data, sizeof(data)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+  buf = NULL;
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "delete/file.4"));
+  bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(strlen(TESTDATA2), bufsize);
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA2, bufsize));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+  buf = NULL;
+
+  zip_close(zip);
+
+  // deflated and too large for the slot, the compressed buffer is appended
+  char *large = (char *)malloc(8 * sizeof(data));
+  mu_check(large != NULL);
+  for (i = 0; i < 8; ++i) {
+    memcpy(large + i * sizeof(data), data, sizeof(data));
+  }
+  zip = zip_open(ZIPNAME, ZIP_DEFAULT_COMPRESSION_LEVEL, 'd');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(
+      1, zip_entry_replace(zip, "delete/file.4", large, 8 * sizeof(data)));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "delete/file.4"));
+  mu_check(zip_entry_comp_size(zip) < 8 * sizeof(data));
+  bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(8 * sizeof(data), bufsize);
+  mu_assert_int_eq(0, memcmp(buf, large, 8 * sizeof(data)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+  free(large);
+  zip_close(zip);
+}
+
+MU_TEST(test_entry_rawcopy) {
+  char COPYNAME[L_tmpnam + 1] = {0};
+  strncpy(COPYNAME, "z-XXXXXX\0", L_tmpnam);
+  MKTEMP(COPYNAME);
+
+  struct zip_t *source = zip_open(ZIPNAME, 0, 'r');
+  mu_check(source != NULL);
+  struct zip_t *zip = zip_open(COPYNAME, 0, 'w');
+  mu_check(zip != NULL);
+
+  int i = 0, n = zip_entries_total(source);
+  for (; i < n; ++i) {
+    mu_assert_int_eq(0, zip_entry_rawcopy(zip, source, i));
+  }
+  mu_assert_int_eq(ZIP_EINVIDX, zip_entry_rawcopy(zip, source, n));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entry_rawcopy(source, zip, 0));
+  zip_close(zip);
+  zip_close(source);
+
+  zip = zip_open(COPYNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(total_entries, zip_entries_total(zip));
+
+  size_t buftmp = 0;
+  char *buf = NULL;
+  mu_assert_int_eq(0, zip_entry_open(zip, "delete/file.4"));
+  ssize_t bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(strlen(TESTDATA2), bufsize);
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA2, bufsize));
+  mu_check(CRC32DATA2 == zip_entry_crc32(zip));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+
+  zip_close(zip);
+  UNLINK(COPYNAME);
+}
+
 MU_TEST(test_entry_offset) {
   struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
   mu_check(zip != NULL);
@@ -427,6 +726,10 @@ MU_TEST_SUITE(test_entry_suite) {
   MU_RUN_TEST(test_list_entries);
   MU_RUN_TEST(test_entries_deletebyindex);
   MU_RUN_TEST(test_entries_delete);
+  MU_RUN_TEST(test_entries_delete_large);
+  MU_RUN_TEST(test_entries_delete_zip64_offset);
+  MU_RUN_TEST(test_entries_unlink);
+  MU_RUN_TEST(test_entry_rawcopy);
   MU_RUN_TEST(test_entry_offset);
 }
 
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 #include <zip.h>
 
@@ -15,6 +16,10 @@
 #define UNLINK unlink
 #endif
 
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
 static char ZIPNAME[L_tmpnam + 1] = {0};
 
 #define TESTDATA1 "Some test data 1...\0"
@@ -181,12 +186,97 @@ MU_TEST(test_extract_cstream) {
   zip_cstream_close(zip);
 }
 
+static int on_extract_entry(const char *filename, void *arg) {
+  UNUSED(filename);
+  ++*(int *)arg;
+  return 0;
+}
+
+MU_TEST(test_extract_dirs) {
+  char buf[64] = {0};
+  int entries = 0;
+  FILE *fp = NULL;
+
+  mu_assert_int_eq(
+      0, zip_extract(ZIPNAME, "x-out/nested", on_extract_entry, &entries));
+  mu_assert_int_eq(5, entries);
+
+  if (!(fp = fopen("x-out/nested/test/test-2.txt", "rb"))) {
+    mu_fail("Cannot open extracted file\n");
+  }
+  mu_assert_int_eq(strlen(TESTDATA2), fread(buf, 1, sizeof(buf), fp));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf));
+  fclose(fp);
+
+  struct stat file_stat;
+  mu_assert_int_eq(0, stat("x-out/nested/test/empty", &file_stat));
+  mu_check(file_stat.st_mode & S_IFDIR);
+  mu_assert_int_eq(0, stat("x-out/nested/dotfiles/.test", &file_stat));
+  mu_assert_int_eq(strlen(TESTDATA2), file_stat.st_size);
+
+  remove("x-out/nested/test/test-1.txt");
+  remove("x-out/nested/test/test-2.txt");
+  remove("x-out/nested/test/empty");
+  remove("x-out/nested/test");
+  remove("x-out/nested/empty");
+  remove("x-out/nested/dotfiles/.test");
+  remove("x-out/nested/dotfiles");
+  remove("x-out/nested");
+  remove("x-out");
+}
+
+#if defined(__linux__)
+static int count_open_fds(void) {
+  int n = 0;
+  DIR *dir = opendir("/proc/self/fd");
+  if (!dir) {
+    return -1;
+  }
+  while (readdir(dir)) {
+    ++n;
+  }
+  closedir(dir);
+  return n;
+}
+
+MU_TEST(test_extract_failed_open) {
+  int pass, fds;
+
+  // a directory in place of test/test-1.txt makes its open fail, the files
+  // opened in the same batch must still be closed
+  for (pass = 0; pass < 2; ++pass) {
+    if (pass == 1) {
+      // the synchronous path, without io_uring
+      setenv("ZIP_NO_IO_URING", "1", 1);
+    }
+    mu_assert_int_eq(0, mkdir("x-fail", 0755));
+    mu_assert_int_eq(0, mkdir("x-fail/test", 0755));
+    mu_assert_int_eq(0, mkdir("x-fail/test/test-1.txt", 0755));
+    fds = count_open_fds();
+    mu_check(fds > 0);
+    mu_assert_int_eq(ZIP_ENOFILE, zip_extract(ZIPNAME, "x-fail", NULL, NULL));
+    mu_assert_int_eq(fds, count_open_fds());
+
+    remove("x-fail/test/test-1.txt");
+    remove("x-fail/test/test-2.txt");
+    remove("x-fail/test/empty");
+    remove("x-fail/test");
+    remove("x-fail");
+  }
+  unsetenv("ZIP_NO_IO_URING");
+}
+#endif
+
 MU_TEST_SUITE(test_extract_suite) {
   MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
 
   MU_RUN_TEST(test_extract);
   MU_RUN_TEST(test_extract_stream);
   MU_RUN_TEST(test_extract_cstream);
+  MU_RUN_TEST(test_extract_dirs);
+#if defined(__linux__)
+  MU_RUN_TEST(test_extract_failed_open);
+#endif
 }
 
 int main(int argc, char *argv[]) {
@@ -177,6 +177,13 @@ MU_TEST(test_mtime) {
   fprintf(stdout, "file_stat1.st_mtime: %lu\n", file_stat1.st_mtime);
   fprintf(stdout, "file_stat2.st_mtime: %lu\n", file_stat2.st_mtime);
   mu_check(labs(file_stat1.st_mtime - file_stat2.st_mtime) <= 1);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, filename));
+  mu_check(zip_entry_mtime(zip) == (long long)file_stat2.st_mtime);
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
 }
 
 MU_TEST_SUITE(test_permissions_suite) {
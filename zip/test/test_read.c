@@ -62,6 +62,12 @@ MU_TEST(test_read) {
   mu_assert_int_eq(0, zip_entry_open(zip, "test/test-1.txt"));
   mu_assert_int_eq(strlen(TESTDATA1), zip_entry_size(zip));
   mu_check(CRC32DATA1 == zip_entry_crc32(zip));
+  mu_check(CRC32DATA1 == zip_crc32(0, TESTDATA1, strlen(TESTDATA1)));
+  mu_check(CRC32DATA1 == zip_crc32(zip_crc32(0, TESTDATA1, 5), TESTDATA1 + 5,
+                                   strlen(TESTDATA1) - 5));
+  // the standard check value, long enough for the 8-byte path
+  mu_check(0xCBF43926u == zip_crc32(0, "123456789", 9));
+  mu_check(0xCBF43926u == zip_crc32(zip_crc32(0, "1", 1), "23456789", 8));
   bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
   mu_assert_int_eq(strlen(TESTDATA1), bufsize);
   mu_assert_int_eq((size_t)bufsize, buftmp);
@@ -178,12 +184,599 @@ MU_TEST(test_noallocreadwithoffset) {
   zip_close(zip);
 }
 
+MU_TEST(test_reader) {
+  char buf[3];
+  char out[64];
+  size_t total = 0;
+  ssize_t n;
+  int errnum = 0;
+  const void *chunk = NULL;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/test-1.txt"));
+  struct zip_reader_t *reader = zip_reader_open(zip, &errnum);
+  mu_check(reader != NULL);
+  mu_assert_int_eq(0, errnum);
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  while ((n = zip_reader_read(reader, buf, sizeof(buf))) > 0) {
+    mu_check(total + (size_t)n <= sizeof(out));
+    memcpy(out + total, buf, (size_t)n);
+    total += (size_t)n;
+  }
+  mu_assert_int_eq(0, n);
+  mu_assert_int_eq(strlen(TESTDATA1), total);
+  mu_assert_int_eq(0, strncmp(out, TESTDATA1, total));
+  zip_reader_close(reader);
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "dotfiles/.test"));
+  reader = zip_reader_open(zip, NULL);
+  mu_check(reader != NULL);
+  n = zip_reader_next(reader, &chunk);
+  mu_assert_int_eq(strlen(TESTDATA2), n);
+  mu_assert_int_eq(0, strncmp(chunk, TESTDATA2, (size_t)n));
+  mu_assert_int_eq(0, zip_reader_next(reader, &chunk));
+  zip_reader_close(reader);
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  mu_check(zip_reader_open(zip, &errnum) == NULL);
+  mu_assert_int_eq(ZIP_ENOENT, errnum);
+
+  zip_close(zip);
+}
+
+static size_t on_cursor_extract(void *arg, uint64_t offset, const void *data,
+                                size_t size) {
+  memcpy((char *)arg + offset, data, size);
+  return size;
+}
+
+MU_TEST(test_cursor) {
+  char buf1[64] = {0};
+  char buf2[64] = {0};
+  int errnum = 0;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  struct zip_cursor_t *c1 = zip_cursor_open(zip, &errnum);
+  mu_check(c1 != NULL);
+  mu_assert_int_eq(0, errnum);
+  struct zip_cursor_t *c2 = zip_cursor_open(zip, NULL);
+  mu_check(c2 != NULL);
+
+  // both cursors stay usable while interleaved with the archive's own entry
+  mu_assert_int_eq(0, zip_cursor_entry_open(c1, "TEST/Test-1.txt"));
+  mu_assert_int_eq(ZIP_ENOENT,
+                   zip_cursor_entry_opencasesensitive(c2, "TEST/Test-1.txt"));
+  mu_assert_int_eq(0, zip_cursor_entry_opencasesensitive(c2, "dotfiles/.test"));
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/test-2.txt"));
+
+  mu_assert_int_eq(0, strcmp("test/test-1.txt", zip_cursor_entry_name(c1)));
+  mu_assert_int_eq(0, zip_cursor_entry_index(c1));
+  mu_assert_int_eq(0, zip_cursor_entry_isdir(c1));
+  mu_assert_int_eq(strlen(TESTDATA1), zip_cursor_entry_size(c1));
+  mu_check(CRC32DATA1 == zip_cursor_entry_crc32(c1));
+
+  mu_assert_int_eq(strlen(TESTDATA1),
+                   zip_cursor_entry_noallocread(c1, buf1, sizeof(buf1)));
+  mu_assert_int_eq(0, zip_cursor_entry_extract(c2, on_cursor_extract, buf2));
+  mu_assert_int_eq(0, strcmp(TESTDATA1, buf1));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf2));
+  mu_assert_int_eq(ZIP_EMEMNOALLOC, zip_cursor_entry_noallocread(c2, buf2, 3));
+
+  memset(buf1, 0, sizeof(buf1));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_entry_noallocread(zip, buf1, sizeof(buf1)));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf1));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  mu_assert_int_eq(0, zip_cursor_entry_open(c1, "empty/"));
+  mu_assert_int_eq(1, zip_cursor_entry_isdir(c1));
+  mu_assert_int_eq(ZIP_EINVENTTYPE,
+                   zip_cursor_entry_noallocread(c1, buf1, sizeof(buf1)));
+  mu_assert_int_eq(ZIP_EINVIDX, zip_cursor_entry_openbyindex(c1, 100));
+  mu_assert_int_eq(ZIP_ENOENT, zip_cursor_entry_open(c1, "missing"));
+  mu_check(zip_cursor_entry_name(c1) == NULL);
+
+  zip_cursor_close(c1);
+  zip_cursor_close(c2);
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'a');
+  mu_check(zip_cursor_open(zip, &errnum) == NULL);
+  mu_assert_int_eq(ZIP_EINVMODE, errnum);
+  zip_close(zip);
+}
+
+MU_TEST(test_cursor_rawextract) {
+  char raw[64] = {0};
+  char buf[64] = {0};
+  char rawname[L_tmpnam + 1] = {0};
+  unsigned long long comp_size = 0;
+  unsigned int crc = 0;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  struct zip_cursor_t *cursor = zip_cursor_open(zip, NULL);
+  mu_check(cursor != NULL);
+
+  mu_assert_int_eq(0, zip_cursor_entry_open(cursor, "test/test-1.txt"));
+  comp_size = zip_cursor_entry_comp_size(cursor);
+  crc = zip_cursor_entry_crc32(cursor);
+  mu_check(comp_size > 0 && comp_size <= sizeof(raw));
+  mu_assert_int_eq(0,
+                   zip_cursor_entry_rawextract(cursor, on_cursor_extract, raw));
+  mu_assert_int_eq(0, zip_cursor_entry_open(cursor, "empty/"));
+  mu_assert_int_eq(ZIP_EINVENTTYPE,
+                   zip_cursor_entry_rawextract(cursor, on_cursor_extract, raw));
+  zip_cursor_close(cursor);
+  zip_close(zip);
+
+  // the raw deflate stream is a complete entry on its own
+  strncpy(rawname, "z-XXXXXX\0", L_tmpnam);
+  MKTEMP(rawname);
+  zip = zip_open(rawname, ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "raw.txt"));
+  mu_assert_int_eq(0, zip_entry_rawwrite(zip, raw, (size_t)comp_size, 8,
+                                         strlen(TESTDATA1), crc));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(rawname, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "raw.txt"));
+  mu_assert_int_eq(strlen(TESTDATA1),
+                   zip_entry_noallocread(zip, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA1, buf));
+  zip_entry_close(zip);
+  zip_close(zip);
+  remove(rawname);
+}
+
+MU_TEST(test_cursor_stream) {
+  char buf[64] = {0};
+  size_t size;
+  char *stream = NULL;
+
+  FILE *fp = fopen(ZIPNAME, "rb");
+  mu_check(fp != NULL);
+  fseek(fp, 0, SEEK_END);
+  size = (size_t)ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  stream = (char *)malloc(size);
+  mu_assert_int_eq(size, fread(stream, 1, size, fp));
+  fclose(fp);
+
+  struct zip_t *zip = zip_stream_open(stream, size, 0, 'r');
+  mu_check(zip != NULL);
+  struct zip_cursor_t *cursor = zip_cursor_open(zip, NULL);
+  mu_check(cursor != NULL);
+
+  mu_assert_int_eq(0, zip_cursor_entry_openbyindex(cursor, 1));
+  mu_assert_int_eq(0, strcmp("test/test-2.txt", zip_cursor_entry_name(cursor)));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_cursor_entry_noallocread(cursor, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf));
+
+  zip_cursor_close(cursor);
+  zip_stream_close(zip);
+  free(stream);
+}
+
+struct prefix_result {
+  char names[8][32];
+  size_t count;
+  size_t stop_after;
+};
+
+static int on_prefix_entry(void *arg, size_t index, const char *name,
+                           size_t namelen) {
+  struct prefix_result *result = (struct prefix_result *)arg;
+  (void)index;
+  memcpy(result->names[result->count], name, namelen);
+  result->names[result->count][namelen] = '\0';
+  return ++result->count == result->stop_after;
+}
+
+MU_TEST(test_entries_prefix) {
+  struct prefix_result result;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  memset(&result, 0, sizeof(result));
+  mu_assert_int_eq(3, zip_entries_prefix(zip, "test/", on_prefix_entry,
+                                         &result));
+  mu_assert_int_eq(0, strcmp("test/empty/", result.names[0]));
+  mu_assert_int_eq(0, strcmp("test/test-1.txt", result.names[1]));
+  mu_assert_int_eq(0, strcmp("test/test-2.txt", result.names[2]));
+
+  memset(&result, 0, sizeof(result));
+  mu_assert_int_eq(5, zip_entries_prefix(zip, "", on_prefix_entry, &result));
+  mu_assert_int_eq(0, strcmp("dotfiles/.test", result.names[0]));
+
+  memset(&result, 0, sizeof(result));
+  result.stop_after = 1;
+  mu_assert_int_eq(1, zip_entries_prefix(zip, "test/t", on_prefix_entry,
+                                         &result));
+  mu_assert_int_eq(0, strcmp("test/test-1.txt", result.names[0]));
+
+  mu_assert_int_eq(0, zip_entries_prefix(zip, "zzz", on_prefix_entry,
+                                         &result));
+  mu_assert_int_eq(0, zip_entries_prefix(zip, "Test/", on_prefix_entry,
+                                         &result));
+  zip_close(zip);
+}
+
+struct foreach_result {
+  struct zip_t *zip;
+  size_t count;
+  int mismatches;
+};
+
+static int on_foreach_entry(void *arg, const struct zip_entry_info_t *info) {
+  struct foreach_result *result = (struct foreach_result *)arg;
+  struct zip_t *zip = result->zip;
+
+  if (zip_entry_openbyindex(zip, info->index) != 0 ||
+      strlen(zip_entry_name(zip)) != info->namelen ||
+      strncmp(zip_entry_name(zip), info->name, info->namelen) != 0 ||
+      zip_entry_isdir(zip) != info->isdir ||
+      zip_entry_crc32(zip) != info->crc32 ||
+      zip_entry_size(zip) != info->uncomp_size ||
+      zip_entry_comp_size(zip) != info->comp_size ||
+      zip_entry_header_offset(zip) != info->header_offset ||
+      zip_entry_method(zip) != info->method) {
+    ++result->mismatches;
+  }
+  zip_entry_close(zip);
+  ++result->count;
+  return 0;
+}
+
+static int on_foreach_stop(void *arg, const struct zip_entry_info_t *info) {
+  (void)arg;
+  return info->index == 1;
+}
+
+MU_TEST(test_entries_foreach) {
+  struct foreach_result result = {NULL, 0, 0};
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  result.zip = zip;
+
+  mu_assert_int_eq(5, zip_entries_foreach(zip, on_foreach_entry, &result));
+  mu_assert_int_eq(5, result.count);
+  mu_assert_int_eq(0, result.mismatches);
+  mu_assert_int_eq(2, zip_entries_foreach(zip, on_foreach_stop, NULL));
+  mu_assert_int_eq(ZIP_EINVAL, zip_entries_foreach(zip, NULL, NULL));
+  zip_close(zip);
+}
+
+MU_TEST(test_rawoffset) {
+  char buf[64] = {0};
+  char storedname[L_tmpnam + 1] = {0};
+  unsigned long long offset = 0;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/test-1.txt"));
+  mu_assert_int_eq(8, zip_entry_method(zip));
+  mu_assert_int_eq(ZIP_EINVENTTYPE, zip_entry_rawoffset(zip, &offset));
+  zip_entry_close(zip);
+  zip_close(zip);
+
+  strncpy(storedname, "z-XXXXXX\0", L_tmpnam);
+  MKTEMP(storedname);
+  zip = zip_open(storedname, 0, 'w');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "stored.txt"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(storedname, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "stored.txt"));
+  mu_assert_int_eq(0, zip_entry_method(zip));
+  mu_assert_int_eq(0, zip_entry_rawoffset(zip, &offset));
+  mu_assert_int_eq(strlen(TESTDATA1), zip_entry_comp_size(zip));
+  zip_entry_close(zip);
+  zip_close(zip);
+
+  FILE *fp = fopen(storedname, "rb");
+  mu_check(fp != NULL);
+  fseek(fp, (long)offset, SEEK_SET);
+  mu_assert_int_eq(strlen(TESTDATA1), fread(buf, 1, strlen(TESTDATA1), fp));
+  fclose(fp);
+  mu_assert_int_eq(0, strcmp(TESTDATA1, buf));
+  remove(storedname);
+}
+
+// Overwrites n little-endian 32-bit values of an index file with value.
+static int patch_dirindex(const char *indexname, long offset, unsigned value,
+                          int n) {
+  unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8),
+                            (unsigned char)(value >> 16),
+                            (unsigned char)(value >> 24)};
+  FILE *fp = fopen(indexname, "r+b");
+  int i, err = 0;
+  if (!fp) {
+    return -1;
+  }
+  if (fseek(fp, offset, SEEK_SET) != 0) {
+    err = -1;
+  }
+  for (i = 0; i < n && !err; ++i) {
+    if (fwrite(bytes, 1, sizeof(bytes), fp) != sizeof(bytes)) {
+      err = -1;
+    }
+  }
+  fclose(fp);
+  return err;
+}
+
+MU_TEST(test_dirindex) {
+  char indexname[L_tmpnam + 8] = {0};
+  char buf[64] = {0};
+
+  snprintf(indexname, sizeof(indexname), "%s.zidx", ZIPNAME);
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_dirindex_save(zip, indexname));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(5, zip_entries_total(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "TEST/TEST-1.TXT"));
+  mu_assert_int_eq(0, zip_entry_index(zip));
+  mu_assert_int_eq(strlen(TESTDATA1),
+                   zip_entry_noallocread(zip, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA1, buf));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  mu_assert_int_eq(ZIP_ENOENT,
+                   zip_entry_opencasesensitive(zip, "TEST/TEST-1.TXT"));
+  mu_assert_int_eq(0, zip_entry_opencasesensitive(zip, "dotfiles/.test"));
+  mu_assert_int_eq(4, zip_entry_index(zip));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  struct zip_cursor_t *cursor = zip_cursor_open(zip, NULL);
+  mu_check(cursor != NULL);
+  memset(buf, 0, sizeof(buf));
+  mu_assert_int_eq(0, zip_cursor_entry_open(cursor, "test/test-2.txt"));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_cursor_entry_noallocread(cursor, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf));
+  zip_cursor_close(cursor);
+  zip_close(zip);
+
+  // a corrupt index is ignored and the archive is parsed as usual
+  mu_assert_int_eq(0, patch_dirindex(indexname, 56, 1, 5));
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_openbyindex(zip, 0));
+  mu_assert_int_eq(0, strcmp("test/test-1.txt", zip_entry_name(zip)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_dirindex_save(zip, indexname));
+  zip_close(zip);
+  // every slot taken by the first entry would never end a probe
+  mu_assert_int_eq(0, patch_dirindex(indexname, 56 + 4 * 5, 1, 16));
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_ENOENT, zip_entry_open(zip, "missing"));
+  mu_assert_int_eq(0, zip_entry_open(zip, "dotfiles/.test"));
+  mu_assert_int_eq(4, zip_entry_index(zip));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  // the index no longer matches once the archive changes
+  zip = zip_open(ZIPNAME, ZIP_DEFAULT_COMPRESSION_LEVEL, 'a');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVMODE, zip_dirindex_save(zip, indexname));
+  mu_assert_int_eq(0, zip_entry_open(zip, "new.txt"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(6, zip_entries_total(zip));
+  mu_assert_int_eq(0, zip_entry_open(zip, "new.txt"));
+  mu_assert_int_eq(5, zip_entry_index(zip));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+  remove(indexname);
+}
+
+struct openinfo_result {
+  struct zip_cursor_t *cursor;
+  size_t bytes;
+  int errors;
+};
+
+static int on_foreach_openinfo(void *arg,
+                               const struct zip_entry_info_t *info) {
+  struct openinfo_result *result = (struct openinfo_result *)arg;
+  char buf[64] = {0};
+  ssize_t n = 0;
+
+  if (zip_cursor_entry_openinfo(result->cursor, info) < 0 ||
+      zip_cursor_entry_index(result->cursor) != (ssize_t)info->index) {
+    ++result->errors;
+    return 0;
+  }
+  if (!info->isdir) {
+    n = zip_cursor_entry_noallocread(result->cursor, buf, sizeof(buf));
+    if (n < 0 || (unsigned long long)n != info->uncomp_size) {
+      ++result->errors;
+    } else {
+      result->bytes += (size_t)n;
+    }
+  }
+  zip_cursor_entry_close(result->cursor);
+  return 0;
+}
+
+MU_TEST(test_streamed_dir) {
+  struct prefix_result result;
+  char buf[64] = {0};
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 's');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(5, zip_entries_total(zip));
+  mu_assert_int_eq(2, zip_entries_foreach(zip, on_foreach_stop, NULL));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entry_open(zip, "test/test-1.txt"));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entry_openbyindex(zip, 0));
+
+  // scanned in central directory order
+  memset(&result, 0, sizeof(result));
+  mu_assert_int_eq(3, zip_entries_prefix(zip, "test/", on_prefix_entry,
+                                         &result));
+  mu_assert_int_eq(0, strcmp("test/test-1.txt", result.names[0]));
+  mu_assert_int_eq(0, strcmp("test/test-2.txt", result.names[1]));
+  mu_assert_int_eq(0, strcmp("test/empty/", result.names[2]));
+
+  struct zip_cursor_t *cursor = zip_cursor_open(zip, NULL);
+  mu_check(cursor != NULL);
+  mu_assert_int_eq(0, zip_cursor_entry_open(cursor, "TEST/TEST-2.TXT"));
+  mu_assert_int_eq(1, zip_cursor_entry_index(cursor));
+  mu_assert_int_eq(0, strcmp("test/test-2.txt", zip_cursor_entry_name(cursor)));
+  mu_assert_int_eq(strlen(TESTDATA2),
+                   zip_cursor_entry_noallocread(cursor, buf, sizeof(buf)));
+  mu_assert_int_eq(0, strcmp(TESTDATA2, buf));
+  mu_assert_int_eq(ZIP_ENOENT, zip_cursor_entry_opencasesensitive(
+                                   cursor, "TEST/TEST-2.TXT"));
+  mu_assert_int_eq(0, zip_cursor_entry_openbyindex(cursor, 4));
+  mu_assert_int_eq(0, strcmp("dotfiles/.test", zip_cursor_entry_name(cursor)));
+  mu_check(CRC32DATA2 == zip_cursor_entry_crc32(cursor));
+  mu_assert_int_eq(ZIP_EINVIDX, zip_cursor_entry_openbyindex(cursor, 5));
+
+  // entries enumerated once are opened without another scan
+  struct openinfo_result opened = {cursor, 0, 0};
+  mu_assert_int_eq(5, zip_entries_foreach(zip, on_foreach_openinfo, &opened));
+  mu_assert_int_eq(0, opened.errors);
+  mu_assert_int_eq(strlen(TESTDATA1) + 2 * strlen(TESTDATA2), opened.bytes);
+  zip_cursor_close(cursor);
+  zip_close(zip);
+}
+
+MU_TEST(test_entries_layout) {
+  const char *names[] = {"test/test-1.txt", "empty/", "missing.txt",
+                         "dotfiles/.test"};
+  struct zip_entry_span_t spans[4];
+  char *arena = NULL;
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  ssize_t size = zip_entries_layout(zip, names, spans, 4);
+  mu_assert_int_eq(strlen(TESTDATA1) + strlen(TESTDATA2), size);
+  mu_assert_int_eq(0, spans[0].err);
+  mu_assert_int_eq(0, spans[0].index);
+  mu_assert_int_eq(0, spans[0].offset);
+  mu_assert_int_eq(ZIP_EINVENTTYPE, spans[1].err);
+  mu_assert_int_eq(ZIP_ENOENT, spans[2].err);
+  mu_assert_int_eq(0, spans[3].err);
+  mu_assert_int_eq(4, spans[3].index);
+  mu_assert_int_eq(strlen(TESTDATA1), spans[3].offset);
+
+  arena = (char *)malloc((size_t)size);
+  mu_check(arena != NULL);
+  // each cursor fills its own range of the spans
+  struct zip_cursor_t *first = zip_cursor_open(zip, NULL);
+  struct zip_cursor_t *second = zip_cursor_open(zip, NULL);
+  mu_check(first != NULL && second != NULL);
+  mu_assert_int_eq(1, zip_cursor_entries_read(first, spans, 2, arena));
+  mu_assert_int_eq(1, zip_cursor_entries_read(second, spans + 2, 2, arena));
+  mu_assert_int_eq(0, strncmp(TESTDATA1, arena + spans[0].offset,
+                              spans[0].size));
+  mu_assert_int_eq(0, strncmp(TESTDATA2, arena + spans[3].offset,
+                              spans[3].size));
+  zip_cursor_close(first);
+  zip_cursor_close(second);
+
+  // by index, out of range indices are reported per span
+  spans[0].index = 1;
+  spans[1].index = 5;
+  mu_assert_int_eq(strlen(TESTDATA2), zip_entries_layout(zip, NULL, spans, 2));
+  mu_assert_int_eq(0, spans[0].err);
+  mu_assert_int_eq(ZIP_EINVIDX, spans[1].err);
+  free(arena);
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 's');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entries_layout(zip, names, spans, 4));
+  zip_close(zip);
+}
+
+// bit at a time, the same polynomial as the byte-wise mz_crc32
+static unsigned int crc32_bitwise(unsigned int crc, const unsigned char *p,
+                                  size_t n) {
+  int k;
+
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (k = 0; k < 8; ++k) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0);
+    }
+  }
+  return ~crc;
+}
+
+MU_TEST(test_crc32) {
+  unsigned char buf[4096 + 8];
+  unsigned int seed = 1, crc;
+  size_t i, offset, len, split;
+
+  for (i = 0; i < sizeof(buf); ++i) {
+    seed = seed * 1103515245u + 12345u;
+    buf[i] = (unsigned char)(seed >> 16);
+  }
+  // every start alignment, with lengths around the 8-byte blocks
+  for (offset = 0; offset < 8; ++offset) {
+    for (len = 0; len <= 67; ++len) {
+      mu_check(crc32_bitwise(0, buf + offset, len) ==
+               zip_crc32(0, buf + offset, len));
+    }
+    mu_check(crc32_bitwise(0, buf + offset, 4096) ==
+             zip_crc32(0, buf + offset, 4096));
+  }
+  // continuing from an unaligned split gives the one-shot value
+  crc = zip_crc32(0, buf, 4096);
+  for (split = 1; split < 16; ++split) {
+    mu_check(crc == zip_crc32(zip_crc32(0, buf, split), buf + split,
+                              4096 - split));
+  }
+  mu_check(0 == zip_crc32(7, NULL, 10));
+}
+
 MU_TEST_SUITE(test_read_suite) {
   MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
 
   MU_RUN_TEST(test_read);
   MU_RUN_TEST(test_noallocread);
   MU_RUN_TEST(test_noallocreadwithoffset);
+  MU_RUN_TEST(test_reader);
+  MU_RUN_TEST(test_cursor);
+  MU_RUN_TEST(test_cursor_rawextract);
+  MU_RUN_TEST(test_cursor_stream);
+  MU_RUN_TEST(test_entries_prefix);
+  MU_RUN_TEST(test_rawoffset);
+  MU_RUN_TEST(test_entries_foreach);
+  MU_RUN_TEST(test_dirindex);
+  MU_RUN_TEST(test_streamed_dir);
+  MU_RUN_TEST(test_entries_layout);
+  MU_RUN_TEST(test_crc32);
 }
 
 #define UNUSED(x) (void)x
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zip.h>
+
+#include "minunit.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+
+#define MKTEMP _mktemp
+#else
+#define MKTEMP mkstemp
+#endif
+
+static char ZIPNAME[L_tmpnam + 1] = {0};
+static char IDXNAME[L_tmpnam + 1] = {0};
+
+#define DATASIZE (3 * 1024 * 1024 + 123)
+#define SPAN (64 * 1024)
+
+static char *data = NULL;
+
+static void fill_data(void) {
+  static const char *const words[] = {"zip ", "entry ", "deflate ", "seek ",
+                                      "index ", "window ", "\n"};
+  unsigned int seed = 12345;
+  size_t i = 0;
+
+  data = (char *)malloc(DATASIZE);
+  while (i < DATASIZE) {
+    const char *w;
+    seed = seed * 1103515245 + 12345;
+    w = words[(seed >> 16) % 7];
+    while (*w && i < DATASIZE) {
+      data[i++] = *w++;
+    }
+  }
+}
+
+void test_setup(void) {
+  strncpy(ZIPNAME, "z-XXXXXX\0", L_tmpnam);
+  MKTEMP(ZIPNAME);
+  strncpy(IDXNAME, "x-XXXXXX\0", L_tmpnam);
+  MKTEMP(IDXNAME);
+
+  fill_data();
+
+  struct zip_t *zip = zip_open(ZIPNAME, ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
+
+  zip_entry_open(zip, "small.txt");
+  zip_entry_write(zip, data, 100);
+  zip_entry_close(zip);
+
+  zip_entry_open(zip, "big.txt");
+  zip_entry_write(zip, data, DATASIZE);
+  zip_entry_close(zip);
+
+  zip_close(zip);
+}
+
+void test_teardown(void) {
+  remove(ZIPNAME);
+  remove(IDXNAME);
+  free(data);
+  data = NULL;
+}
+
+static void check_reads(struct zip_t *zip) {
+  char buf[5000];
+  size_t offsets[] = {0,        1,          SPAN - 1,     SPAN,
+                      SPAN + 7, 1000000,    DATASIZE / 2, DATASIZE - 4096,
+                      DATASIZE - 1};
+  size_t i;
+
+  for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+    size_t expected = DATASIZE - offsets[i];
+    ssize_t n;
+    if (expected > sizeof(buf)) {
+      expected = sizeof(buf);
+    }
+    n = zip_entry_noallocreadwithoffset(zip, offsets[i], sizeof(buf), buf);
+    mu_assert_int_eq(expected, (size_t)n);
+    mu_assert_int_eq(0, memcmp(buf, data + offsets[i], expected));
+  }
+}
+
+MU_TEST(test_seekindex_read) {
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "big.txt"));
+  check_reads(zip);
+  mu_assert_int_eq(0, zip_entry_seekindex(zip, SPAN));
+  check_reads(zip);
+  mu_assert_int_eq(0, zip_seekindex_save(zip, IDXNAME));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  zip_close(zip);
+}
+
+MU_TEST(test_seekindex_load) {
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "big.txt"));
+  mu_assert_int_eq(0, zip_entry_seekindex(zip, SPAN));
+  mu_assert_int_eq(0, zip_seekindex_save(zip, IDXNAME));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_seekindex_load(zip, IDXNAME));
+  mu_assert_int_eq(0, zip_entry_open(zip, "big.txt"));
+  check_reads(zip);
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+}
+
+MU_TEST(test_seekindex_invalid) {
+  FILE *fp = fopen(IDXNAME, "wb");
+  mu_check(fp != NULL);
+  fwrite("not an index", 1, 12, fp);
+  fclose(fp);
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVIDXFILE, zip_seekindex_load(zip, IDXNAME));
+  mu_assert_int_eq(ZIP_EOPNFILE, zip_seekindex_load(zip, "missing.zsix"));
+  zip_close(zip);
+}
+
+// flips one byte of the sidecar, whence as for fseek
+static int corrupt_index(long offset, int whence) {
+  FILE *fp = fopen(IDXNAME, "r+b");
+  int c;
+  if (!fp) {
+    return -1;
+  }
+  if (fseek(fp, offset, whence) != 0 || (c = fgetc(fp)) == EOF ||
+      fseek(fp, -1, SEEK_CUR) != 0 || fputc(c ^ 0x5a, fp) == EOF) {
+    fclose(fp);
+    return -1;
+  }
+  return fclose(fp);
+}
+
+MU_TEST(test_seekindex_corrupt) {
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "big.txt"));
+  mu_assert_int_eq(0, zip_entry_seekindex(zip, SPAN));
+  mu_assert_int_eq(0, zip_seekindex_save(zip, IDXNAME));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  // a damaged window in the last checkpoint
+  mu_assert_int_eq(0, corrupt_index(-100, SEEK_END));
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVIDXFILE, zip_seekindex_load(zip, IDXNAME));
+  // nothing was loaded, reads inflate from the start of the entry
+  mu_assert_int_eq(0, zip_entry_open(zip, "big.txt"));
+  check_reads(zip);
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  // a sidecar written by another miniz version
+  mu_assert_int_eq(0, corrupt_index(-100, SEEK_END));
+  mu_assert_int_eq(0, corrupt_index(8, SEEK_SET));
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVIDXFILE, zip_seekindex_load(zip, IDXNAME));
+  zip_close(zip);
+}
+
+MU_TEST_SUITE(test_seekindex_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+
+  MU_RUN_TEST(test_seekindex_read);
+  MU_RUN_TEST(test_seekindex_load);
+  MU_RUN_TEST(test_seekindex_invalid);
+  MU_RUN_TEST(test_seekindex_corrupt);
+}
+
+#define UNUSED(x) (void)x
+
+int main(int argc, char *argv[]) {
+  UNUSED(argc);
+  UNUSED(argv);
+
+  MU_RUN_SUITE(test_seekindex_suite);
+  MU_REPORT();
+  return MU_EXIT_CODE;
+}
@@ -95,12 +95,98 @@ MU_TEST(test_fwrite) {
   zip_close(zip);
 }
 
+MU_TEST(test_rawwrite) {
+  size_t comp_size = 0;
+  void *comp = zip_deflate_mem(TESTDATA1, strlen(TESTDATA1), 9, &comp_size);
+  mu_check(comp != NULL);
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'w');
+  mu_check(zip != NULL);
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/raw.txt"));
+  mu_assert_int_eq(0, zip_entry_set_mtime(zip, 1700000000));
+  // split into two chunks
+  mu_assert_int_eq(0, zip_entry_rawwrite(zip, comp, 4, 8, 0, 0));
+  mu_assert_int_eq(0, zip_entry_rawwrite(zip, (char *)comp + 4, comp_size - 4,
+                                         8, strlen(TESTDATA1), CRC32DATA1));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entry_write(zip, "x", 1));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/stored.txt"));
+  mu_assert_int_eq(0, zip_entry_write(zip, "x", 1));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_entry_rawwrite(zip, "y", 1, 0, 1, 0));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+  free(comp);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "test/raw.txt"));
+  mu_assert_int_eq(8, zip_entry_method(zip));
+  mu_assert_int_eq(1700000000, zip_entry_mtime(zip));
+  size_t buftmp = 0;
+  char *buf = NULL;
+  ssize_t bufsize = zip_entry_read(zip, (void **)&buf, &buftmp);
+  mu_assert_int_eq(strlen(TESTDATA1), bufsize);
+  mu_assert_int_eq(0, strncmp(buf, TESTDATA1, bufsize));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  free(buf);
+  zip_close(zip);
+}
+
+MU_TEST(test_write_alignment) {
+  unsigned long long offset = 0;
+  char buf[64] = {0};
+
+  struct zip_t *zip = zip_open(ZIPNAME, 0, 'w');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(ZIP_EINVAL, zip_set_alignment(zip, 3));
+  mu_assert_int_eq(ZIP_EINVAL, zip_set_alignment(zip, 65536));
+  mu_assert_int_eq(0, zip_set_alignment(zip, 4096));
+
+  mu_assert_int_eq(0, zip_entry_open(zip, "a.bin"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(ZIP_EINVMODE, zip_set_level(zip, 6));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  mu_assert_int_eq(0, zip_set_level(zip, 6));
+  mu_assert_int_eq(0, zip_entry_open(zip, "deflated.txt"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  mu_assert_int_eq(0, zip_set_level(zip, 0));
+  mu_assert_int_eq(0, zip_entry_open(zip, "model/weights.bin"));
+  mu_assert_int_eq(0, zip_entry_write(zip, TESTDATA1, strlen(TESTDATA1)));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+  zip_close(zip);
+
+  zip = zip_open(ZIPNAME, 0, 'r');
+  mu_check(zip != NULL);
+  mu_assert_int_eq(0, zip_entry_open(zip, "deflated.txt"));
+  mu_assert_int_eq(8, zip_entry_method(zip));
+  mu_assert_int_eq(0, zip_entry_close(zip));
+
+  const char *stored[] = {"a.bin", "model/weights.bin"};
+  for (size_t i = 0; i < 2; ++i) {
+    mu_assert_int_eq(0, zip_entry_open(zip, stored[i]));
+    mu_assert_int_eq(0, zip_entry_rawoffset(zip, &offset));
+    mu_assert_int_eq(0, offset % 4096);
+    mu_assert_int_eq(strlen(TESTDATA1),
+                     zip_entry_noallocread(zip, buf, sizeof(buf)));
+    mu_assert_int_eq(0, strcmp(TESTDATA1, buf));
+    mu_assert_int_eq(0, zip_entry_close(zip));
+  }
+  zip_close(zip);
+}
+
 MU_TEST_SUITE(test_write_suite) {
   MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
 
   MU_RUN_TEST(test_write);
   MU_RUN_TEST(test_write_utf);
   MU_RUN_TEST(test_fwrite);
+  MU_RUN_TEST(test_rawwrite);
+  MU_RUN_TEST(test_write_alignment);
 }
 
 #define UNUSED(x) (void)x